@@ -425,16 +425,37 @@ const EVAL_TYPE_BOOLEAN = new EvalTypeBuiltIn("boolean", false);
 const EVAL_TYPE_TEXT = new EvalTypeBuiltIn("text", true);
 const EVAL_TYPE_CHAR = new EvalTypeName("char", EVAL_TYPE_INTEGER);
 
+// the peephole passes stop there even if they could still find something
+const PEEPHOLE_MAX_PASSES = 16;
+
 class CodeBlock {
 
-	constructor(blockName) {
+	constructor(blockName, isGlobalCode) {
 		this.blockName = blockName;
+		// the global code runs with bp at 0, its locals are slots of the globals
+		this.isGlobalCode = isGlobalCode;
 		this.codes = [];
 		this.codeSize = 0;
 		this.strConsts = [];
 		this.strConstSize = 0;
 		this.floatConsts = [];
 		this.floatConstSize = 0;
+		// offsets of the last two instructions and of the last jump target,
+		// an instruction can only be fused with the previous ones if no jump
+		// lands in between
+		this.lastOpLoc = -1;
+		this.prevOpLoc = -1;
+		this.labelLoc = 0;
+		// instructions before and after the peephole passes
+		this.emittedOpCount = 0;
+		this.optimizedOpCount = 0;
+		// reads turned into moves and borrows
+		this.moveCount = 0;
+		this.borrowCount = 0;
+		// instructions pushing the first value of a local, as {loc, offset}
+		this.slotStarts = [];
+		// offsets of the globals that the code of other blocks can read
+		this.sharedSlots = [];
 	}
 	
 	addStrConst(str) {
@@ -463,20 +484,707 @@ class CodeBlock {
 
 	setLoc(offset) {
 		this.codes[offset] = this.codeSize;
+		this.labelLoc = this.codeSize;
+	}
+	
+	getLoc() {
+		this.labelLoc = this.codeSize;
+		return this.codeSize;
+	}
+	
+	canFuse(opLoc) {
+		return opLoc !== -1 && this.labelLoc <= opLoc;
+	}
+	
+	lastOpIs(inst) {
+		return this.canFuse(this.lastOpLoc) && this.codes[this.lastOpLoc] === inst;
+	}
+	
+	// remove the last instruction so that it can be replaced by a fused one
+	dropLastOp() {
+		this.codeSize = this.lastOpLoc;
+		this.lastOpLoc = this.prevOpLoc;
+		this.prevOpLoc = -1;
+	}
+	
+	startOp() {
+		this.prevOpLoc = this.lastOpLoc;
+		this.lastOpLoc = this.codeSize;
+	}
+	
+	// code that can never run is still compiled to report its errors, the mark
+	// stops the fusions with the live code so that it can be dropped exactly
+	startDeadCode() {
+		let mark = {codeSize: this.codeSize, lastOpLoc: this.lastOpLoc, prevOpLoc: this.prevOpLoc, labelLoc: this.labelLoc};
+		this.labelLoc = this.codeSize;
+		return mark;
+	}
+	
+	dropDeadCode(mark) {
+		while (this.slotStarts.length > 0 && this.slotStarts[this.slotStarts.length - 1].loc >= mark.codeSize) {
+			this.slotStarts.length--;
+		}
+		this.codeSize = mark.codeSize;
+		this.lastOpLoc = mark.lastOpLoc;
+		this.prevOpLoc = mark.prevOpLoc;
+		this.labelLoc = mark.labelLoc;
+	}
+	
+	// a condition known at compile time is removed, returns its value or -1 if it is not known
+	dropConstCondition() {
+		if (!this.lastOpIs(OPCODE_PUSH)) {
+			return -1;
+		}
+		let val = this.codes[this.lastOpLoc + 1];
+		this.dropLastOp();
+		return val;
+	}
+	
+	lastOpIsPushOf(val) {
+		return this.lastOpIs(OPCODE_PUSH) && this.codes[this.lastOpLoc + 1] === val;
+	}
+	
+	// replaces the two pushed operands of an integer or boolean operator by its result,
+	// only when it is exact, so that both vms compute the same value
+	foldInt(op) {
+		if (!this.lastOpIs(OPCODE_PUSH) || !this.canFuse(this.prevOpLoc) || this.codes[this.prevOpLoc] !== OPCODE_PUSH) {
+			return false;
+		}
+		let val1 = this.codes[this.prevOpLoc + 1];
+		let val2 = this.codes[this.lastOpLoc + 1];
+		let val = op(val1, val2);
+		if (!Number.isSafeInteger(val1) || !Number.isSafeInteger(val2) || !Number.isSafeInteger(val)) {
+			return false;
+		}
+		this.dropLastOp();
+		this.dropLastOp();
+		this.codePush(val === 0 ? 0 : val);
+		return true;
+	}
+	
+	// same for the real operators, a comparison pushes a boolean, -0 and the
+	// infinities are left to the vm as they have no constant
+	foldFloat(op, isComparison) {
+		if (!this.lastOpIs(OPCODE_PUSHF) || !this.canFuse(this.prevOpLoc) || this.codes[this.prevOpLoc] !== OPCODE_PUSHF) {
+			return false;
+		}
+		let val = op(this.floatConsts[this.codes[this.prevOpLoc + 1]], this.floatConsts[this.codes[this.lastOpLoc + 1]]);
+		if (!isComparison && (!Number.isFinite(val) || Object.is(val, -0))) {
+			return false;
+		}
+		this.dropLastOp();
+		this.dropLastOp();
+		if (isComparison) {
+			this.codePush(val ? 1 : 0);
+		} else {
+			this.codePushf(this.addFloatConst(val));
+		}
+		return true;
+	}
+	
+	// 'a' || 'b'
+	foldConcat() {
+		if (!this.lastOpIs(OPCODE_CREATE_STRING) || !this.canFuse(this.prevOpLoc) || this.codes[this.prevOpLoc] !== OPCODE_CREATE_STRING) {
+			return false;
+		}
+		let str = this.strConsts[this.codes[this.prevOpLoc + 1]] + this.strConsts[this.codes[this.lastOpLoc + 1]];
+		this.dropLastOp();
+		this.dropLastOp();
+		this.codeCreateString(this.addStrConst(str));
+		return true;
 	}
 	
 	code1(inst) {
+		this.startOp();
 		this.codes[this.codeSize] = inst;
 		this.codeSize++;
 	}
 	
 	code2(inst, arg) {
+		this.startOp();
 		this.codes[this.codeSize] = inst;
 		this.codeSize++;
 		this.codes[this.codeSize] = arg;
 		this.codeSize++;
 	}
 	
+	code3(inst, arg1, arg2) {
+		this.startOp();
+		this.codes[this.codeSize] = inst;
+		this.codeSize++;
+		this.codes[this.codeSize] = arg1;
+		this.codeSize++;
+		this.codes[this.codeSize] = arg2;
+		this.codeSize++;
+	}
+	
+	code4(inst, arg1, arg2, arg3) {
+		this.startOp();
+		this.codes[this.codeSize] = inst;
+		this.codeSize++;
+		this.codes[this.codeSize] = arg1;
+		this.codeSize++;
+		this.codes[this.codeSize] = arg2;
+		this.codeSize++;
+		this.codes[this.codeSize] = arg3;
+		this.codeSize++;
+	}
+	
+	// the last instruction pushed the first value of the local at offset
+	startSlot(offset) {
+		if (this.lastOpLoc !== -1) {
+			this.slotStarts[this.slotStarts.length] = {loc: this.lastOpLoc, offset: offset};
+		}
+	}
+	
+	shareSlot(offset) {
+		if (this.sharedSlots.indexOf(offset) === -1) {
+			this.sharedSlots[this.sharedSlots.length] = offset;
+		}
+	}
+	
+	/*
+		Peephole passes, run once the code of the block is complete and all the
+		jumps are patched. The code is decoded into a list of instructions whose
+		jump args are indexes in the list, so that removing an instruction only
+		needs to remap the targets, a removed target goes to the next instruction.
+	*/
+	
+	opArgCount(opcode) {
+		if (opcode <= OPCODE1_MAX) {
+			return 0;
+		}
+		if (opcode <= OPCODE2_MAX) {
+			return 1;
+		}
+		if (opcode <= OPCODE3_MAX) {
+			return 2;
+		}
+		return 3;
+	}
+	
+	// index of the arg holding a code location, -1 if none
+	opJumpArg(opcode) {
+		if (
+			opcode === OPCODE_JZ || opcode === OPCODE_JNZ || opcode === OPCODE_JMP ||
+			opcode === OPCODE_CREATE_EXCEPTION_HANDLER
+		) {
+			return 0;
+		}
+		if (opcode === OPCODE_JGT_LOCAL_LOCAL || opcode === OPCODE_JLT_LOCAL_LOCAL) {
+			return 2;
+		}
+		return -1;
+	}
+	
+	opFallsThrough(opcode) {
+		return (
+			opcode !== OPCODE_JMP && opcode !== OPCODE_RET && opcode !== OPCODE_RET_VAL &&
+			opcode !== OPCODE_RAISE && opcode !== OPCODE_YIELD_DONE && opcode !== OPCODE_TAIL_CALL
+		);
+	}
+	
+	// pushes one cell that a POP_VOID can release without any other effect
+	opIsPurePush(opcode) {
+		return (
+			opcode === OPCODE_PUSH || opcode === OPCODE_PUSHF || opcode === OPCODE_DUP ||
+			opcode === OPCODE_PUSH_LOCAL || opcode === OPCODE_PUSH_GLOBAL
+		);
+	}
+	
+	decodeOps() {
+		let ops = [];
+		let indexOfLoc = [];
+		let loc = 0;
+		while (loc < this.codeSize) {
+			let op = {opcode: this.codes[loc], args: [], isRemoved: false, startedSlots: []};
+			let argCount = this.opArgCount(op.opcode);
+			for (let i = 0; i < argCount; i++) {
+				op.args[i] = this.codes[loc + 1 + i];
+			}
+			indexOfLoc[loc] = ops.length;
+			ops[ops.length] = op;
+			loc += 1 + argCount;
+		}
+		indexOfLoc[this.codeSize] = ops.length;
+		for (let i = 0; i < ops.length; i++) {
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			if (jumpArg !== -1) {
+				ops[i].args[jumpArg] = indexOfLoc[ops[i].args[jumpArg]];
+			}
+		}
+		for (let i = 0; i < this.slotStarts.length; i++) {
+			let startedSlots = ops[indexOfLoc[this.slotStarts[i].loc]].startedSlots;
+			startedSlots[startedSlots.length] = this.slotStarts[i].offset;
+		}
+		return ops;
+	}
+	
+	encodeOps(ops) {
+		let locOfIndex = [];
+		let loc = 0;
+		for (let i = 0; i < ops.length; i++) {
+			locOfIndex[i] = loc;
+			loc += 1 + ops[i].args.length;
+		}
+		locOfIndex[ops.length] = loc;
+		this.codeSize = 0;
+		for (let i = 0; i < ops.length; i++) {
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			this.codes[this.codeSize] = ops[i].opcode;
+			this.codeSize++;
+			for (let j = 0; j < ops[i].args.length; j++) {
+				this.codes[this.codeSize] = j === jumpArg ? locOfIndex[ops[i].args[j]] : ops[i].args[j];
+				this.codeSize++;
+			}
+		}
+		this.lastOpLoc = -1;
+		this.prevOpLoc = -1;
+		this.labelLoc = this.codeSize;
+	}
+	
+	compactOps(ops) {
+		let kept = [];
+		let newIndex = [];
+		for (let i = 0; i < ops.length; i++) {
+			newIndex[i] = kept.length;
+			if (!ops[i].isRemoved) {
+				kept[kept.length] = ops[i];
+			}
+		}
+		newIndex[ops.length] = kept.length;
+		for (let i = 0; i < kept.length; i++) {
+			let jumpArg = this.opJumpArg(kept[i].opcode);
+			if (jumpArg !== -1) {
+				kept[i].args[jumpArg] = newIndex[kept[i].args[jumpArg]];
+			}
+		}
+		return kept;
+	}
+	
+	// final target of a jump, through the jumps and the constants tested again
+	// like in the lowering of and/or used as a condition
+	jumpTarget(ops, target) {
+		for (let hops = 0; hops < ops.length && target < ops.length && !ops[target].isRemoved; hops++) {
+			let op = ops[target];
+			if (op.opcode === OPCODE_JMP && op.args[0] !== target) {
+				target = op.args[0];
+			} else if (
+				op.opcode === OPCODE_PUSH && target + 1 < ops.length && !ops[target + 1].isRemoved &&
+				(ops[target + 1].opcode === OPCODE_JZ || ops[target + 1].opcode === OPCODE_JNZ)
+			) {
+				let isTaken = (ops[target + 1].opcode === OPCODE_JZ) === (op.args[0] === 0);
+				let nextTarget = isTaken ? ops[target + 1].args[0] : target + 2;
+				if (nextTarget === target) {
+					break;
+				}
+				target = nextTarget;
+			} else {
+				break;
+			}
+		}
+		return target;
+	}
+	
+	// one pass over the instructions, returns true if it changed anything
+	peephole(ops) {
+		let changed = false;
+		let isTarget = [];
+		for (let i = 0; i <= ops.length; i++) {
+			isTarget[i] = false;
+		}
+		for (let i = 0; i < ops.length; i++) {
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			if (jumpArg !== -1) {
+				isTarget[ops[i].args[jumpArg]] = true;
+			}
+		}
+		for (let i = 0; i < ops.length; i++) {
+			let op = ops[i];
+			let next = i + 1 < ops.length && !isTarget[i + 1] ? ops[i + 1] : null;
+			let jumpArg = this.opJumpArg(op.opcode);
+			if (jumpArg !== -1 && op.opcode !== OPCODE_CREATE_EXCEPTION_HANDLER) {
+				let target = this.jumpTarget(ops, op.args[jumpArg]);
+				if (target !== op.args[jumpArg]) {
+					op.args[jumpArg] = target;
+					changed = true;
+				}
+			}
+			// JMP to a return
+			if (
+				op.opcode === OPCODE_JMP && op.args[0] < ops.length &&
+				(ops[op.args[0]].opcode === OPCODE_RET || ops[op.args[0]].opcode === OPCODE_RET_VAL)
+			) {
+				op.opcode = ops[op.args[0]].opcode;
+				op.args = [];
+				changed = true;
+			}
+			// JMP to the next instruction
+			if (op.opcode === OPCODE_JMP && op.args[0] === i + 1) {
+				op.isRemoved = true;
+				changed = true;
+			}
+			// NOT; JZ is JNZ
+			if (op.opcode === OPCODE_NOT && next !== null && (next.opcode === OPCODE_JZ || next.opcode === OPCODE_JNZ)) {
+				op.opcode = next.opcode === OPCODE_JZ ? OPCODE_JNZ : OPCODE_JZ;
+				op.args = [next.args[0]];
+				next.isRemoved = true;
+				changed = true;
+				i++;
+				continue;
+			}
+			// PUSH x; POP_VOID n
+			if (this.opIsPurePush(op.opcode) && next !== null && next.opcode === OPCODE_POP_VOID && next.args[0] > 0) {
+				op.isRemoved = true;
+				next.args[0]--;
+				changed = true;
+				continue;
+			}
+			// POP_VOID 0, and POP_VOID n; RET as RET releases the whole frame,
+			// unless the RET is also reached by a jump at another depth
+			if (
+				op.opcode === OPCODE_POP_VOID &&
+				(op.args[0] === 0 || (next !== null && next.opcode === OPCODE_RET))
+			) {
+				op.isRemoved = true;
+				changed = true;
+				continue;
+			}
+			// POP_VOID n; POP_VOID m
+			if (op.opcode === OPCODE_POP_VOID && next !== null && next.opcode === OPCODE_POP_VOID) {
+				op.args[0] += next.args[0];
+				next.isRemoved = true;
+				changed = true;
+				i++;
+				continue;
+			}
+		}
+		// instructions that no path reaches
+		let isReachable = [];
+		for (let i = 0; i < ops.length; i++) {
+			isReachable[i] = false;
+		}
+		let pending = [0];
+		while (pending.length > 0) {
+			let i = pending.pop();
+			if (i >= ops.length || isReachable[i]) {
+				continue;
+			}
+			isReachable[i] = true;
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			if (jumpArg !== -1) {
+				pending[pending.length] = ops[i].args[jumpArg];
+			}
+			if (this.opFallsThrough(ops[i].opcode)) {
+				pending[pending.length] = i + 1;
+			}
+		}
+		for (let i = 0; i < ops.length; i++) {
+			if (!isReachable[i] && !ops[i].isRemoved) {
+				ops[i].isRemoved = true;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+	
+	/*
+		Moves: a PUSH_LOCAL that reads its slot for the last time becomes a
+		PUSH_LOCAL_MOVE, which hands the value over to the stack and clears
+		the slot instead of counting the ref once more, so that the consumer
+		can find the ref unshared and mutate it without a copy. The liveness
+		of the slots is solved backwards over the instructions, a slot is
+		written by a pop, and does not exist before the push of the first
+		value of its local, which a fused push can read right away. In the
+		global code the locals and the globals are the same slots, the globals
+		stay live after the block and the shared ones through the calls.
+	*/
+	
+	// offsets of the slots read by an instruction
+	opSlotReads(op) {
+		let opcode = op.opcode;
+		if (
+			opcode === OPCODE_PUSH_LOCAL || opcode === OPCODE_PUSH_LOCAL_FOR_MUTATE ||
+			opcode === OPCODE_PUSH_INDIRECTION || opcode === OPCODE_PUSH_INDIRECT ||
+			opcode === OPCODE_PUSH_INDIRECT_FOR_MUTATE || opcode === OPCODE_POP_INDIRECT ||
+			opcode === OPCODE_INC_LOCAL
+		) {
+			return [op.args[0]];
+		}
+		if (
+			opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL ||
+			opcode === OPCODE_JGT_LOCAL_LOCAL || opcode === OPCODE_JLT_LOCAL_LOCAL
+		) {
+			return [op.args[0], op.args[1]];
+		}
+		if (this.isGlobalCode && (opcode === OPCODE_PUSH_GLOBAL || opcode === OPCODE_PUSH_GLOBAL_FOR_MUTATE)) {
+			return [op.args[0]];
+		}
+		if (this.isGlobalCode && opcode === OPCODE_PUSH_GLOBAL_PUSH_GLOBAL) {
+			return [op.args[0], op.args[1]];
+		}
+		if (this.isGlobalCode && this.opRunsCode(opcode)) {
+			return this.sharedSlots;
+		}
+		return [];
+	}
+	
+	// offset of the slot overwritten by an instruction, null if none
+	opSlotWrite(op) {
+		if (op.opcode === OPCODE_POP_LOCAL || (this.isGlobalCode && op.opcode === OPCODE_POP_GLOBAL)) {
+			return op.args[0];
+		}
+		return null;
+	}
+	
+	// runs the code of other blocks
+	opRunsCode(opcode) {
+		return (
+			opcode === OPCODE_CALL || opcode === OPCODE_CALL_ABSTRACT || opcode === OPCODE_CALL_ABSTRACT_PROC ||
+			opcode === OPCODE_TAIL_CALL || opcode === OPCODE_INIT_GENERATOR || opcode === OPCODE_NEXT
+		);
+	}
+	
+	// liveOut[i][s] is true when the slot slots[s] may be read after the instruction i
+	slotLiveness(ops, slots) {
+		let reads = [];
+		let writes = [];
+		let starts = [];
+		let liveIn = [];
+		let liveOut = [];
+		// leaving the block ends the frame, but not the globals, which are the slots without a start
+		let liveAtExit = new Array(slots.length).fill(this.isGlobalCode);
+		for (let i = 0; i < ops.length; i++) {
+			reads[i] = new Array(slots.length).fill(false);
+			starts[i] = new Array(slots.length).fill(false);
+			let offsets = this.opSlotReads(ops[i]);
+			for (let j = 0; j < offsets.length; j++) {
+				reads[i][slots.indexOf(offsets[j])] = true;
+			}
+			let offset = this.opSlotWrite(ops[i]);
+			writes[i] = offset === null ? -1 : slots.indexOf(offset);
+			for (let j = 0; j < ops[i].startedSlots.length; j++) {
+				starts[i][slots.indexOf(ops[i].startedSlots[j])] = true;
+				liveAtExit[slots.indexOf(ops[i].startedSlots[j])] = false;
+			}
+			liveIn[i] = new Array(slots.length).fill(false);
+			liveOut[i] = new Array(slots.length).fill(false);
+		}
+		let changed = true;
+		while (changed) {
+			changed = false;
+			for (let i = ops.length - 1; i >= 0; i--) {
+				let successors = [];
+				let jumpArg = this.opJumpArg(ops[i].opcode);
+				if (jumpArg !== -1) {
+					successors[successors.length] = ops[i].args[jumpArg];
+				}
+				if (this.opFallsThrough(ops[i].opcode)) {
+					successors[successors.length] = i + 1;
+				}
+				for (let s = 0; s < slots.length; s++) {
+					let isLive = false;
+					for (let j = 0; j < successors.length; j++) {
+						isLive = isLive || (successors[j] < ops.length ? liveIn[successors[j]][s] : liveAtExit[s]);
+					}
+					if (isLive !== liveOut[i][s]) {
+						liveOut[i][s] = isLive;
+						changed = true;
+					}
+					let isLiveIn = !starts[i][s] && (reads[i][s] || (isLive && writes[i] !== s));
+					if (isLiveIn !== liveIn[i][s]) {
+						liveIn[i][s] = isLiveIn;
+						changed = true;
+					}
+				}
+			}
+		}
+		return liveOut;
+	}
+	
+	moveLastReads(ops) {
+		let slots = [];
+		let addressedSlots = [];
+		for (let i = 0; i < ops.length; i++) {
+			// the handler can resume the block with any slot
+			if (ops[i].opcode === OPCODE_CREATE_EXCEPTION_HANDLER) {
+				return ops;
+			}
+			let offsets = [...this.opSlotReads(ops[i]), ...ops[i].startedSlots];
+			if (this.opSlotWrite(ops[i]) !== null) {
+				offsets[offsets.length] = this.opSlotWrite(ops[i]);
+			}
+			for (let j = 0; j < offsets.length; j++) {
+				if (slots.indexOf(offsets[j]) === -1) {
+					slots[slots.length] = offsets[j];
+				}
+			}
+			if (ops[i].opcode === OPCODE_PUSH_INDIRECTION) {
+				addressedSlots[addressedSlots.length] = ops[i].args[0];
+			}
+		}
+		let liveOut = this.slotLiveness(ops, slots);
+		let isLastRead = (i, offset) => addressedSlots.indexOf(offset) === -1 && !liveOut[i][slots.indexOf(offset)];
+		let moved = [];
+		let newIndex = [];
+		for (let i = 0; i < ops.length; i++) {
+			let op = ops[i];
+			newIndex[i] = moved.length;
+			moved[moved.length] = op;
+			if (op.opcode === OPCODE_PUSH_LOCAL || (this.isGlobalCode && op.opcode === OPCODE_PUSH_GLOBAL)) {
+				if (isLastRead(i, op.args[0])) {
+					op.opcode = op.opcode === OPCODE_PUSH_LOCAL ? OPCODE_PUSH_LOCAL_MOVE : OPCODE_PUSH_GLOBAL_MOVE;
+					this.moveCount++;
+				}
+			} else if (op.opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL || (this.isGlobalCode && op.opcode === OPCODE_PUSH_GLOBAL_PUSH_GLOBAL)) {
+				// split in two pushes, the second slot is still read by the second one
+				let isFirstMoved = op.args[0] !== op.args[1] && isLastRead(i, op.args[0]);
+				let isSecondMoved = isLastRead(i, op.args[1]);
+				if (isFirstMoved || isSecondMoved) {
+					let isLocal = op.opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL;
+					let copyOpcode = isLocal ? OPCODE_PUSH_LOCAL : OPCODE_PUSH_GLOBAL;
+					let moveOpcode = isLocal ? OPCODE_PUSH_LOCAL_MOVE : OPCODE_PUSH_GLOBAL_MOVE;
+					moved[moved.length - 1] = {opcode: isFirstMoved ? moveOpcode : copyOpcode, args: [op.args[0]], isRemoved: false, startedSlots: []};
+					moved[moved.length] = {opcode: isSecondMoved ? moveOpcode : copyOpcode, args: [op.args[1]], isRemoved: false, startedSlots: []};
+					this.moveCount += (isFirstMoved ? 1 : 0) + (isSecondMoved ? 1 : 0);
+				}
+			}
+		}
+		newIndex[ops.length] = moved.length;
+		this.remapJumps(moved, newIndex);
+		return moved;
+	}
+	
+	// newIndex[i] is the new index of the instruction i
+	remapJumps(ops, newIndex) {
+		for (let i = 0; i < ops.length; i++) {
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			if (jumpArg !== -1) {
+				ops[i].args[jumpArg] = newIndex[ops[i].args[jumpArg]];
+			}
+		}
+	}
+	
+	/*
+		Borrows: a PUSH_LOCAL whose ref is only read by a later offset read
+		becomes a PUSH_LOCAL_BORROW, which pushes the ref as a cell that is
+		not a ref, so it is neither counted by the push nor released by the
+		read. The slot keeps the count in between, because the instructions
+		there only push copies and compute on the cells above the borrowed
+		one, and none of them can be reached by a jump.
+	*/
+	
+	// [popped, pushed] cells of an instruction allowed between a borrow and its read, null if not allowed
+	opBorrowEffect(opcode) {
+		if (
+			opcode === OPCODE_PUSH || opcode === OPCODE_PUSH_LOCAL || opcode === OPCODE_PUSH_GLOBAL
+		) {
+			return [0, 1];
+		}
+		if (opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL || opcode === OPCODE_PUSH_GLOBAL_PUSH_GLOBAL) {
+			return [0, 2];
+		}
+		if (opcode === OPCODE_ADD_CONST || opcode === OPCODE_PUSH_PTR_OFFSET_CONST) {
+			return [1, 1];
+		}
+		if (
+			opcode === OPCODE_ADD || opcode === OPCODE_SUB || opcode === OPCODE_MUL ||
+			opcode === OPCODE_PUSH_PTR_OFFSET
+		) {
+			return [2, 1];
+		}
+		return null;
+	}
+	
+	// the cell pushed by the instruction i with depth - 1 cells above it is the ref of an offset read
+	isBorrowedRead(ops, isTarget, i, depth) {
+		for (let j = i + 1; j < ops.length && !isTarget[j]; j++) {
+			let opcode = ops[j].opcode;
+			if ((opcode === OPCODE_PUSH_PTR_OFFSET && depth === 2) || (opcode === OPCODE_PUSH_PTR_OFFSET_CONST && depth === 1)) {
+				return true;
+			}
+			let effect = this.opBorrowEffect(opcode);
+			if (effect === null || effect[0] >= depth) {
+				return false;
+			}
+			depth += effect[1] - effect[0];
+		}
+		return false;
+	}
+	
+	borrowReads(ops) {
+		let isTarget = new Array(ops.length).fill(false);
+		for (let i = 0; i < ops.length; i++) {
+			let jumpArg = this.opJumpArg(ops[i].opcode);
+			if (jumpArg !== -1 && ops[i].args[jumpArg] < ops.length) {
+				isTarget[ops[i].args[jumpArg]] = true;
+			}
+		}
+		let borrowed = [];
+		let newIndex = [];
+		for (let i = 0; i < ops.length; i++) {
+			let op = ops[i];
+			newIndex[i] = borrowed.length;
+			borrowed[borrowed.length] = op;
+			if (op.opcode === OPCODE_PUSH_LOCAL || op.opcode === OPCODE_PUSH_GLOBAL) {
+				if (this.isBorrowedRead(ops, isTarget, i, 1)) {
+					op.opcode = op.opcode === OPCODE_PUSH_LOCAL ? OPCODE_PUSH_LOCAL_BORROW : OPCODE_PUSH_GLOBAL_BORROW;
+					this.borrowCount++;
+				}
+			} else if (op.opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL || op.opcode === OPCODE_PUSH_GLOBAL_PUSH_GLOBAL) {
+				// split in two pushes like for the moves
+				let isFirstBorrowed = this.isBorrowedRead(ops, isTarget, i, 2);
+				let isSecondBorrowed = this.isBorrowedRead(ops, isTarget, i, 1);
+				if (isFirstBorrowed || isSecondBorrowed) {
+					let isLocal = op.opcode === OPCODE_PUSH_LOCAL_PUSH_LOCAL;
+					let copyOpcode = isLocal ? OPCODE_PUSH_LOCAL : OPCODE_PUSH_GLOBAL;
+					let borrowOpcode = isLocal ? OPCODE_PUSH_LOCAL_BORROW : OPCODE_PUSH_GLOBAL_BORROW;
+					borrowed[borrowed.length - 1] = {opcode: isFirstBorrowed ? borrowOpcode : copyOpcode, args: [op.args[0]], isRemoved: false, startedSlots: []};
+					borrowed[borrowed.length] = {opcode: isSecondBorrowed ? borrowOpcode : copyOpcode, args: [op.args[1]], isRemoved: false, startedSlots: []};
+					this.borrowCount += (isFirstBorrowed ? 1 : 0) + (isSecondBorrowed ? 1 : 0);
+				}
+			}
+		}
+		newIndex[ops.length] = borrowed.length;
+		this.remapJumps(borrowed, newIndex);
+		return borrowed;
+	}
+	
+	// one line per optimized block and the totals
+	static peepholeReport(codeBlocks) {
+		let report = "";
+		let emittedOpCount = 0;
+		let optimizedOpCount = 0;
+		let moveCount = 0;
+		let borrowCount = 0;
+		for (let i = 0; i < codeBlocks.length; i++) {
+			let cb = codeBlocks[i];
+			if (cb.optimizedOpCount < cb.emittedOpCount) {
+				report += cb.blockName + ": " + (cb.emittedOpCount - cb.optimizedOpCount) + " of " + cb.emittedOpCount + " instructions removed\n";
+			}
+			emittedOpCount += cb.emittedOpCount;
+			optimizedOpCount += cb.optimizedOpCount;
+			moveCount += cb.moveCount;
+			borrowCount += cb.borrowCount;
+		}
+		report += "total: " + (emittedOpCount - optimizedOpCount) + " of " + emittedOpCount + " instructions removed, " + moveCount + " reads moved, " + borrowCount + " reads borrowed";
+		return report;
+	}
+	
+	optimize() {
+		let ops = this.decodeOps();
+		this.emittedOpCount = ops.length;
+		let changed = true;
+		for (let pass = 0; changed && pass < PEEPHOLE_MAX_PASSES; pass++) {
+			changed = this.peephole(ops);
+			ops = this.compactOps(ops);
+		}
+		this.optimizedOpCount = ops.length;
+		ops = this.moveLastReads(ops);
+		ops = this.borrowReads(ops);
+		this.encodeOps(ops);
+	}
+	
 	codeSuspend() {
 		this.code1(OPCODE_SUSPEND);
 	}
@@ -498,6 +1206,12 @@ class CodeBlock {
 	}
 		
 	codePushGlobal(offset) {
+		if (this.lastOpIs(OPCODE_PUSH_GLOBAL)) {
+			let offset1 = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.code3(OPCODE_PUSH_GLOBAL_PUSH_GLOBAL, offset1, offset);
+			return;
+		}
 		this.code2(OPCODE_PUSH_GLOBAL, offset);
 	}
 	
@@ -506,6 +1220,12 @@ class CodeBlock {
 	}
 	
 	codePushLocal(offset) {
+		if (this.lastOpIs(OPCODE_PUSH_LOCAL)) {
+			let offset1 = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.code3(OPCODE_PUSH_LOCAL_PUSH_LOCAL, offset1, offset);
+			return;
+		}
 		this.code2(OPCODE_PUSH_LOCAL, offset);
 	}
 	
@@ -526,6 +1246,12 @@ class CodeBlock {
 	}
 
 	codePushPtrOffset() {
+		if (this.lastOpIs(OPCODE_PUSH)) {
+			let offset = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.code2(OPCODE_PUSH_PTR_OFFSET_CONST, offset);
+			return;
+		}
 		this.code1(OPCODE_PUSH_PTR_OFFSET);
 	}
 	
@@ -553,6 +1279,14 @@ class CodeBlock {
 		this.code1(OPCODE_BASIC_ARRAY_TIMES);
 	}
 	
+	codeCreateByteArray(itemCount) {
+		this.code2(OPCODE_CREATE_BYTE_ARRAY, itemCount);
+	}
+	
+	codeByteArrayTimes() {
+		this.code1(OPCODE_BYTE_ARRAY_TIMES);
+	}
+	
 	codeCreateString(strId) {
 		this.code2(OPCODE_CREATE_STRING, strId);
 	}
@@ -562,6 +1296,17 @@ class CodeBlock {
 	}
 	
 	codePopLocal(offset) {
+		// x := x + c
+		if (
+			this.lastOpIs(OPCODE_ADD_CONST) && this.canFuse(this.prevOpLoc) &&
+			this.codes[this.prevOpLoc] === OPCODE_PUSH_LOCAL && this.codes[this.prevOpLoc + 1] === offset
+		) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.dropLastOp();
+			this.code3(OPCODE_INC_LOCAL, offset, val);
+			return;
+		}
 		this.code2(OPCODE_POP_LOCAL, offset);
 	}
 	
@@ -578,96 +1323,203 @@ class CodeBlock {
 	}
 	
 	codeAdd() {
+		if (this.foldInt((a, b) => a + b)) {
+			return;
+		}
+		if (this.lastOpIsPushOf(0)) {
+			this.dropLastOp();
+			return;
+		}
+		if (this.lastOpIs(OPCODE_PUSH)) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.code2(OPCODE_ADD_CONST, val);
+			return;
+		}
 		this.code1(OPCODE_ADD);
 	}
 	
 	codeSub() {
+		if (this.foldInt((a, b) => a - b)) {
+			return;
+		}
+		// x - c is x + (-c)
+		if (this.lastOpIs(OPCODE_PUSH) && Number.isSafeInteger(this.codes[this.lastOpLoc + 1])) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.codePush(-val);
+			this.codeAdd();
+			return;
+		}
 		this.code1(OPCODE_SUB);
 	}
 
 	codeDiv() {
+		if (this.foldInt((a, b) => b === 0 ? null : Math.trunc(a / b))) {
+			return;
+		}
+		if (this.lastOpIsPushOf(1)) {
+			this.dropLastOp();
+			return;
+		}
 		this.code1(OPCODE_DIV);
 	}
 
 	codeRem() {
+		if (this.foldInt((a, b) => b === 0 ? null : a % b)) {
+			return;
+		}
 		this.code1(OPCODE_REM);
 	}
 
 	codeMul() {
+		if (this.foldInt((a, b) => a * b)) {
+			return;
+		}
+		if (this.lastOpIsPushOf(1)) {
+			this.dropLastOp();
+			return;
+		}
 		this.code1(OPCODE_MUL);
 	}
 	
 	codeNeg() {
+		if (this.lastOpIs(OPCODE_PUSH) && Number.isSafeInteger(this.codes[this.lastOpLoc + 1])) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.codePush(val === 0 ? 0 : -val);
+			return;
+		}
 		this.code1(OPCODE_NEG);
 	}
 	
 	codeGt() {
+		if (this.foldInt((a, b) => a > b ? 1 : 0)) {
+			return;
+		}
 		this.code1(OPCODE_GT);
 	}
 
 	codeGte() {
+		if (this.foldInt((a, b) => a >= b ? 1 : 0)) {
+			return;
+		}
 		this.code1(OPCODE_GTE);
 	}
 
 	codeLt() {
+		if (this.foldInt((a, b) => a < b ? 1 : 0)) {
+			return;
+		}
 		this.code1(OPCODE_LT);
 	}
 
 	codeLte() {
+		if (this.foldInt((a, b) => a <= b ? 1 : 0)) {
+			return;
+		}
 		this.code1(OPCODE_LTE);
 	}
 	
 	codeEq() {
+		if (this.foldInt((a, b) => a === b ? 1 : 0)) {
+			return;
+		}
+		if (this.lastOpIs(OPCODE_PUSH)) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.code2(OPCODE_EQ_CONST, val);
+			return;
+		}
 		this.code1(OPCODE_EQ);
 	}
 	
 	codeNe() {
+		if (this.foldInt((a, b) => a !== b ? 1 : 0)) {
+			return;
+		}
 		this.code1(OPCODE_NE);
 	}
 
 	// real
 
 	codeAddf() {
+		if (this.foldFloat((a, b) => a + b, false)) {
+			return;
+		}
 		this.code1(OPCODE_ADDF);
 	}
 	
 	codeSubf() {
+		if (this.foldFloat((a, b) => a - b, false)) {
+			return;
+		}
 		this.code1(OPCODE_SUBF);
 	}
 
 	codeDivf() {
+		if (this.foldFloat((a, b) => a / b, false)) {
+			return;
+		}
 		this.code1(OPCODE_DIVF);
 	}
 
 	codeMulf() {
+		if (this.foldFloat((a, b) => a * b, false)) {
+			return;
+		}
 		this.code1(OPCODE_MULF);
 	}
 	
 	codeNegf() {
+		if (this.lastOpIs(OPCODE_PUSHF) && this.floatConsts[this.codes[this.lastOpLoc + 1]] !== 0) {
+			let val = this.floatConsts[this.codes[this.lastOpLoc + 1]];
+			this.dropLastOp();
+			this.codePushf(this.addFloatConst(-val));
+			return;
+		}
 		this.code1(OPCODE_NEGF);
 	}
 	
 	codeGtf() {
+		if (this.foldFloat((a, b) => a > b, true)) {
+			return;
+		}
 		this.code1(OPCODE_GTF);
 	}
 
 	codeGtef() {
+		if (this.foldFloat((a, b) => a >= b, true)) {
+			return;
+		}
 		this.code1(OPCODE_GTEF);
 	}
 
 	codeLtf() {
+		if (this.foldFloat((a, b) => a < b, true)) {
+			return;
+		}
 		this.code1(OPCODE_LTF);
 	}
 
 	codeLtef() {
+		if (this.foldFloat((a, b) => a <= b, true)) {
+			return;
+		}
 		this.code1(OPCODE_LTEF);
 	}
 	
 	codeEqf() {
+		if (this.foldFloat((a, b) => a === b, true)) {
+			return;
+		}
 		this.code1(OPCODE_EQF);
 	}
 	
 	codeNef() {
+		if (this.foldFloat((a, b) => a !== b, true)) {
+			return;
+		}
 		this.code1(OPCODE_NEF);
 	}
 	
@@ -683,6 +1535,12 @@ class CodeBlock {
 	}
 	
 	codeNot() {
+		if (this.lastOpIs(OPCODE_PUSH)) {
+			let val = this.codes[this.lastOpLoc + 1];
+			this.dropLastOp();
+			this.codePush(val === 0 ? 1 : 0);
+			return;
+		}
 		this.code1(OPCODE_NOT);
 	}
 		
@@ -699,6 +1557,19 @@ class CodeBlock {
 	}
 	
 	codeJz(offset) {
+		// i <= j and i >= j on two locals
+		if (
+			(this.lastOpIs(OPCODE_LTE) || this.lastOpIs(OPCODE_GTE)) &&
+			this.canFuse(this.prevOpLoc) && this.codes[this.prevOpLoc] === OPCODE_PUSH_LOCAL_PUSH_LOCAL
+		) {
+			let inst = this.codes[this.lastOpLoc] === OPCODE_LTE ? OPCODE_JGT_LOCAL_LOCAL : OPCODE_JLT_LOCAL_LOCAL;
+			this.dropLastOp();
+			let offset1 = this.codes[this.lastOpLoc + 1];
+			let offset2 = this.codes[this.lastOpLoc + 2];
+			this.dropLastOp();
+			this.code4(inst, offset1, offset2, offset);
+			return this.codeSize - 1;
+		}
 		this.code2(OPCODE_JZ, offset);
 		return this.codeSize - 1;
 	}
@@ -725,6 +1596,13 @@ class CodeBlock {
 		this.code1(OPCODE_RET_VAL);
 	}
 	
+	// the last call is in tail position, its frame replaces the current one
+	codeTailCall() {
+		let ptr = this.codes[this.lastOpLoc + 1];
+		this.dropLastOp();
+		this.code2(OPCODE_TAIL_CALL, ptr);
+	}
+	
 	codeYield() {
 		this.code1(OPCODE_YIELD);
 	}
@@ -745,6 +1623,10 @@ class CodeBlock {
 		this.code2(OPCODE_CALL_ABSTRACT, methodIndex);
 	}
 	
+	codeCallAbstractProc(methodIndex) {
+		this.code2(OPCODE_CALL_ABSTRACT_PROC, methodIndex);
+	}
+	
 	codeInitGenerator(ptr) {
 		this.code2(OPCODE_INIT_GENERATOR, ptr);
 	}
@@ -859,7 +1741,7 @@ class CompilerContext {
 	
 	addCodeBlock(blockName) {
 		let i = this.codeBlocks.length;
-		this.codeBlocks[i] = new CodeBlock(blockName);
+		this.codeBlocks[i] = new CodeBlock(blockName, false);
 		// console.log("Code block " + i + ": " + blockName);
 		return i;
 	}
@@ -929,6 +1811,21 @@ class CompilerScope {
 		return currentScope;
 	}
 	
+	// an exception handler must stay on the stack until its frame returns
+	hasExceptionHandler() {
+		let currentScope = this;
+		while (currentScope !== null) {
+			if (currentScope.getLocalVariable("_exception_handler") !== null) {
+				return true;
+			}
+			if (currentScope.isFrame) {
+				break;
+			}
+			currentScope = currentScope.parent;
+		}
+		return false;
+	}
+	
 	getLocalVariable(varName) {
 		for (let i = 0; i < this.variableCount; i++) {
 			if (this.variables[i].varName === varName) {
@@ -982,11 +1879,22 @@ class Compiler {
 	constructor(context) {
 		this.context = context;
 		this.scope = this.context.globalScope;
-		this.codeBlock = new CodeBlock("global");
+		this.codeBlock = new CodeBlock("global", true);
+		// names of the variables read by the function being compiled, null for the global code
+		this.readVarNames = null;
 	}
 	
 	resetCode() {
-		this.codeBlock = new CodeBlock("global");
+		this.codeBlock = new CodeBlock("global", true);
+	}
+	
+	// a variable whose first value was just pushed, the globals outlive the code block
+	addPushedVariable(varName, varType, isConst) {
+		let variable = this.scope.addVariable(varName, varType, isConst);
+		if (this.scope !== this.context.globalScope) {
+			this.codeBlock.startSlot(variable.offset);
+		}
+		return variable;
 	}
 	
 	pushScopeBlock() {
@@ -1157,6 +2065,91 @@ class Compiler {
 	}
 	
 	
+	// names of the variables that a statement reads, a variable that is only assigned is not read
+	collectReadVarNames(expr, names) {
+		if (expr === null || typeof expr !== "object") {
+			return names;
+		}
+		if (Array.isArray(expr)) {
+			for (let i = 0; i < expr.length; i++) {
+				this.collectReadVarNames(expr[i], names);
+			}
+			return names;
+		}
+		if ((expr.tag === "ast-variable" || expr.tag === "ast-ctx-arg") && names.indexOf(expr.varName) === -1) {
+			names[names.length] = expr.varName;
+		}
+		for (let key in expr) {
+			if (expr.tag !== "ast-assign" || key !== "left" || expr.left.tag !== "ast-variable") {
+				this.collectReadVarNames(expr[key], names);
+			}
+		}
+		return names;
+	}
+	
+	// an expression that cannot raise nor have any effect, so that it can be dropped
+	isPure(expr) {
+		if (
+			expr.tag === "ast-value-boolean" || expr.tag === "ast-value-integer" ||
+			expr.tag === "ast-value-real" || expr.tag === "ast-value-text" || expr.tag === "ast-variable"
+		) {
+			return true;
+		}
+		if (expr.tag === "ast-operator-unary") {
+			return this.isPure(expr.operand);
+		}
+		if (expr.tag === "ast-operator-binary") {
+			return (
+				expr.operator === TOK_ADD || expr.operator === TOK_SUB || expr.operator === TOK_MUL ||
+				expr.operator === TOK_GT || expr.operator === TOK_LT || expr.operator === TOK_GTE || expr.operator === TOK_LTE ||
+				expr.operator === TOK_EQ || expr.operator === TOK_NE || expr.operator === TOK_AND || expr.operator === TOK_OR ||
+				expr.operator === TOK_CONCAT
+			) && this.isPure(expr.left) && this.isPure(expr.right);
+		}
+		return false;
+	}
+	
+	// the items of the arrays of booleans and chars take a byte
+	isByteItemType(itemType) {
+		while (itemType.tag === "res-type-name" && itemType !== EVAL_TYPE_CHAR) {
+			itemType = itemType.underlyingType;
+		}
+		return itemType === EVAL_TYPE_BOOLEAN || itemType === EVAL_TYPE_CHAR;
+	}
+	
+	// compiles a statement that can never run, for its errors only
+	evalDeadStatement(expr) {
+		let deadMark = this.codeBlock.startDeadCode();
+		let ret = this.evalStatement(expr);
+		this.dropDeadCode(deadMark);
+		return ret;
+	}
+	
+	// the exits of the enclosing loops that were in the dropped code are forgotten
+	dropDeadCode(deadMark) {
+		this.codeBlock.dropDeadCode(deadMark);
+		for (let scope = this.scope; scope !== null; scope = scope.parent) {
+			while (scope.exitLocCount > 0 && scope.exitLocs[scope.exitLocCount - 1] >= deadMark.codeSize) {
+				scope.exitLocCount--;
+			}
+		}
+	}
+	
+	// A returned call can replace the frame unless an exception handler of the frame must stay
+	// on the stack, or an arg points to a variable of the frame
+	canTailCall(expr) {
+		if (expr.tag !== "ast-function" || !this.codeBlock.lastOpIs(OPCODE_CALL) || this.scope.hasExceptionHandler()) {
+			return false;
+		}
+		for (let i = 0; i < expr.argList.argCount; i++) {
+			let arg = expr.argList.args[i];
+			if (arg.tag === "ast-ctx-arg" && !this.scope.getVariable(arg.varName).isCtx) {
+				return false;
+			}
+		}
+		return true;
+	}
+	
 	// The eval of a statement must return:
 	//   EVAL_RESULT_RAISE if all paths raise an exception, else
 	//   EVAL_RESULT_RETURN if all paths return or raise, else
@@ -1182,7 +2175,7 @@ class Compiler {
 			if (initValueType.isError()) {
 				return initValueType;
 			}
-			this.scope.addVariable(expr.varName, initValueType, expr.isConst);
+			this.addPushedVariable(expr.varName, initValueType, expr.isConst);
 			return EVAL_RESULT_OK;
 		}
 		if (expr.tag === "ast-assign") {
@@ -1195,6 +2188,11 @@ class Compiler {
 				if (variable.isConst) {
 					return EvalError.cantMutateConst(expr.left.varName).fromExpr(expr.left);
 				}
+				// a local that is never read does not need the value
+				let isUnusedStore =
+					this.readVarNames !== null && !variable.isCtx && !variable.isGlobal &&
+					this.readVarNames.indexOf(variable.varName) === -1 && this.isPure(expr.right);
+				let deadMark = isUnusedStore ? this.codeBlock.startDeadCode() : null;
 				// evaluate the value
 				let valueType = this.eval(expr.right);
 				if (valueType.isError()) {
@@ -1203,6 +2201,10 @@ class Compiler {
 				if (valueType !== variable.varType) {
 					return EvalError.wrongType(valueType, variable.varType.typeKey()).fromExpr(expr.right);					
 				}
+				if (isUnusedStore) {
+					this.dropDeadCode(deadMark);
+					return EVAL_RESULT_OK;
+				}
 				// assign the value
 				if (variable.isCtx) {
 					this.codeBlock.codePopIndirect(variable.offset);
@@ -1296,10 +2298,15 @@ class Compiler {
 				exceptionLoc = this.codeBlock.codeCreateExceptionHandler(0);
 				this.scope.addVariable("_exception_handler", EVAL_TYPE_REF, true);
 			}
+			// the statements after an exit never run
+			let deadMark = null;
 			for (let i = 0; i < expr.statementCount; i++) {
 				if (ret !== EVAL_RESULT_OK) {
 					return EvalError.unreachableCode().fromExpr(expr.statements[i]);
 				}
+				if (deadMark === null && i > 0 && expr.statements[i - 1].tag === "ast-exit" && expr.statements[i - 1].condition === null) {
+					deadMark = this.codeBlock.startDeadCode();
+				}
 				ret = this.evalStatement(expr.statements[i]);
 				if (ret.isError()) {
 					return ret;
@@ -1311,6 +2318,9 @@ class Compiler {
 				}
 			}
 			this.popScope();
+			if (deadMark !== null) {
+				this.dropDeadCode(deadMark);
+			}
 			if (expr.exception === null) {
 				return ret;
 			}
@@ -1410,21 +2420,28 @@ class Compiler {
 			if (condType !== EVAL_TYPE_BOOLEAN) {
 				return EvalError.wrongType(condType, "boolean").fromExpr(expr.condition);	
 			}
-			let falseLoc = this.codeBlock.codeJz(0);
-			let trueRet =  this.evalStatement(expr.trueStatement);
+			// a constant condition keeps only the branch that runs, the results
+			// of the branches are still merged as if both could run
+			let condValue = this.codeBlock.dropConstCondition();
+			let falseLoc = condValue === -1 ? this.codeBlock.codeJz(0) : -1;
+			let trueRet = condValue === 0 ? this.evalDeadStatement(expr.trueStatement) : this.evalStatement(expr.trueStatement);
 			if (trueRet.isError()) {
 				return trueRet;
 			}
-			let endLoc = expr.falseStatement === null ? -1 : this.codeBlock.codeJmp(0);
-			this.codeBlock.setLoc(falseLoc);
+			let endLoc = expr.falseStatement === null || condValue !== -1 ? -1 : this.codeBlock.codeJmp(0);
+			if (falseLoc !== -1) {
+				this.codeBlock.setLoc(falseLoc);
+			}
 			if (expr.falseStatement === null) {
 				return EVAL_RESULT_OK;
 			}
-			let falseRet = this.evalStatement(expr.falseStatement);
+			let falseRet = condValue === 1 ? this.evalDeadStatement(expr.falseStatement) : this.evalStatement(expr.falseStatement);
 			if (falseRet.isError()) {
 				return falseRet;
 			}
-			this.codeBlock.setLoc(endLoc);
+			if (endLoc !== -1) {
+				this.codeBlock.setLoc(endLoc);
+			}
 			if (trueRet === EVAL_RESULT_RAISE && falseRet === EVAL_RESULT_RAISE) {
 				return EVAL_RESULT_RAISE; 
 			}
@@ -1478,7 +2495,7 @@ class Compiler {
 				this.pushScopeBlock();
 				this.codeBlock.codePush(0);
 				this.codeBlock.codePushPtrOffset();
-				this.scope.addVariable(expr.whens[i].varName, caseType.fields[fieldIndex].fieldType, false);
+				this.addPushedVariable(expr.whens[i].varName, caseType.fields[fieldIndex].fieldType, false);
 				let thenRet = this.evalStatement(expr.whens[i].thenBlock);
 				if (thenRet.isError()) {
 					return thenRet;
@@ -1503,7 +2520,7 @@ class Compiler {
 		}
 		if (expr.tag === "ast-while") {
 			this.pushScopeLoop();
-			let testLoc = this.codeBlock.codeSize;
+			let testLoc = this.codeBlock.getLoc();
 			let conditionType = this.eval(expr.condition);
 			if (conditionType.isError()) {
 				return conditionType;
@@ -1511,13 +2528,24 @@ class Compiler {
 			if (conditionType !== EVAL_TYPE_BOOLEAN) {
 				return EvalError.wrongType(conditionType, "boolean").fromExpr(expr.condition);	
 			}
-			let endLoc = this.codeBlock.codeJz(0);
+			let condValue = this.codeBlock.dropConstCondition();
+			if (condValue === 0) {
+				let stmtRet = this.evalDeadStatement(expr.statement);
+				if (stmtRet.isError()) {
+					return stmtRet;
+				}
+				this.popScope();
+				return EVAL_RESULT_OK;
+			}
+			let endLoc = condValue === -1 ? this.codeBlock.codeJz(0) : -1;
 			let stmtRet = this.evalStatement(expr.statement);
 			if (stmtRet.isError()) {
 				return stmtRet;
 			}
 			this.codeBlock.codeJmp(testLoc);
-			this.codeBlock.setLoc(endLoc);
+			if (endLoc !== -1) {
+				this.codeBlock.setLoc(endLoc);
+			}
 			for (let i = 0; i < this.scope.exitLocCount; i++) {
 				this.codeBlock.setLoc(this.scope.exitLocs[i]);
 			}
@@ -1536,7 +2564,7 @@ class Compiler {
 				if (endBoundType !== EVAL_TYPE_INTEGER) {
 					return EvalError.wrongType(endBoundType, "integer").fromExpr(endBoundExpr);
 				}
-				let endBoundVar = this.scope.addVariable("_for_range_end_bound", EVAL_TYPE_INTEGER, false);
+				let endBoundVar = this.addPushedVariable("_for_range_end_bound", EVAL_TYPE_INTEGER, false);
 				let startBoundType = this.eval(startBoundExpr);
 				if (startBoundType.isError()) {
 					return startBoundType;
@@ -1544,8 +2572,8 @@ class Compiler {
 				if (startBoundType !== EVAL_TYPE_INTEGER) {
 					return EvalError.wrongType(startBoundType, "integer").fromExpr(startBoundExpr);
 				}
-				let indexVar = this.scope.addVariable(expr.index, EVAL_TYPE_INTEGER, false);
-				let testLoc = this.codeBlock.codeSize;
+				let indexVar = this.addPushedVariable(expr.index, EVAL_TYPE_INTEGER, false);
+				let testLoc = this.codeBlock.getLoc();
 				this.codeBlock.codePushLocal(indexVar.offset);
 				this.codeBlock.codePushLocal(endBoundVar.offset);
 				if (expr.isReverse) {
@@ -1579,11 +2607,11 @@ class Compiler {
 					return sequence;
 				}
 				if (sequence.tag == "res-type-sequence") {
-					let sequenceVar = this.scope.addVariable("_for_sequence", sequence, false);
+					let sequenceVar = this.addPushedVariable("_for_sequence", sequence, false);
 					this.codeBlock.codePushLocal(sequenceVar.offset);
 					this.codeBlock.codeNext();
-					let indexVar = this.scope.addVariable(expr.index, sequence.underlyingType, false);
-					let testLoc = this.codeBlock.codeSize;
+					let indexVar = this.addPushedVariable(expr.index, sequence.underlyingType, false);
+					let testLoc = this.codeBlock.getLoc();
 					this.codeBlock.codePushLocal(sequenceVar.offset);
 					this.codeBlock.codeEnded();
 					let endLoc = this.codeBlock.codeJnz(0);
@@ -1597,23 +2625,23 @@ class Compiler {
 					this.codeBlock.codeJmp(testLoc);
 					this.codeBlock.setLoc(endLoc);
 				} else if (sequence.tag === "res-type-array") {
-					let arrayVar = this.scope.addVariable("_for_array", sequence, false);
+					let arrayVar = this.addPushedVariable("_for_array", sequence, false);
 					let lastIndexFuncIndex = sequence.underlyingType.isRef ?
 						this.context.getFunction("last_index_array(ref)").nativeIndex :
 						this.context.getFunction("last_index_basic_array(ref)").nativeIndex;
 					this.codeBlock.codeDup();
 					this.codeBlock.codePush(1);
 					this.codeBlock.codeCallNative(lastIndexFuncIndex);
-					let lastIndexVar = this.scope.addVariable("_for_last_index", EVAL_TYPE_INTEGER, false);
+					let lastIndexVar = this.addPushedVariable("_for_last_index", EVAL_TYPE_INTEGER, false);
 					this.codeBlock.codePush(0);
-					let itemVar = this.scope.addVariable(expr.index, sequence.underlyingType, false);
+					let itemVar = this.addPushedVariable(expr.index, sequence.underlyingType, false);
 					if (expr.isReverse === true) {
 						this.codeBlock.codePushLocal(lastIndexVar.offset);
 					} else {
 						this.codeBlock.codePush(0);
 					}
-					let indexVar = this.scope.addVariable("_for_index", EVAL_TYPE_INTEGER, false);
-					let testLoc = this.codeBlock.codeSize;
+					let indexVar = this.addPushedVariable("_for_index", EVAL_TYPE_INTEGER, false);
+					let testLoc = this.codeBlock.getLoc();
 					this.codeBlock.codePushLocal(indexVar.offset);
 					if (expr.isReverse === true) {
 						this.codeBlock.codePush(0);
@@ -1673,11 +2701,17 @@ class Compiler {
 				if (condType !== EVAL_TYPE_BOOLEAN) {
 					return EvalError.wrongType(condType, "boolean").fromExpr(expr.condition);	
 				}
-				let falseLoc = this.codeBlock.codeJz(0);
+				let condValue = this.codeBlock.dropConstCondition();
+				if (condValue === 0) {
+					return EVAL_RESULT_OK;
+				}
+				let falseLoc = condValue === -1 ? this.codeBlock.codeJz(0) : -1;
 				this.codeBlock.codePopVoid(variableCount);
 				currentScope.exitLocs[currentScope.exitLocCount] = this.codeBlock.codeJmp(0);
 				currentScope.exitLocCount++;
-				this.codeBlock.setLoc(falseLoc);
+				if (falseLoc !== -1) {
+					this.codeBlock.setLoc(falseLoc);
+				}
 			}
 			return EVAL_RESULT_OK;
 		}
@@ -1718,6 +2752,8 @@ class Compiler {
 			}
 			if (retType === null) {
 				this.codeBlock.codeRet();
+			} else if (this.canTailCall(expr.expr)) {
+				this.codeBlock.codeTailCall();
 			} else {
 				this.codeBlock.codeRetVal();
 			}
@@ -1778,7 +2814,9 @@ class Compiler {
 						);
 					}
 				}
+				this.readVarNames = this.collectReadVarNames(expr.statement, []);
 				let ret = this.evalStatement(expr.statement);
+				this.readVarNames = null;
 				if (ret.isError()) {
 					this.context.removeFunction(evalFunc.functionKey());
 					return ret;
@@ -1789,6 +2827,7 @@ class Compiler {
 					this.context.removeFunction(evalFunc.functionKey());
 					return EvalError.noFunctionReturn(evalFunc.functionKey()).fromExpr(expr.statement);
 				}
+				this.codeBlock.optimize();
 				this.popScope();
 				this.codeBlock = oldCodeBlock;
 			} // End Compile function
@@ -1818,12 +2857,15 @@ class Compiler {
 						i - parameterList.parameterCount - 4
 					);
 				}
+				this.readVarNames = this.collectReadVarNames(expr.statement, []);
 				let ret = this.evalStatement(expr.statement);
+				this.readVarNames = null;
 				if (ret.isError()) {
 					this.context.removeProcedure(evalProc.procedureKey());
 					return ret;
 				}
 				this.codeBlock.codeRet();
+				this.codeBlock.optimize();
 				this.popScope();
 				this.codeBlock = oldCodeBlock;
 			} // End Compile procedure
@@ -1853,7 +2895,7 @@ class Compiler {
 			} else if (proc.codeBlockIndex !== -1) {
 				this.codeBlock.codeCall(proc.codeBlockIndex);
 			} else {
-				this.codeBlock.codeCallAbstract(proc.abstractIndex);
+				this.codeBlock.codeCallAbstractProc(proc.abstractIndex);
 			}
 			return EVAL_RESULT_OK;
 		}
@@ -1953,6 +2995,8 @@ class Compiler {
 				}
 				if (actAsType.underlyingType.isRef === true) {
 					this.codeBlock.codeCreateArray(0);
+				} else if (this.isByteItemType(actAsType.underlyingType)) {
+					this.codeBlock.codeCreateByteArray(0);
 				} else {
 					this.codeBlock.codeCreateBasicArray(0);
 				}
@@ -2084,7 +3128,11 @@ class Compiler {
 			}
 			// Allocate the array
 			if (itemType.isRef === false) {
-				this.codeBlock.codeCreateBasicArray(expr.itemCount);
+				if (this.isByteItemType(itemType)) {
+					this.codeBlock.codeCreateByteArray(expr.itemCount);
+				} else {
+					this.codeBlock.codeCreateBasicArray(expr.itemCount);
+				}
 			} else {
 				this.codeBlock.codeCreateArray(expr.itemCount);
 			}
@@ -2111,6 +3159,28 @@ class Compiler {
 				if (leftType !== EVAL_TYPE_BOOLEAN) {
 					return EvalError.wrongType(leftType, "boolean").fromExpr(expr.left);
 				}
+				// true and x, false or x are x, false and x, true or x never evaluate x
+				let leftValue = this.codeBlock.dropConstCondition();
+				if (leftValue !== -1) {
+					let isShortCut = (expr.operator === TOK_AND) === (leftValue === 0);
+					let deadMark = isShortCut ? this.codeBlock.startDeadCode() : null;
+					let rightType = this.eval(expr.right);
+					if (rightType.isError()) {
+						return rightType;
+					}
+					if (rightType !== EVAL_TYPE_BOOLEAN) {
+						return EvalError.wrongType(rightType, "boolean").fromExpr(expr.right);
+					}
+					if (isShortCut) {
+						this.dropDeadCode(deadMark);
+						this.codeBlock.codePush(leftValue);
+					}
+					return EVAL_TYPE_BOOLEAN;
+				}
+				// x and true, x or false are x
+				if (expr.right.tag === "ast-value-boolean" && expr.right.boolValue === (expr.operator === TOK_AND)) {
+					return EVAL_TYPE_BOOLEAN;
+				}
 				let skipLoc = expr.operator === TOK_AND ? this.codeBlock.codeJz(0) : this.codeBlock.codeJnz(0);
 				let rightType = this.eval(expr.right);
 				if (rightType.isError()) {
@@ -2140,6 +3210,9 @@ class Compiler {
 				if (rightType.typeKey() !== leftType.typeKey()) {
 					return EvalError.wrongType(rightType, leftType.typeKey()).fromExpr(expr.right);
 				}
+				if (leftType === EVAL_TYPE_TEXT && this.codeBlock.foldConcat()) {
+					return leftType;
+				}
 				this.codeBlock.codePush(2);
 				if (leftType === EVAL_TYPE_TEXT) {
 					this.codeBlock.codeCallNative(this.context.getFunction("concat(text,text)").nativeIndex);
@@ -2164,6 +3237,8 @@ class Compiler {
 				}
 				if (leftType.isRef) {
 					this.codeBlock.codeArrayTimes();
+				} else if (this.isByteItemType(leftType)) {
+					this.codeBlock.codeByteArrayTimes();
 				} else {
 					this.codeBlock.codeBasicArrayTimes();
 				}
@@ -2200,6 +3275,14 @@ class Compiler {
 				if (leftType !== EVAL_TYPE_INTEGER && leftType !== EVAL_TYPE_REAL) {
 					return EvalError.wrongType(leftType, "integer or real").fromExpr(expr.left);
 				}
+				// 0 + x and 1 * x are x
+				let isLeftIdentity = leftType === EVAL_TYPE_INTEGER && (
+					(expr.operator === TOK_ADD && this.codeBlock.lastOpIsPushOf(0)) ||
+					(expr.operator === TOK_MUL && this.codeBlock.lastOpIsPushOf(1))
+				);
+				if (isLeftIdentity) {
+					this.codeBlock.dropLastOp();
+				}
 				let rightType = this.eval(expr.right);
 				if (rightType.isError()) {
 					return rightType;
@@ -2207,6 +3290,9 @@ class Compiler {
 				if (rightType !== leftType) {
 					return EvalError.wrongType(rightType, leftType.typeKey()).fromExpr(expr.right);
 				}
+				if (isLeftIdentity) {
+					return leftType;
+				}
 				if (leftType === EVAL_TYPE_INTEGER) {
 					if (expr.operator === TOK_ADD) {
 						this.codeBlock.codeAdd();
@@ -2352,6 +3438,10 @@ class Compiler {
 				this.codeBlock.codePushIndirect(v.offset);
 			} else {
 				if (v.isGlobal) {
+					// the functions can read the constants
+					if (v.isConst) {
+						this.codeBlock.shareSlot(v.offset);
+					}
 					this.codeBlock.codePushGlobal(v.offset);
 				} else {
 					this.codeBlock.codePushLocal(v.offset);
@@ -2586,7 +3676,7 @@ class Compiler {
 				this.pushScopeBlock();
 				this.codeBlock.codePush(0);
 				this.codeBlock.codePushPtrOffset();
-				this.scope.addVariable(expr.whens[i].varName, caseType.fields[fieldIndex].fieldType, true);
+				this.addPushedVariable(expr.whens[i].varName, caseType.fields[fieldIndex].fieldType, true);
 				let thenType = this.eval(expr.whens[i].thenExpr);
 				if (thenType.isError()) {
 					return thenType;
@@ -13,6 +13,68 @@ class NativeFunctionManager {
 		return i;
 	}
 	
+	// the integer at the start of str read like the C atol, 0 when there is none
+	static parseIntegerPrefix(str) {
+		let pos = 0;
+		while (pos < str.length && (str[pos] === " " || (str[pos] >= "\t" && str[pos] <= "\r"))) {
+			pos++;
+		}
+		let negative = false;
+		if (pos < str.length && (str[pos] === "-" || str[pos] === "+")) {
+			negative = str[pos] === "-";
+			pos++;
+		}
+		let value = 0;
+		while (pos < str.length && str[pos] >= "0" && str[pos] <= "9") {
+			value = value * 10 + (str.charCodeAt(pos) - 48);
+			pos++;
+		}
+		return negative ? -value : value;
+	}
+	
+	// sorts the array on the stack in place, after a copy when it is shared
+	static sortArray(sm, refTag, compare, isReverse) {
+		if (sm.stack[sm.sp - 1] !== 1) {
+			return StackMachineError.nativeArgCountMismatch();
+		}
+		let refManError = new PlwRefManagerError();
+		let refId = sm.refMan.makeMutable(sm.stack[sm.sp - 2], refManError);
+		if (refManError.hasError()) {
+			return StackMachineError.referenceManagerError(refManError);
+		}
+		sm.stack[sm.sp - 2] = refId;
+		let ref = sm.refMan.getRefOfType(refId, refTag, refManError);
+		if (refManError.hasError()) {
+			return StackMachineError.referenceManagerError(refManError);
+		}
+		ref.ptr.sort(compare);
+		if (isReverse) {
+			ref.ptr.reverse();
+		}
+		sm.sp -= 1;
+		return null;
+	}
+	
+	static compareNumbers(a, b) {
+		return a < b ? -1 : a > b ? 1 : 0;
+	}
+	
+	// by code point, the order of the UTF-8 bytes compared by the C vm
+	static compareTexts(str1, str2) {
+		let i = 0;
+		let j = 0;
+		while (i < str1.length && j < str2.length) {
+			let c1 = str1.codePointAt(i);
+			let c2 = str2.codePointAt(j);
+			if (c1 !== c2) {
+				return c1 < c2 ? -1 : 1;
+			}
+			i += c1 > 0xFFFF ? 2 : 1;
+			j += c2 > 0xFFFF ? 2 : 1;
+		}
+		return i < str1.length ? 1 : j < str2.length ? -1 : 0;
+	}
+	
 	static initStdNativeFunctions(compilerContext) {
 		let nativeFunctionManager = new NativeFunctionManager();
 		
@@ -1203,6 +1265,146 @@ class NativeFunctionManager {
 			})
 		));
 
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"parse_integers",
+			new EvalResultParameterList(2, [
+				new EvalResultParameter("t", EVAL_TYPE_TEXT),
+				new EvalResultParameter("s", EVAL_TYPE_TEXT)
+			]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)),
+			nativeFunctionManager.addFunction(function(sm) {
+				if (sm.stack[sm.sp - 1] !== 2) {
+					return StackMachineError.nativeArgCountMismatch();
+				}
+				let refManError = new PlwRefManagerError();
+				let refId = sm.stack[sm.sp - 3];
+				let sepId = sm.stack[sm.sp - 2];
+				let ref = sm.refMan.getRefOfType(refId, PLW_TAG_REF_STRING, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				let sep = sm.refMan.getRefOfType(sepId, PLW_TAG_REF_STRING, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				// an empty separator leaves the text in one piece
+				let strs = sep.str === "" ? [ref.str] : ref.str.split(sep.str);
+				let values = new Array(strs.length);
+				for (let i = 0; i < strs.length; i++) {
+					values[i] = NativeFunctionManager.parseIntegerPrefix(strs[i]);
+				}
+				let resultId = PlwBasicArrayRef.make(sm.refMan, values.length, values);
+				sm.refMan.decRefCount(refId, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				sm.refMan.decRefCount(sepId, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				sm.stack[sm.sp - 3] = resultId;
+				sm.stackMap[sm.sp - 3] = true;
+				sm.sp -= 2;
+				return null;
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"scan_integers",
+			new EvalResultParameterList(1, [new EvalResultParameter("t", EVAL_TYPE_TEXT)]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)),
+			nativeFunctionManager.addFunction(function(sm) {
+				if (sm.stack[sm.sp - 1] !== 1) {
+					return StackMachineError.nativeArgCountMismatch();
+				}
+				let refManError = new PlwRefManagerError();
+				let refId = sm.stack[sm.sp - 2];
+				let ref = sm.refMan.getRefOfType(refId, PLW_TAG_REF_STRING, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				// a minus sign right before the digits makes the integer negative
+				let matches = ref.str.match(/-?[0-9]+/g) || [];
+				let values = new Array(matches.length);
+				for (let i = 0; i < matches.length; i++) {
+					values[i] = NativeFunctionManager.parseIntegerPrefix(matches[i]);
+				}
+				let resultId = PlwBasicArrayRef.make(sm.refMan, values.length, values);
+				sm.refMan.decRefCount(refId, refManError);
+				if (refManError.hasError()) {
+					return StackMachineError.referenceManagerError(refManError);
+				}
+				sm.stack[sm.sp - 2] = resultId;
+				sm.stackMap[sm.sp - 2] = true;
+				sm.sp -= 1;
+				return null;
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)),
+			nativeFunctionManager.addFunction(function(sm) {
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_BASIC_ARRAY, NativeFunctionManager.compareNumbers, false);
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_REAL)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_REAL)),
+			nativeFunctionManager.addFunction(function(sm) {
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_BASIC_ARRAY, NativeFunctionManager.compareNumbers, false);
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_TEXT)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_TEXT)),
+			nativeFunctionManager.addFunction(function(sm) {
+				let refManError = new PlwRefManagerError();
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_ARRAY, function(refId1, refId2) {
+					let str1 = sm.refMan.getRefOfType(refId1, PLW_TAG_REF_STRING, refManError).str;
+					let str2 = sm.refMan.getRefOfType(refId2, PLW_TAG_REF_STRING, refManError).str;
+					return NativeFunctionManager.compareTexts(str1, str2);
+				}, false);
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"reverse_sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_INTEGER)),
+			nativeFunctionManager.addFunction(function(sm) {
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_BASIC_ARRAY, NativeFunctionManager.compareNumbers, true);
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"reverse_sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_REAL)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_REAL)),
+			nativeFunctionManager.addFunction(function(sm) {
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_BASIC_ARRAY, NativeFunctionManager.compareNumbers, true);
+			})
+		));
+		
+		compilerContext.addFunction(EvalResultFunction.fromNative(
+			"reverse_sort",
+			new EvalResultParameterList(1, [new EvalResultParameter("a", compilerContext.addType(new EvalTypeArray(EVAL_TYPE_TEXT)))]),
+			compilerContext.addType(new EvalTypeArray(EVAL_TYPE_TEXT)),
+			nativeFunctionManager.addFunction(function(sm) {
+				let refManError = new PlwRefManagerError();
+				return NativeFunctionManager.sortArray(sm, PLW_TAG_REF_ARRAY, function(refId1, refId2) {
+					let str1 = sm.refMan.getRefOfType(refId1, PLW_TAG_REF_STRING, refManError).str;
+					let str2 = sm.refMan.getRefOfType(refId2, PLW_TAG_REF_STRING, refManError).str;
+					return NativeFunctionManager.compareTexts(str1, str2);
+				}, true);
+			})
+		));
+
 		return nativeFunctionManager;
 	}
 }
@@ -18,6 +18,10 @@ if (process.argv.length < 3) {
 	process.exit(1);
 }
 
+// --peephole prints the instructions removed by the peephole passes
+const isPeepholeReport = process.argv.length > 3 && process.argv[3] === "--peephole";
+let rootCodeBlocks = [];
+
 const sourceCode = fs.readFileSync(process.argv[2], 'utf8');
 
 let tokenReader = new TokenReader(sourceCode, 1, 1);
@@ -36,6 +40,10 @@ while (parser.peekToken() !== TOK_EOF) {
 		console.log(result);
 		break;
 	} else {
+		compiler.codeBlock.optimize();
+		if (isPeepholeReport) {
+			rootCodeBlocks[rootCodeBlocks.length] = compiler.codeBlock;
+		}
 		let smRet = stackMachine.execute(compiler.codeBlock, compilerContext.codeBlocks, nativeFunctionManager.functions);
 		while (smRet !== null && smRet.errorMsg === "@get_char") {
 			let buffer = new Int8Array(1);
@@ -52,6 +60,10 @@ while (parser.peekToken() !== TOK_EOF) {
 	}
 }
 
+if (isPeepholeReport) {
+	console.log(CodeBlock.peepholeReport([...compilerContext.codeBlocks, ...rootCodeBlocks]));
+}
+
 console.log("done");
 
 
@@ -1,5 +1,8 @@
 "use strict";
 
+// written at the start of the .plwc files, to bump whenever opcodes are added, renumbered or change
+const OPCODE_VERSION									= 1;
+
 // no arg
 
 const OPCODE_SUSPEND									= 1;
@@ -44,36 +47,62 @@ const OPCODE_NEXT										= 39;
 const OPCODE_ENDED										= 40;
 const OPCODE_BASIC_ARRAY_TIMES							= 41;
 const OPCODE_ARRAY_TIMES								= 42;
+const OPCODE_BYTE_ARRAY_TIMES							= 43;
 
-const OPCODE1_MAX										= 42;
+const OPCODE1_MAX										= 43;
 			
 // One arg			
 			
-const OPCODE_JZ											= 43;
-const OPCODE_JNZ										= 44;
-const OPCODE_JMP										= 45;
-const OPCODE_PUSH										= 46;
-const OPCODE_PUSH_GLOBAL								= 47;
-const OPCODE_PUSH_GLOBAL_FOR_MUTATE						= 48;
-const OPCODE_PUSH_LOCAL									= 49;
-const OPCODE_PUSH_LOCAL_FOR_MUTATE						= 50;
-const OPCODE_PUSH_INDIRECTION							= 51;
-const OPCODE_PUSH_INDIRECT								= 52;
-const OPCODE_PUSH_INDIRECT_FOR_MUTATE					= 53;
-const OPCODE_POP_GLOBAL									= 54;
-const OPCODE_POP_LOCAL									= 55;
-const OPCODE_POP_INDIRECT								= 56;
-const OPCODE_POP_VOID									= 57;
-const OPCODE_CREATE_STRING								= 58;
-const OPCODE_CREATE_RECORD								= 59;
-const OPCODE_CREATE_BASIC_ARRAY							= 60;
-const OPCODE_CREATE_ARRAY							 	= 61;
-const OPCODE_CALL										= 62;
-const OPCODE_CALL_ABSTRACT								= 63;
-const OPCODE_CALL_NATIVE								= 64;
-const OPCODE_INIT_GENERATOR								= 65;
-const OPCODE_CREATE_EXCEPTION_HANDLER					= 66;
-const OPCODE_PUSHF										= 67;
+const OPCODE_JZ											= 44;
+const OPCODE_JNZ										= 45;
+const OPCODE_JMP										= 46;
+const OPCODE_PUSH										= 47;
+const OPCODE_PUSH_GLOBAL								= 48;
+const OPCODE_PUSH_GLOBAL_FOR_MUTATE						= 49;
+const OPCODE_PUSH_LOCAL									= 50;
+const OPCODE_PUSH_LOCAL_FOR_MUTATE						= 51;
+const OPCODE_PUSH_INDIRECTION							= 52;
+const OPCODE_PUSH_INDIRECT								= 53;
+const OPCODE_PUSH_INDIRECT_FOR_MUTATE					= 54;
+const OPCODE_POP_GLOBAL									= 55;
+const OPCODE_POP_LOCAL									= 56;
+const OPCODE_POP_INDIRECT								= 57;
+const OPCODE_POP_VOID									= 58;
+const OPCODE_CREATE_STRING								= 59;
+const OPCODE_CREATE_RECORD								= 60;
+const OPCODE_CREATE_BASIC_ARRAY							= 61;
+const OPCODE_CREATE_ARRAY							 	= 62;
+const OPCODE_CALL										= 63;
+const OPCODE_CALL_ABSTRACT								= 64;
+const OPCODE_CALL_NATIVE								= 65;
+const OPCODE_INIT_GENERATOR								= 66;
+const OPCODE_CREATE_EXCEPTION_HANDLER					= 67;
+const OPCODE_PUSHF										= 68;
+const OPCODE_PUSH_PTR_OFFSET_CONST						= 69;
+const OPCODE_ADD_CONST									= 70;
+const OPCODE_EQ_CONST									= 71;
+const OPCODE_CALL_ABSTRACT_PROC							= 72;
+const OPCODE_TAIL_CALL									= 73;
+const OPCODE_PUSH_GLOBAL_MOVE							= 74;
+const OPCODE_PUSH_LOCAL_MOVE								= 75;
+const OPCODE_PUSH_GLOBAL_BORROW						= 76;
+const OPCODE_PUSH_LOCAL_BORROW							= 77;
+const OPCODE_CREATE_BYTE_ARRAY							= 78;
+
+const OPCODE2_MAX										= 78;
+
+// Two args
+
+const OPCODE_PUSH_LOCAL_PUSH_LOCAL						= 79;
+const OPCODE_PUSH_GLOBAL_PUSH_GLOBAL					= 80;
+const OPCODE_INC_LOCAL									= 81;
+
+const OPCODE3_MAX										= 81;
+
+// Three args
+
+const OPCODE_JGT_LOCAL_LOCAL							= 82;
+const OPCODE_JLT_LOCAL_LOCAL							= 83;
 
 const PLW_OPCODES = [
 	"",
@@ -119,6 +148,7 @@ const PLW_OPCODES = [
 	"ENDED",
 	"BASIC_ARRAY_TIMES",
 	"ARRAY_TIMES",
+	"BYTE_ARRAY_TIMES",
 	"JZ",
 	"JNZ",
 	"JMP",
@@ -143,6 +173,21 @@ const PLW_OPCODES = [
 	"CALL_NATIVE",
 	"INIT_GENERATOR",
 	"CREATE_EXCEPTION_HANDLER",
-	"PUSHF"
+	"PUSHF",
+	"PUSH_PTR_OFFSET_CONST",
+	"ADD_CONST",
+	"EQ_CONST",
+	"CALL_ABSTRACT_PROC",
+	"TAIL_CALL",
+	"PUSH_GLOBAL_MOVE",
+	"PUSH_LOCAL_MOVE",
+	"PUSH_GLOBAL_BORROW",
+	"PUSH_LOCAL_BORROW",
+	"CREATE_BYTE_ARRAY",
+	"PUSH_LOCAL_PUSH_LOCAL",
+	"PUSH_GLOBAL_PUSH_GLOBAL",
+	"INC_LOCAL",
+	"JGT_LOCAL_LOCAL",
+	"JLT_LOCAL_LOCAL"
 ];
 
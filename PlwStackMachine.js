@@ -210,6 +210,7 @@ class StackMachine {
 			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
 		}
 		let refId = this.stack[this.sp - 2];
+		let isCounted = this.stackMap[this.sp - 2];
 		let offset = this.stack[this.sp - 1];
 		this.refMan.getOffsetValue(refId, offset, false, this.refManError, this.offsetVal);
 		if (this.refManError.hasError()) {
@@ -224,9 +225,12 @@ class StackMachine {
 			}
 		}
 		this.sp--;
-		this.refMan.decRefCount(refId, this.refManError);
-		if (this.refManError.hasError()) {
-			return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+		// a borrowed ref was pushed without a count
+		if (isCounted === true) {
+			this.refMan.decRefCount(refId, this.refManError);
+			if (this.refManError.hasError()) {
+				return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+			}
 		}
 		return null;
 	}
@@ -832,6 +836,7 @@ class StackMachine {
 		case OPCODE_ENDED:
 			return this.opcodeEnded();
 		case OPCODE_BASIC_ARRAY_TIMES:
+		case OPCODE_BYTE_ARRAY_TIMES:
 			return this.opcodeBasicArrayTimes();
 		case OPCODE_ARRAY_TIMES:
 			return this.opcodeArrayTimes();
@@ -1094,6 +1099,51 @@ class StackMachine {
 		return null;
 	}
 	
+	// the last read of a slot, its ref goes to the stack without a count and the slot is cleared
+	opcodePushGlobalMove(offset) {
+		if (offset < 0 || offset >= this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp] = this.stack[offset];
+		this.stackMap[this.sp] = this.stackMap[offset];
+		this.stack[offset] = 0;
+		this.stackMap[offset] = false;
+		this.sp++;
+		return null;
+	}
+	
+	opcodePushLocalMove(offset) {
+		if (this.bp + offset < 0 || this.bp + offset >= this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp] = this.stack[this.bp + offset];
+		this.stackMap[this.sp] = this.stackMap[this.bp + offset];
+		this.stack[this.bp + offset] = 0;
+		this.stackMap[this.bp + offset] = false;
+		this.sp++;
+		return null;
+	}
+	
+	opcodePushGlobalBorrow(offset) {
+		if (offset < 0 || offset >= this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp] = this.stack[offset];
+		this.stackMap[this.sp] = false;
+		this.sp++;
+		return null;
+	}
+	
+	opcodePushLocalBorrow(offset) {
+		if (this.bp + offset < 0 || this.bp + offset >= this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp] = this.stack[this.bp + offset];
+		this.stackMap[this.sp] = false;
+		this.sp++;
+		return null;
+	}
+	
 	opcodePushIndirect(offset) {
 		if (this.bp + offset < 0 || this.bp + offset >= this.sp) {
 			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
@@ -1251,6 +1301,39 @@ class StackMachine {
 		return null;
 	}
 
+	// replaces the current frame by the frame of the callee, which returns directly to the caller
+	opcodeTailCall(arg1) {
+		if (this.bp < 4 || this.bp > this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		let previousBp = this.stack[this.bp - 1];
+		let previousIp = this.stack[this.bp - 2];
+		let previousCodeBlockId = this.stack[this.bp - 3];
+		let argCount = this.stack[this.bp - 4];
+		let newArgCount = this.stack[this.sp - 1];
+		if (this.bp < 4 + argCount || this.sp - 1 - newArgCount < this.bp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		for (let i = this.sp - newArgCount - 2; i >= this.bp - 4 - argCount; i--) {
+			if (this.stackMap[i] === true) {
+				this.refMan.decRefCount(this.stack[i], this.refManError);
+				if (this.refManError.hasError()) {
+					return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+				}
+			}
+		}
+		let dest = this.bp - 4 - argCount;
+		for (let i = 0; i <= newArgCount; i++) {
+			this.stack[dest + i] = this.stack[this.sp - newArgCount - 1 + i];
+			this.stackMap[dest + i] = this.stackMap[this.sp - newArgCount - 1 + i];
+		}
+		this.sp = dest + newArgCount + 1;
+		this.bp = previousBp;
+		this.codeBlockId = previousCodeBlockId;
+		this.ip = previousIp;
+		return this.opcodeCall(arg1);
+	}
+
 	opcodeCreateExceptionHandler(arg1) {
 		this.stack[this.sp] = PlwExceptionHandlerRef.make(this.refMan, this.codeBlockId, arg1, this.bp);
 		this.stackMap[this.sp] = true;
@@ -1268,6 +1351,99 @@ class StackMachine {
 		return null;
 	}
 
+	opcodePushPtrOffsetConst(offset) {
+		if (this.sp < 1) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		let refId = this.stack[this.sp - 1];
+		let isCounted = this.stackMap[this.sp - 1];
+		this.refMan.getOffsetValue(refId, offset, false, this.refManError, this.offsetVal);
+		if (this.refManError.hasError()) {
+			return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp - 1] = this.offsetVal.val;
+		this.stackMap[this.sp - 1] = this.offsetVal.isRef;
+		if (this.offsetVal.isRef === true) {
+			this.refMan.incRefCount(this.stack[this.sp - 1], this.refManError);
+			if (this.refManError.hasError()) {
+				return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+			}
+		}
+		if (isCounted === true) {
+			this.refMan.decRefCount(refId, this.refManError);
+			if (this.refManError.hasError()) {
+				return StackMachineError.referenceManagerError(this.refManError).fromCode(this.codeBlockId, this.ip);
+			}
+		}
+		return null;
+	}
+	
+	opcodeAddConst(arg1) {
+		if (this.sp < 1) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp - 1] += arg1;
+		return null;
+	}
+	
+	opcodeEqConst(arg1) {
+		if (this.sp < 1) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.sp - 1] = this.stack[this.sp - 1] === arg1 ? 1 : 0;
+		return null;
+	}
+	
+	opcodePushLocalPushLocal(offset1, offset2) {
+		let ret = this.opcodePushLocal(offset1);
+		if (ret !== null) {
+			return ret;
+		}
+		return this.opcodePushLocal(offset2);
+	}
+	
+	opcodePushGlobalPushGlobal(offset1, offset2) {
+		let ret = this.opcodePushGlobal(offset1);
+		if (ret !== null) {
+			return ret;
+		}
+		return this.opcodePushGlobal(offset2);
+	}
+	
+	opcodeIncLocal(offset, arg2) {
+		if (this.bp + offset < 0 || this.bp + offset >= this.sp) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		this.stack[this.bp + offset] += arg2;
+		return null;
+	}
+	
+	opcodeJgtLocalLocal(offset1, offset2, arg3) {
+		if (
+			this.bp + offset1 < 0 || this.bp + offset1 >= this.sp ||
+			this.bp + offset2 < 0 || this.bp + offset2 >= this.sp
+		) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		if (this.stack[this.bp + offset1] > this.stack[this.bp + offset2]) {
+			this.ip = arg3;
+		}
+		return null;
+	}
+	
+	opcodeJltLocalLocal(offset1, offset2, arg3) {
+		if (
+			this.bp + offset1 < 0 || this.bp + offset1 >= this.sp ||
+			this.bp + offset2 < 0 || this.bp + offset2 >= this.sp
+		) {
+			return StackMachineError.stackAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
+		}
+		if (this.stack[this.bp + offset1] < this.stack[this.bp + offset2]) {
+			this.ip = arg3;
+		}
+		return null;
+	}
+
 	opcode2(code, arg1) {
 		switch(code) {
 		case OPCODE_JZ:
@@ -1305,13 +1481,25 @@ class StackMachine {
 		case OPCODE_CREATE_RECORD:
 			return this.opcodeCreateRecord(arg1);
 		case OPCODE_CREATE_BASIC_ARRAY:
+		case OPCODE_CREATE_BYTE_ARRAY:
 			return this.opcodeCreateBasicArray(arg1);
 		case OPCODE_CREATE_ARRAY:
 			return this.opcodeCreateArray(arg1);
 		case OPCODE_CALL:
 			return this.opcodeCall(arg1);
 		case OPCODE_CALL_ABSTRACT:
+		case OPCODE_CALL_ABSTRACT_PROC:
 			return this.opcodeCallAbstract(arg1);
+		case OPCODE_TAIL_CALL:
+			return this.opcodeTailCall(arg1);
+		case OPCODE_PUSH_GLOBAL_MOVE:
+			return this.opcodePushGlobalMove(arg1);
+		case OPCODE_PUSH_LOCAL_MOVE:
+			return this.opcodePushLocalMove(arg1);
+		case OPCODE_PUSH_GLOBAL_BORROW:
+			return this.opcodePushGlobalBorrow(arg1);
+		case OPCODE_PUSH_LOCAL_BORROW:
+			return this.opcodePushLocalBorrow(arg1);
 		case OPCODE_CALL_NATIVE:
 			return this.opcodeCallNative(arg1);
 		case OPCODE_INIT_GENERATOR:
@@ -1320,6 +1508,36 @@ class StackMachine {
 			return this.opcodeCreateExceptionHandler(arg1);
 		case OPCODE_PUSHF:
 			return this.opcodePushf(arg1);
+		case OPCODE_PUSH_PTR_OFFSET_CONST:
+			return this.opcodePushPtrOffsetConst(arg1);
+		case OPCODE_ADD_CONST:
+			return this.opcodeAddConst(arg1);
+		case OPCODE_EQ_CONST:
+			return this.opcodeEqConst(arg1);
+		default:
+			return StackMachineError.unknownOp().fromCode(this.codeBlockId, this.ip);
+		}
+	}
+	
+	opcode3(code, arg1, arg2) {
+		switch(code) {
+		case OPCODE_PUSH_LOCAL_PUSH_LOCAL:
+			return this.opcodePushLocalPushLocal(arg1, arg2);
+		case OPCODE_PUSH_GLOBAL_PUSH_GLOBAL:
+			return this.opcodePushGlobalPushGlobal(arg1, arg2);
+		case OPCODE_INC_LOCAL:
+			return this.opcodeIncLocal(arg1, arg2);
+		default:
+			return StackMachineError.unknownOp().fromCode(this.codeBlockId, this.ip);
+		}
+	}
+	
+	opcode4(code, arg1, arg2, arg3) {
+		switch(code) {
+		case OPCODE_JGT_LOCAL_LOCAL:
+			return this.opcodeJgtLocalLocal(arg1, arg2, arg3);
+		case OPCODE_JLT_LOCAL_LOCAL:
+			return this.opcodeJltLocalLocal(arg1, arg2, arg3);
 		default:
 			return StackMachineError.unknownOp().fromCode(this.codeBlockId, this.ip);
 		}
@@ -1329,18 +1547,33 @@ class StackMachine {
 		let code = 0;
 		let ret = null;
 		let arg1 = 0;
+		let arg2 = 0;
+		let arg3 = 0;
 		while (this.ip < this.codeBlocks[this.codeBlockId].codeSize) {
 			code = this.codeBlocks[this.codeBlockId].codes[this.ip];
 			this.ip++;
 			if (code <= OPCODE1_MAX) {
 				ret = this.opcode1(code);
 			} else {
-				if (this.ip >= this.codeBlocks[this.codeBlockId].codeSize) {
+				let argCount = code <= OPCODE2_MAX ? 1 : code <= OPCODE3_MAX ? 2 : 3;
+				if (this.ip + argCount > this.codeBlocks[this.codeBlockId].codeSize) {
 					return StackMachineError.codeAccessOutOfBound().fromCode(this.codeBlockId, this.ip);
 				}
 				arg1 = this.codeBlocks[this.codeBlockId].codes[this.ip];
 				this.ip++;
-				ret = this.opcode2(code, arg1);
+				if (argCount === 1) {
+					ret = this.opcode2(code, arg1);
+				} else {
+					arg2 = this.codeBlocks[this.codeBlockId].codes[this.ip];
+					this.ip++;
+					if (argCount === 2) {
+						ret = this.opcode3(code, arg1, arg2);
+					} else {
+						arg3 = this.codeBlocks[this.codeBlockId].codes[this.ip];
+						this.ip++;
+						ret = this.opcode4(code, arg1, arg2, arg3);
+					}
+				}
 			}
 			if (ret !== null) {
 				return ret;
@@ -1362,9 +1595,13 @@ class StackMachine {
 				if (opcode <= OPCODE1_MAX) {
 					println(prefix + opcodeName);
 				} else {
-					i++;
-					let arg1 = codeBlock.codes[i];
-					println(prefix + opcodeName + "                              ".substring(0, 26 - opcodeName.length) + arg1);
+					let argCount = opcode <= OPCODE2_MAX ? 1 : opcode <= OPCODE3_MAX ? 2 : 3;
+					let args = "";
+					for (let k = 0; k < argCount; k++) {
+						i++;
+						args += (k > 0 ? " " : "") + codeBlock.codes[i];
+					}
+					println(prefix + opcodeName + "                              ".substring(0, 26 - opcodeName.length) + args);
 				}
 			}
 		}
@@ -55,6 +55,7 @@ function execLoop() {
 			printTextOutObject(result);
 			break;
 		} else {
+			compiler.codeBlock.optimize();
 			let smRet = stackMachine.execute(compiler.codeBlock, compilerContext.codeBlocks, nativeFunctionManager.functions);
 			if (smRet !== null && smRet.errorMsg === "@get_char") {
 				setConsoleInStatus("@get_char");
@@ -83,13 +84,15 @@ function compileLoop() {
 			return;
 		}
 		if (compiler.codeBlock.codeSize > 0) {
+			compiler.codeBlock.optimize();
 			rootCodeBlocks[rootCodeBlocks.length] = compiler.codeBlock;
 		}
 	}
 	let codeBlockId = compilerContext.codeBlocks.length;
 	let codeBlocks = [...compilerContext.codeBlocks, ...rootCodeBlocks];
+	printTextOut(CodeBlock.peepholeReport(codeBlocks));
 	let codeBlockCount = codeBlocks.length;
-	let compiled = "" + codeBlockCount + " " + codeBlockId + "\n";
+	let compiled = "PLWC " + OPCODE_VERSION + "\n" + codeBlockCount + " " + codeBlockId + "\n";
 	for (let i = 0; i < codeBlockCount; i++) {
 		let cb = codeBlocks[i];
 		compiled += cb.blockName.length + " " + cb.blockName + "\n" + cb.strConstSize + "\n";
@@ -25,8 +25,8 @@ void PlwAbstractRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	abstractRef->tag->Destroy(refMan, ref, error);	
 }
 
-void PlwAbstractRef_QuickDestroy(void *ref) {
+void PlwAbstractRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwAbstractRef *abstractRef = ref;
-	abstractRef->tag->QuickDestroy(ref);
+	abstractRef->tag->QuickDestroy(refMan, ref);
 }
 
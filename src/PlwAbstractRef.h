@@ -11,12 +11,17 @@ typedef struct PlwAbstractRefTag {
 	PlwRefId (*ShallowCopy)(PlwRefManager *refMan, void *ref, PlwError *error);
 	PlwBoolean (*CompareTo)(PlwRefManager *refMan, void *ref1, void *ref2, PlwError *error);
 	void (*Destroy)(PlwRefManager *refMan, void *ref, PlwError *error);
-	void (*QuickDestroy)(void *ref);
+	void (*QuickDestroy)(PlwRefManager *refMan, void *ref);
 } PlwAbstractRefTag;
 
 typedef struct PlwAbstractRef {
 	const PlwAbstractRefTag *tag;
 	PlwInt refCount;
+#ifdef PLW_DIRECT_REFS
+	/* the list of the live refs of the ref manager, that frees them on destroy */
+	struct PlwAbstractRef *previous;
+	struct PlwAbstractRef *next;
+#endif
 } PlwAbstractRef;
 
 void PlwAbstractRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error);
@@ -29,6 +34,6 @@ PlwBoolean PlwAbstractRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref
 
 void PlwAbstractRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwAbstractRef_QuickDestroy(void *ref);
+void PlwAbstractRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
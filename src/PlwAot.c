@@ -0,0 +1,110 @@
+#include "PlwAot.h"
+#include "PlwNative.h"
+#include <stdio.h>
+
+const char * const PlwAotErrorInvalidEntry = "PlwAotErrorInvalidEntry";
+
+void PlwAot_InvalidEntry(PlwStackMachine *sm, PlwError *error) {
+	error->code = PlwAotErrorInvalidEntry;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Code block %ld cannot be entered at %ld", sm->codeBlockId, sm->ip);
+}
+
+static void PlwAot_PrintError(PlwError *error) {
+	printf("%s: %s\n", error->code, error->message);
+}
+
+static void PlwAot_FreeCodeBlocks(PlwCodeBlock *codeBlocks, PlwInt codeBlockCount) {
+	PlwInt i;
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwFree(codeBlocks[i].floatConsts);
+		PlwFree(codeBlocks[i].instructions);
+		PlwFree(codeBlocks[i].callCaches);
+	}
+	PlwFree(codeBlocks);
+}
+
+/* the code blocks point to the data of the translated program, only the floats and the instructions are allocated */
+static PlwCodeBlock *PlwAot_LoadCodeBlocks(PlwInt codeBlockCount, const PlwAotCodeBlock *aotCodeBlocks, PlwError *error) {
+	PlwCodeBlock *codeBlocks;
+	PlwCodeBlock *cb;
+	PlwWord w;
+	PlwInt i, j;
+
+	codeBlocks = PlwAlloc(codeBlockCount * sizeof(PlwCodeBlock), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwCodeBlock_Init(&codeBlocks[i], aotCodeBlocks[i].name);
+	}
+	for (i = 0; i < codeBlockCount; i++) {
+		cb = &codeBlocks[i];
+		cb->codeCount = aotCodeBlocks[i].codeCount;
+		cb->codes = aotCodeBlocks[i].codes;
+		cb->strConstCount = aotCodeBlocks[i].strConstCount;
+		cb->strConsts = aotCodeBlocks[i].strConsts;
+		cb->floatConsts = PlwAlloc(aotCodeBlocks[i].floatConstCount * sizeof(PlwFloat), error);
+		if (PlwIsError(error)) {
+			PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+			return NULL;
+		}
+		cb->floatConstCount = aotCodeBlocks[i].floatConstCount;
+		for (j = 0; j < cb->floatConstCount; j++) {
+			w.i = aotCodeBlocks[i].floatConsts[j];
+			cb->floatConsts[j] = w.f;
+		}
+		PlwCodeBlock_Decode(cb, codeBlockCount, PlwNativeFunctionCount, error);
+		if (PlwIsError(error)) {
+			PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+			return NULL;
+		}
+	}
+	/* the handlers rely on maxStackDepth and resultCount like in plw */
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwCodeBlock_Verify(&codeBlocks[i], codeBlocks, PlwNativeFunctionArgCounts, PlwNativeFunctionResultCounts, NULL, NULL, error);
+		if (PlwIsError(error)) {
+			PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+			return NULL;
+		}
+	}
+	return codeBlocks;
+}
+
+int PlwAot_Main(PlwInt codeBlockCount, PlwInt codeBlockId, const PlwAotCodeBlock *aotCodeBlocks, const PlwCompiledCodeBlock *compiledCodeBlocks) {
+	PlwError error;
+	PlwCodeBlock *codeBlocks;
+	PlwStackMachine *sm;
+	PlwInt i;
+
+	PlwError_Init(&error);
+
+	codeBlocks = PlwAot_LoadCodeBlocks(codeBlockCount, aotCodeBlocks, &error);
+	if (PlwIsError(&error)) {
+		PlwAot_PrintError(&error);
+		return -1;
+	}
+
+	sm = PlwStackMachine_Create(&error);
+	if (PlwIsError(&error)) {
+		PlwAot_PrintError(&error);
+		PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+		return -1;
+	}
+
+	PlwStackMachine_SetNatives(sm, PlwNativeFunctionCount, PlwNativeFunctions);
+	PlwStackMachine_SetCodeBlocks(sm, codeBlockCount, codeBlocks);
+
+	for (i = codeBlockId; i < codeBlockCount; i++) {
+		PlwStackMachine_ExecuteCompiled(sm, i, compiledCodeBlocks, &error);
+		if (PlwIsError(&error)) {
+			PlwAot_PrintError(&error);
+			PlwStackMachine_Destroy(sm);
+			PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+			return -1;
+		}
+	}
+
+	PlwStackMachine_Destroy(sm);
+	PlwAot_FreeCodeBlocks(codeBlocks, codeBlockCount);
+	return 0;
+}
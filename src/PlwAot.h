@@ -0,0 +1,56 @@
+#ifndef PLWAOT_H_
+#define PLWAOT_H_
+
+#include "PlwCommon.h"
+#include "PlwCodeBlock.h"
+#include "PlwStackMachine.h"
+#include "PlwRefManager.h"
+#include "PlwOpcode.h"
+
+/*
+ * Runtime support of the C files written by plw2c. A translated program
+ * keeps its code blocks as data, for the opcode handlers it still calls,
+ * and runs every code block as a C function on a regular stack machine.
+ */
+
+extern const char * const PlwAotErrorInvalidEntry;
+
+typedef struct PlwAotCodeBlock {
+	char *name;
+	PlwInt codeCount;
+	PlwInt *codes;
+	PlwInt strConstCount;
+	char **strConsts;
+	PlwInt floatConstCount;
+	/* the bits of the floats, so that they are copied exactly */
+	const PlwInt *floatConsts;
+} PlwAotCodeBlock;
+
+typedef void (*PlwAotHandler1)(PlwStackMachine *sm, PlwError *error);
+typedef void (*PlwAotHandler2)(PlwStackMachine *sm, PlwInt arg1, PlwError *error);
+typedef void (*PlwAotHandler3)(PlwStackMachine *sm, PlwInt arg1, PlwInt arg2, PlwError *error);
+typedef void (*PlwAotHandler4)(PlwStackMachine *sm, PlwInt arg1, PlwInt arg2, PlwInt arg3, PlwError *error);
+
+/* stores the stack depth and the next ip of the translated code before it calls a handler or leaves */
+#define PLW_AOT_SYNC(depth, nextIp) \
+	do { sm->sp = base + (depth); sm->ip = (nextIp); } while (0)
+
+#define PLW_AOT_OP1(opcode) \
+	((PlwAotHandler1) PlwStackMachine_OpcodeHandlers[opcode].handler)(sm, error)
+
+#define PLW_AOT_OP2(opcode, arg1) \
+	((PlwAotHandler2) PlwStackMachine_OpcodeHandlers[opcode].handler)(sm, arg1, error)
+
+#define PLW_AOT_OP3(opcode, arg1, arg2) \
+	((PlwAotHandler3) PlwStackMachine_OpcodeHandlers[opcode].handler)(sm, arg1, arg2, error)
+
+#define PLW_AOT_OP4(opcode, arg1, arg2, arg3) \
+	((PlwAotHandler4) PlwStackMachine_OpcodeHandlers[opcode].handler)(sm, arg1, arg2, arg3, error)
+
+/* called when a translated code block is resumed at an ip it does not expect */
+void PlwAot_InvalidEntry(PlwStackMachine *sm, PlwError *error);
+
+/* runs the blocks from codeBlockId to the last one, like plw does, and returns the exit status */
+int PlwAot_Main(PlwInt codeBlockCount, PlwInt codeBlockId, const PlwAotCodeBlock *aotCodeBlocks, const PlwCompiledCodeBlock *compiledCodeBlocks);
+
+#endif
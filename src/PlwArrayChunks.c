@@ -0,0 +1,164 @@
+#include "PlwArrayChunks.h"
+#include <string.h>
+
+static PlwInt PlwArrayChunks_ChunkCount(PlwInt size) {
+	return (size + PLW_ARRAY_CHUNK_SIZE - 1) / PLW_ARRAY_CHUNK_SIZE;
+}
+
+/* the last chunk is only filled up to the size of the array */
+static PlwInt PlwArrayChunks_ChunkItemCount(PlwInt size, PlwInt chunkIndex) {
+	PlwInt count = size - chunkIndex * PLW_ARRAY_CHUNK_SIZE;
+	return count < PLW_ARRAY_CHUNK_SIZE ? count : PLW_ARRAY_CHUNK_SIZE;
+}
+
+PlwArrayChunk **PlwArrayChunks_Make(PlwRefManager *refMan, PlwInt *items, PlwInt size, PlwBoolean isRefs, PlwError *error) {
+	PlwArrayChunk **chunks;
+	PlwInt chunkCount = PlwArrayChunks_ChunkCount(size);
+	PlwInt i;
+	chunks = PlwRefManager_Alloc(refMan, chunkCount * sizeof(PlwArrayChunk *), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	for (i = 0; i < chunkCount; i++) {
+		chunks[i] = PlwRefManager_Alloc(refMan, sizeof(PlwArrayChunk), error);
+		if (PlwIsError(error)) {
+			for (i--; i >= 0; i--) {
+				PlwRefManager_Free(refMan, chunks[i], sizeof(PlwArrayChunk));
+			}
+			PlwRefManager_Free(refMan, chunks, chunkCount * sizeof(PlwArrayChunk *));
+			return NULL;
+		}
+		chunks[i]->refCount = 1;
+		memcpy(chunks[i]->items, items + i * PLW_ARRAY_CHUNK_SIZE, PlwArrayChunks_ChunkItemCount(size, i) * sizeof(PlwInt));
+	}
+	if (isRefs) {
+		for (i = 0; i < size; i++) {
+			PlwRefManager_IncRefCount(refMan, items[i], error);
+			if (PlwIsError(error)) {
+				return NULL;
+			}
+		}
+	}
+	return chunks;
+}
+
+PlwArrayChunk **PlwArrayChunks_Share(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwError *error) {
+	PlwArrayChunk **newChunks;
+	PlwInt chunkCount = PlwArrayChunks_ChunkCount(size);
+	PlwInt i;
+	newChunks = PlwRefManager_Alloc(refMan, chunkCount * sizeof(PlwArrayChunk *), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	for (i = 0; i < chunkCount; i++) {
+		newChunks[i] = chunks[i];
+		newChunks[i]->refCount++;
+	}
+	return newChunks;
+}
+
+PlwInt *PlwArrayChunks_MutableItem(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwInt offset, PlwBoolean isRefs, PlwError *error) {
+	PlwInt chunkIndex = offset / PLW_ARRAY_CHUNK_SIZE;
+	PlwArrayChunk *chunk = chunks[chunkIndex];
+	PlwArrayChunk *newChunk;
+	PlwInt itemCount;
+	PlwInt i;
+	if (chunk->refCount > 1) {
+		newChunk = PlwRefManager_Alloc(refMan, sizeof(PlwArrayChunk), error);
+		if (PlwIsError(error)) {
+			return NULL;
+		}
+		itemCount = PlwArrayChunks_ChunkItemCount(size, chunkIndex);
+		newChunk->refCount = 1;
+		memcpy(newChunk->items, chunk->items, itemCount * sizeof(PlwInt));
+		if (isRefs) {
+			for (i = 0; i < itemCount; i++) {
+				PlwRefManager_IncRefCount(refMan, newChunk->items[i], error);
+				if (PlwIsError(error)) {
+					return NULL;
+				}
+			}
+		}
+		chunk->refCount--;
+		chunks[chunkIndex] = newChunk;
+		chunk = newChunk;
+	}
+	return &chunk->items[offset % PLW_ARRAY_CHUNK_SIZE];
+}
+
+void PlwArrayChunks_CopyItems(PlwArrayChunk **chunks, PlwInt offset, PlwInt count, PlwInt *items) {
+	PlwArrayChunks_CopyBytes(chunks, offset * sizeof(PlwInt), count * sizeof(PlwInt), items);
+}
+
+void PlwArrayChunks_CopyBytes(PlwArrayChunk **chunks, PlwInt offset, PlwInt count, void *bytes) {
+	char *p = bytes;
+	PlwInt chunkBytes = PLW_ARRAY_CHUNK_SIZE * sizeof(PlwInt);
+	PlwInt byteIndex;
+	PlwInt byteCount;
+	while (count > 0) {
+		byteIndex = offset % chunkBytes;
+		byteCount = chunkBytes - byteIndex;
+		if (byteCount > count) {
+			byteCount = count;
+		}
+		memcpy(p, (char *) chunks[offset / chunkBytes]->items + byteIndex, byteCount);
+		p += byteCount;
+		offset += byteCount;
+		count -= byteCount;
+	}
+}
+
+void PlwArrayChunks_Gather(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwBoolean isRefs, PlwInt *items, PlwError *error) {
+	PlwInt chunkCount = PlwArrayChunks_ChunkCount(size);
+	PlwInt itemCount;
+	PlwInt i, j;
+	PlwArrayChunks_CopyItems(chunks, 0, size, items);
+	if (isRefs) {
+		for (i = 0; i < chunkCount; i++) {
+			if (chunks[i]->refCount > 1) {
+				itemCount = PlwArrayChunks_ChunkItemCount(size, i);
+				for (j = 0; j < itemCount; j++) {
+					PlwRefManager_IncRefCount(refMan, chunks[i]->items[j], error);
+					if (PlwIsError(error)) {
+						return;
+					}
+				}
+			}
+		}
+	}
+	PlwArrayChunks_QuickDestroy(refMan, chunks, size);
+}
+
+void PlwArrayChunks_Destroy(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwBoolean isRefs, PlwError *error) {
+	PlwInt chunkCount = PlwArrayChunks_ChunkCount(size);
+	PlwInt itemCount;
+	PlwInt i, j;
+	for (i = 0; i < chunkCount; i++) {
+		chunks[i]->refCount--;
+		if (chunks[i]->refCount == 0) {
+			if (isRefs) {
+				itemCount = PlwArrayChunks_ChunkItemCount(size, i);
+				for (j = 0; j < itemCount; j++) {
+					PlwRefManager_DecRefCount(refMan, chunks[i]->items[j], error);
+					if (PlwIsError(error)) {
+						return;
+					}
+				}
+			}
+			PlwRefManager_Free(refMan, chunks[i], sizeof(PlwArrayChunk));
+		}
+	}
+	PlwRefManager_Free(refMan, chunks, chunkCount * sizeof(PlwArrayChunk *));
+}
+
+void PlwArrayChunks_QuickDestroy(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size) {
+	PlwInt chunkCount = PlwArrayChunks_ChunkCount(size);
+	PlwInt i;
+	for (i = 0; i < chunkCount; i++) {
+		chunks[i]->refCount--;
+		if (chunks[i]->refCount == 0) {
+			PlwRefManager_Free(refMan, chunks[i], sizeof(PlwArrayChunk));
+		}
+	}
+	PlwRefManager_Free(refMan, chunks, chunkCount * sizeof(PlwArrayChunk *));
+}
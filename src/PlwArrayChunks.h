@@ -0,0 +1,47 @@
+#ifndef PLWARRAYCHUNKS_H_
+#define PLWARRAYCHUNKS_H_
+
+#include "PlwRefManager.h"
+
+/*
+ * Items of a large array that has been copied. The items are split in chunks
+ * of PLW_ARRAY_CHUNK_SIZE that the copies share, a copy only duplicates the
+ * table of the chunks and a write duplicates the chunk it falls in when that
+ * chunk is shared. When the items are refs, a chunk holds one count on each
+ * of them for all the arrays that share it.
+ */
+
+#define PLW_ARRAY_CHUNK_SIZE 1024
+
+/* the smaller arrays are still copied item by item */
+#define PLW_ARRAY_CHUNK_MIN_SIZE (4 * PLW_ARRAY_CHUNK_SIZE)
+
+typedef struct PlwArrayChunk {
+	PlwInt refCount;
+	PlwInt items[PLW_ARRAY_CHUNK_SIZE];
+} PlwArrayChunk;
+
+#define PlwArrayChunks_Item(chunks, offset) ((chunks)[(offset) / PLW_ARRAY_CHUNK_SIZE]->items[(offset) % PLW_ARRAY_CHUNK_SIZE])
+
+/* copies the items in new chunks, adding a count to each of them when they are refs */
+PlwArrayChunk **PlwArrayChunks_Make(PlwRefManager *refMan, PlwInt *items, PlwInt size, PlwBoolean isRefs, PlwError *error);
+
+/* makes a new table of the same chunks */
+PlwArrayChunk **PlwArrayChunks_Share(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwError *error);
+
+/* returns the item at offset for a write, after duplicating its chunk if it is shared */
+PlwInt *PlwArrayChunks_MutableItem(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwInt offset, PlwBoolean isRefs, PlwError *error);
+
+void PlwArrayChunks_CopyItems(PlwArrayChunk **chunks, PlwInt offset, PlwInt count, PlwInt *items);
+
+/* copies count bytes from the byte at offset, for the items smaller than a PlwInt */
+void PlwArrayChunks_CopyBytes(PlwArrayChunk **chunks, PlwInt offset, PlwInt count, void *bytes);
+
+/* copies all the items and releases the chunks, the counts of the refs move to the copied items */
+void PlwArrayChunks_Gather(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwBoolean isRefs, PlwInt *items, PlwError *error);
+
+void PlwArrayChunks_Destroy(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size, PlwBoolean isRefs, PlwError *error);
+
+void PlwArrayChunks_QuickDestroy(PlwRefManager *refMan, PlwArrayChunk **chunks, PlwInt size);
+
+#endif
@@ -1,12 +1,16 @@
 #include "PlwArrayRef.h"
 #include "PlwAbstractRef.h"
+#include "PlwArrayChunks.h"
 #include "PlwCommon.h"
 #include <string.h>
 
+/* a copy of a large array holds its items in chunks shared with the other copies, ptr is NULL until they are needed in one buffer. capacity counts the items allocated apart from the ref */
 struct PlwArrayRef {
 	PlwAbstractRef super;
 	PlwInt size;
+	PlwInt capacity;
 	PlwRefId *ptr;
+	PlwArrayChunk **chunks;
 };
 
 const char * const PlwArrayRefTagName = "PlwArrayRef";
@@ -24,64 +28,200 @@ const PlwAbstractRefTag PlwArrayRefTag = {
 PlwRefId PlwArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt *ptr, PlwError *error) {
 	PlwArrayRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwArrayRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwArrayRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
 	ref->super.tag = &PlwArrayRefTag;
 	ref->super.refCount = 1;
 	ref->size = size;
+	ref->capacity = size;
 	ref->ptr = ptr;
+	ref->chunks = NULL;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwArrayRef));
 		return -1;
 	}
 	return refId;
 }
 
+/* the items follow the ref in the same allocation, *ptr is set to them for the caller to fill */
+PlwRefId PlwArrayRef_MakeInline(PlwRefManager *refMan, PlwInt size, PlwRefId **ptr, PlwError *error) {
+	PlwArrayRef *ref;
+	PlwRefId refId;
+	*ptr = NULL;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwArrayRef) + size * sizeof(PlwRefId), error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	ref->super.tag = &PlwArrayRefTag;
+	ref->super.refCount = 1;
+	ref->size = size;
+	ref->capacity = 0;
+	ref->ptr = (PlwRefId *) (ref + 1);
+	ref->chunks = NULL;
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwRefManager_Free(refMan, ref, sizeof(PlwArrayRef) + size * sizeof(PlwRefId));
+		return -1;
+	}
+	*ptr = ref->ptr;
+	return refId;
+}
+
 PlwInt PlwArrayRef_Size(PlwArrayRef *ref) {
 	return ref->size;
 }
 
-PlwRefId *PlwArrayRef_Ptr(PlwArrayRef *ref) {
+static PlwRefId PlwArrayRef_MakeChunked(PlwRefManager *refMan, PlwInt size, PlwArrayChunk **chunks, PlwError *error) {
+	PlwArrayRef *ref;
+	PlwRefId refId;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwArrayRef), error);
+	if (PlwIsError(error)) {
+		PlwArrayChunks_QuickDestroy(refMan, chunks, size);
+		return -1;
+	}
+	ref->super.tag = &PlwArrayRefTag;
+	ref->super.refCount = 1;
+	ref->size = size;
+	ref->capacity = 0;
+	ref->ptr = NULL;
+	ref->chunks = chunks;
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwArrayChunks_QuickDestroy(refMan, chunks, size);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwArrayRef));
+		return -1;
+	}
+	return refId;
+}
+
+static PlwRefId PlwArrayRef_Item(PlwArrayRef *ref, PlwInt offset) {
+	return ref->chunks != NULL ? PlwArrayChunks_Item(ref->chunks, offset) : ref->ptr[offset];
+}
+
+PlwRefId *PlwArrayRef_Ptr(PlwRefManager *refMan, PlwArrayRef *ref, PlwError *error) {
+	PlwRefId *ptr;
+	if (ref->chunks != NULL) {
+		ptr = PlwAlloc(ref->size * sizeof(PlwRefId), error);
+		if (PlwIsError(error)) {
+			return NULL;
+		}
+		PlwArrayChunks_Gather(refMan, ref->chunks, ref->size, PlwTrue, ptr, error);
+		if (PlwIsError(error)) {
+			PlwFree(ptr);
+			return NULL;
+		}
+		ref->chunks = NULL;
+		ref->capacity = ref->size;
+		ref->ptr = ptr;
+	}
 	return ref->ptr;
 }
 
+void PlwArrayRef_CopyItems(PlwArrayRef *ref, PlwInt offset, PlwInt count, PlwRefId *items) {
+	if (ref->chunks != NULL) {
+		PlwArrayChunks_CopyItems(ref->chunks, offset, count, items);
+	} else {
+		memcpy(items, ref->ptr + offset, count * sizeof(PlwRefId));
+	}
+}
+
+/* the items grow geometrically, a chunked array is gathered first and the items of an inline array cannot move */
+PlwBoolean PlwArrayRef_Append(PlwRefManager *refMan, PlwArrayRef *ref, PlwArrayRef *items, PlwError *error) {
+	PlwInt size = ref->size;
+	PlwInt i;
+	if (ref->super.refCount > 1 || ref->ptr == (PlwRefId *) (ref + 1)) {
+		return PlwFalse;
+	}
+	PlwArrayRef_Ptr(refMan, ref, error);
+	if (PlwIsError(error)) {
+		return PlwFalse;
+	}
+	PlwGrowArray(items->size, sizeof(PlwRefId), &ref->ptr, &ref->size, &ref->capacity, error);
+	if (PlwIsError(error)) {
+		return PlwFalse;
+	}
+	PlwArrayRef_CopyItems(items, 0, items->size, ref->ptr + size);
+	for (i = size; i < ref->size; i++) {
+		PlwRefManager_IncRefCount(refMan, ref->ptr[i], error);
+		if (PlwIsError(error)) {
+			return PlwFalse;
+		}
+	}
+	return PlwTrue;
+}
+
 void PlwArrayRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error) {
 	PlwArrayRef *arrayRef = ref;
+	PlwRefId *item;
 	if (offset < 0 || offset >= arrayRef->size) {
 		PlwRefManError_InvalidOffset(error, offset);
 		return;
 	}
-	PlwRefManager_DecRefCount(refMan, arrayRef->ptr[offset], error);
+	if (arrayRef->chunks != NULL) {
+		item = PlwArrayChunks_MutableItem(refMan, arrayRef->chunks, arrayRef->size, offset, PlwTrue, error);
+	} else {
+		item = &arrayRef->ptr[offset];
+	}
 	if (PlwIsError(error)) {
 		return;
 	}
-	arrayRef->ptr[offset] = value;
+	PlwRefManager_DecRefCount(refMan, *item, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	*item = value;
 }
 
+/* the chunk of a chunked array is made its own before the item, so that the item does not look unshared */
 void PlwArrayRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwBoolean isForMutate, PlwError *error, PlwOffsetValue *result) {
 	PlwArrayRef *arrayRef = ref;
+	PlwRefId *item;
 	if (offset < 0 || offset >= arrayRef->size) {
 		PlwRefManError_InvalidOffset(error, offset);
 		return;
 	}
 	if (isForMutate == PlwTrue) {
-		arrayRef->ptr[offset] = PlwRefManager_MakeMutable(refMan, arrayRef->ptr[offset], error);
+		if (arrayRef->chunks != NULL) {
+			item = PlwArrayChunks_MutableItem(refMan, arrayRef->chunks, arrayRef->size, offset, PlwTrue, error);
+		} else {
+			item = &arrayRef->ptr[offset];
+		}
+		if (PlwIsError(error)) {
+			return;
+		}
+		*item = PlwRefManager_MakeMutable(refMan, *item, error);
 		if (PlwIsError(error)) {
 			return;
-		}				
+		}
+		result->value = *item;
+	} else {
+		result->value = PlwArrayRef_Item(arrayRef, offset);
 	}
-	result->value = arrayRef->ptr[offset];
 	result->isRef = PlwTrue;	
 }
 
+/* a large array is copied in chunks, that later copies share */
 PlwRefId PlwArrayRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	PlwArrayRef *arrayRef = ref;
-	PlwInt *newPtr;
+	PlwArrayChunk **newChunks;
+	PlwRefId *newPtr;
+	PlwRefId newRefId;
 	PlwInt i;
-	newPtr = PlwAlloc(arrayRef->size * sizeof(PlwRefId), error);
+	if (arrayRef->chunks != NULL || arrayRef->size >= PLW_ARRAY_CHUNK_MIN_SIZE) {
+		if (arrayRef->chunks != NULL) {
+			newChunks = PlwArrayChunks_Share(refMan, arrayRef->chunks, arrayRef->size, error);
+		} else {
+			newChunks = PlwArrayChunks_Make(refMan, arrayRef->ptr, arrayRef->size, PlwTrue, error);
+		}
+		if (PlwIsError(error)) {
+			return -1;
+		}
+		return PlwArrayRef_MakeChunked(refMan, arrayRef->size, newChunks, error);
+	}
+	newRefId = PlwArrayRef_MakeInline(refMan, arrayRef->size, &newPtr, error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
@@ -92,7 +232,7 @@ PlwRefId PlwArrayRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *err
 			return -1;
 		}
 	}
-	return PlwArrayRef_Make(refMan, arrayRef->size, newPtr, error);
+	return newRefId;
 }
 
 PlwBoolean PlwArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2, PlwError *error) {
@@ -104,7 +244,7 @@ PlwBoolean PlwArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2,
 		return PlwFalse;
 	}
 	for (i = 0; i < arrayRef1->size; i++) {
-		isEqual = PlwRefManager_CompareRefs(refMan, arrayRef1->ptr[i], arrayRef2->ptr[i], error);
+		isEqual = PlwRefManager_CompareRefs(refMan, PlwArrayRef_Item(arrayRef1, i), PlwArrayRef_Item(arrayRef2, i), error);
 		if (PlwIsError(error) || !isEqual) {
 			return PlwFalse;
 		}
@@ -115,19 +255,32 @@ PlwBoolean PlwArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2,
 void PlwArrayRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	PlwArrayRef *arrayRef = ref;
 	PlwInt i;
+	if (arrayRef->chunks != NULL) {
+		PlwArrayChunks_Destroy(refMan, arrayRef->chunks, arrayRef->size, PlwTrue, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		PlwRefManager_Free(refMan, arrayRef, sizeof(PlwArrayRef));
+		return;
+	}
 	for (i = 0; i < arrayRef->size; i++) {
 		PlwRefManager_DecRefCount(refMan, arrayRef->ptr[i], error);
 		if (PlwIsError(error)) {
 			return;
 		}
 	}
-	PlwFree(arrayRef->ptr);
-	PlwFree(arrayRef);
+	PlwArrayRef_QuickDestroy(refMan, ref);
 }
 
-void PlwArrayRef_QuickDestroy(void *ref) {
+void PlwArrayRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwArrayRef *arrayRef = ref;
-	PlwFree(arrayRef->ptr);
-	PlwFree(arrayRef);
+	if (arrayRef->chunks != NULL) {
+		PlwArrayChunks_QuickDestroy(refMan, arrayRef->chunks, arrayRef->size);
+		PlwRefManager_Free(refMan, arrayRef, sizeof(PlwArrayRef));
+	} else if (arrayRef->ptr != (PlwRefId *) (arrayRef + 1)) {
+		PlwFree(arrayRef->ptr);
+		PlwRefManager_Free(refMan, arrayRef, sizeof(PlwArrayRef));
+	} else {
+		PlwRefManager_Free(refMan, arrayRef, sizeof(PlwArrayRef) + arrayRef->size * sizeof(PlwRefId));
+	}
 }
-
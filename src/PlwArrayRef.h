@@ -9,9 +9,18 @@ typedef struct PlwArrayRef PlwArrayRef;
 
 PlwRefId PlwArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwRefId *ptr, PlwError *error);
 
+PlwRefId PlwArrayRef_MakeInline(PlwRefManager *refMan, PlwInt size, PlwRefId **ptr, PlwError *error);
+
 PlwInt PlwArrayRef_Size(PlwArrayRef *ref);
 
-PlwRefId *PlwArrayRef_Ptr(PlwArrayRef *ref);
+/* the items in one buffer, that a chunked array gathers and keeps */
+PlwRefId *PlwArrayRef_Ptr(PlwRefManager *refMan, PlwArrayRef *ref, PlwError *error);
+
+/* copies count items from offset without gathering a chunked array, the copied refs get no count */
+void PlwArrayRef_CopyItems(PlwArrayRef *ref, PlwInt offset, PlwInt count, PlwRefId *items);
+
+/* appends the items in place to an array that is not shared and holds its items apart, returns PlwFalse when it cannot */
+PlwBoolean PlwArrayRef_Append(PlwRefManager *refMan, PlwArrayRef *ref, PlwArrayRef *items, PlwError *error);
 
 void PlwArrayRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error);
 
@@ -23,6 +32,6 @@ PlwBoolean PlwArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2,
 
 void PlwArrayRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwArrayRef_QuickDestroy(void *ref);
+void PlwArrayRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
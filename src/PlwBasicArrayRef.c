@@ -1,12 +1,21 @@
 #include "PlwBasicArrayRef.h"
 #include "PlwAbstractRef.h"
+#include "PlwArrayChunks.h"
 #include "PlwCommon.h"
 #include <string.h>
 
+/*
+ * The items are stored in PlwInt words, a word per item or sizeof(PlwInt) items per word when they are bytes.
+ * A copy of a large array holds its words in chunks shared with the other copies, ptr is NULL until they are
+ * needed in one buffer. capacity counts the words allocated apart from the ref.
+ */
 struct PlwBasicArrayRef {
 	PlwAbstractRef super;
 	PlwInt size;
+	PlwInt itemSize;
+	PlwInt capacity;
 	PlwInt *ptr;
+	PlwArrayChunk **chunks;
 };
 
 const char * const PlwBasicArrayRefTagName = "PlwBasicArrayRef";
@@ -21,40 +30,172 @@ const PlwAbstractRefTag PlwBasicArrayRefTag = {
 	PlwBasicArrayRef_QuickDestroy
 };
 
-PlwRefId PlwBasicArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt *ptr, PlwError *error) {
+PlwInt PlwBasicArrayRef_WordCount(PlwInt size, PlwInt itemSize) {
+	return (size * itemSize + sizeof(PlwInt) - 1) / sizeof(PlwInt);
+}
+
+PlwRefId PlwBasicArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt itemSize, PlwInt *ptr, PlwError *error) {
 	PlwBasicArrayRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwBasicArrayRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwBasicArrayRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
 	ref->super.tag = &PlwBasicArrayRefTag;
 	ref->super.refCount = 1;
 	ref->size = size;
+	ref->itemSize = itemSize;
+	ref->capacity = PlwBasicArrayRef_WordCount(size, itemSize);
 	ref->ptr = ptr;
+	ref->chunks = NULL;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwBasicArrayRef));
 		return -1;
 	}
 	return refId;
 }
 
+/* the words follow the ref in the same allocation, *ptr is set to them for the caller to fill */
+PlwRefId PlwBasicArrayRef_MakeInline(PlwRefManager *refMan, PlwInt size, PlwInt itemSize, PlwInt **ptr, PlwError *error) {
+	PlwBasicArrayRef *ref;
+	PlwRefId refId;
+	PlwInt wordCount = PlwBasicArrayRef_WordCount(size, itemSize);
+	*ptr = NULL;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwBasicArrayRef) + wordCount * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	ref->super.tag = &PlwBasicArrayRefTag;
+	ref->super.refCount = 1;
+	ref->size = size;
+	ref->itemSize = itemSize;
+	ref->capacity = 0;
+	ref->ptr = (PlwInt *) (ref + 1);
+	ref->chunks = NULL;
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwRefManager_Free(refMan, ref, sizeof(PlwBasicArrayRef) + wordCount * sizeof(PlwInt));
+		return -1;
+	}
+	/* the bytes after the last item are copied with the words that hold them */
+	if (wordCount > 0) {
+		ref->ptr[wordCount - 1] = 0;
+	}
+	*ptr = ref->ptr;
+	return refId;
+}
+
 PlwInt PlwBasicArrayRef_Size(PlwBasicArrayRef *ref) {
 	return ref->size;
 }
 
-PlwInt *PlwBasicArrayRef_Ptr(PlwBasicArrayRef *ref) {
+PlwInt PlwBasicArrayRef_ItemSize(PlwBasicArrayRef *ref) {
+	return ref->itemSize;
+}
+
+static PlwRefId PlwBasicArrayRef_MakeChunked(PlwRefManager *refMan, PlwInt size, PlwInt itemSize, PlwArrayChunk **chunks, PlwError *error) {
+	PlwBasicArrayRef *ref;
+	PlwRefId refId;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwBasicArrayRef), error);
+	if (PlwIsError(error)) {
+		PlwArrayChunks_QuickDestroy(refMan, chunks, PlwBasicArrayRef_WordCount(size, itemSize));
+		return -1;
+	}
+	ref->super.tag = &PlwBasicArrayRefTag;
+	ref->super.refCount = 1;
+	ref->size = size;
+	ref->itemSize = itemSize;
+	ref->capacity = 0;
+	ref->ptr = NULL;
+	ref->chunks = chunks;
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwArrayChunks_QuickDestroy(refMan, chunks, PlwBasicArrayRef_WordCount(size, itemSize));
+		PlwRefManager_Free(refMan, ref, sizeof(PlwBasicArrayRef));
+		return -1;
+	}
+	return refId;
+}
+
+static PlwInt PlwBasicArrayRef_Item(PlwBasicArrayRef *ref, PlwInt offset) {
+	if (ref->chunks == NULL) {
+		return PlwBasicArrayRef_PtrItem(ref->ptr, ref->itemSize, offset);
+	}
+	if (ref->itemSize == 1) {
+		return ((char *) &PlwArrayChunks_Item(ref->chunks, offset / sizeof(PlwInt)))[offset % sizeof(PlwInt)];
+	}
+	return PlwArrayChunks_Item(ref->chunks, offset);
+}
+
+PlwInt *PlwBasicArrayRef_Ptr(PlwRefManager *refMan, PlwBasicArrayRef *ref, PlwError *error) {
+	PlwInt *ptr;
+	PlwInt wordCount;
+	if (ref->chunks != NULL) {
+		wordCount = PlwBasicArrayRef_WordCount(ref->size, ref->itemSize);
+		ptr = PlwAlloc(wordCount * sizeof(PlwInt), error);
+		if (PlwIsError(error)) {
+			return NULL;
+		}
+		PlwArrayChunks_Gather(refMan, ref->chunks, wordCount, PlwFalse, ptr, error);
+		ref->chunks = NULL;
+		ref->capacity = wordCount;
+		ref->ptr = ptr;
+	}
 	return ref->ptr;
 }
 
+void PlwBasicArrayRef_CopyItems(PlwBasicArrayRef *ref, PlwInt offset, PlwInt count, void *items) {
+	if (ref->chunks != NULL) {
+		PlwArrayChunks_CopyBytes(ref->chunks, offset * ref->itemSize, count * ref->itemSize, items);
+	} else {
+		memcpy(items, (char *) ref->ptr + offset * ref->itemSize, count * ref->itemSize);
+	}
+}
+
+/* the words grow geometrically, a chunked array is gathered first and the items of an inline array cannot move */
+PlwBoolean PlwBasicArrayRef_Append(PlwRefManager *refMan, PlwBasicArrayRef *ref, PlwBasicArrayRef *items, PlwError *error) {
+	PlwInt size = ref->size;
+	PlwInt wordCount;
+	if (ref->super.refCount > 1 || ref->ptr == (PlwInt *) (ref + 1) || ref->itemSize != items->itemSize) {
+		return PlwFalse;
+	}
+	PlwBasicArrayRef_Ptr(refMan, ref, error);
+	if (PlwIsError(error)) {
+		return PlwFalse;
+	}
+	wordCount = PlwBasicArrayRef_WordCount(size, ref->itemSize);
+	PlwGrowArray(PlwBasicArrayRef_WordCount(size + items->size, ref->itemSize) - wordCount, sizeof(PlwInt), &ref->ptr, &wordCount, &ref->capacity, error);
+	if (PlwIsError(error)) {
+		return PlwFalse;
+	}
+	PlwBasicArrayRef_CopyItems(items, 0, items->size, (char *) ref->ptr + size * ref->itemSize);
+	ref->size = size + items->size;
+	return PlwTrue;
+}
+
 void PlwBasicArrayRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error) {
 	PlwBasicArrayRef *basicArrayRef = ref;
+	PlwInt wordOffset;
+	PlwInt *word;
 	if (offset < 0 || offset >= basicArrayRef->size) {
 		PlwRefManError_InvalidOffset(error, offset);
 		return;
 	}
-	basicArrayRef->ptr[offset] = value;
+	wordOffset = offset * basicArrayRef->itemSize / sizeof(PlwInt);
+	if (basicArrayRef->chunks != NULL) {
+		word = PlwArrayChunks_MutableItem(refMan, basicArrayRef->chunks, PlwBasicArrayRef_WordCount(basicArrayRef->size, basicArrayRef->itemSize), wordOffset, PlwFalse, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+	} else {
+		word = basicArrayRef->ptr + wordOffset;
+	}
+	if (basicArrayRef->itemSize == 1) {
+		((char *) word)[offset % sizeof(PlwInt)] = value;
+	} else {
+		*word = value;
+	}
 }
 
 void PlwBasicArrayRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwBoolean isForMutate, PlwError *error, PlwOffsetValue *result) {
@@ -63,39 +204,68 @@ void PlwBasicArrayRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt of
 		PlwRefManError_InvalidOffset(error, offset);
 		return;
 	}
-	result->value = basicArrayRef->ptr[offset];
-	result->isRef = PlwFalse;	
+	result->value = PlwBasicArrayRef_Item(basicArrayRef, offset);
+	result->isRef = PlwFalse;
 }
 
+/* a large array is copied in chunks, that later copies share */
 PlwRefId PlwBasicArrayRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	PlwBasicArrayRef *basicArrayRef = ref;
+	PlwInt wordCount = PlwBasicArrayRef_WordCount(basicArrayRef->size, basicArrayRef->itemSize);
+	PlwArrayChunk **newChunks;
 	PlwInt *newPtr;
-	newPtr = PlwAlloc(basicArrayRef->size * sizeof(PlwInt), error);
+	PlwRefId newRefId;
+	if (basicArrayRef->chunks != NULL || wordCount >= PLW_ARRAY_CHUNK_MIN_SIZE) {
+		if (basicArrayRef->chunks != NULL) {
+			newChunks = PlwArrayChunks_Share(refMan, basicArrayRef->chunks, wordCount, error);
+		} else {
+			newChunks = PlwArrayChunks_Make(refMan, basicArrayRef->ptr, wordCount, PlwFalse, error);
+		}
+		if (PlwIsError(error)) {
+			return -1;
+		}
+		return PlwBasicArrayRef_MakeChunked(refMan, basicArrayRef->size, basicArrayRef->itemSize, newChunks, error);
+	}
+	newRefId = PlwBasicArrayRef_MakeInline(refMan, basicArrayRef->size, basicArrayRef->itemSize, &newPtr, error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
-	memcpy(newPtr, basicArrayRef->ptr, basicArrayRef->size * sizeof(PlwInt));
-	return PlwBasicArrayRef_Make(refMan, basicArrayRef->size, newPtr, error);
+	memcpy(newPtr, basicArrayRef->ptr, wordCount * sizeof(PlwInt));
+	return newRefId;
 }
 
 PlwBoolean PlwBasicArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2, PlwError *error) {
 	PlwBasicArrayRef *basicArrayRef1 = ref1;
 	PlwBasicArrayRef *basicArrayRef2 = ref2;
+	PlwInt i;
 	if (basicArrayRef1->size != basicArrayRef2->size) {
 		return PlwFalse;
 	}
-	return memcmp(basicArrayRef1->ptr, basicArrayRef2->ptr, basicArrayRef1->size) == 0;
+	if (basicArrayRef1->chunks != NULL || basicArrayRef2->chunks != NULL || basicArrayRef1->itemSize != basicArrayRef2->itemSize) {
+		for (i = 0; i < basicArrayRef1->size; i++) {
+			if (PlwBasicArrayRef_Item(basicArrayRef1, i) != PlwBasicArrayRef_Item(basicArrayRef2, i)) {
+				return PlwFalse;
+			}
+		}
+		return PlwTrue;
+	}
+	return memcmp(basicArrayRef1->ptr, basicArrayRef2->ptr, basicArrayRef1->size * basicArrayRef1->itemSize) == 0;
 }
 
 void PlwBasicArrayRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
-	PlwBasicArrayRef *basicArrayRef = ref;
-	PlwFree(basicArrayRef->ptr);
-	PlwFree(basicArrayRef);
+	PlwBasicArrayRef_QuickDestroy(refMan, ref);
 }
 
-void PlwBasicArrayRef_QuickDestroy(void *ref) {
+void PlwBasicArrayRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwBasicArrayRef *basicArrayRef = ref;
-	PlwFree(basicArrayRef->ptr);
-	PlwFree(basicArrayRef);
+	PlwInt wordCount = PlwBasicArrayRef_WordCount(basicArrayRef->size, basicArrayRef->itemSize);
+	if (basicArrayRef->chunks != NULL) {
+		PlwArrayChunks_QuickDestroy(refMan, basicArrayRef->chunks, wordCount);
+		PlwRefManager_Free(refMan, basicArrayRef, sizeof(PlwBasicArrayRef));
+	} else if (basicArrayRef->ptr != (PlwInt *) (basicArrayRef + 1)) {
+		PlwFree(basicArrayRef->ptr);
+		PlwRefManager_Free(refMan, basicArrayRef, sizeof(PlwBasicArrayRef));
+	} else {
+		PlwRefManager_Free(refMan, basicArrayRef, sizeof(PlwBasicArrayRef) + wordCount * sizeof(PlwInt));
+	}
 }
-
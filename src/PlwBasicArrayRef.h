@@ -7,11 +7,34 @@ extern const char * const PlwBasicArrayRefTagName;
 struct PlwBasicArrayRef;
 typedef struct PlwBasicArrayRef PlwBasicArrayRef;
 
-PlwRefId PlwBasicArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt *ptr, PlwError *error);
+/*
+ * The items of a []boolean or a []char take itemSize 1 and are stored as the chars of a text,
+ * the items of the other basic arrays take itemSize sizeof(PlwInt).
+ */
+
+/* the item at offset of the words returned by PlwBasicArrayRef_Ptr or filled after PlwBasicArrayRef_MakeInline */
+#define PlwBasicArrayRef_PtrItem(ptr, itemSize, offset) ((itemSize) == 1 ? (PlwInt) ((char *) (ptr))[offset] : (ptr)[offset])
+
+/* the words that hold size items of itemSize bytes */
+PlwInt PlwBasicArrayRef_WordCount(PlwInt size, PlwInt itemSize);
+
+/* ptr is an allocation of PlwBasicArrayRef_WordCount words that the array takes */
+PlwRefId PlwBasicArrayRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt itemSize, PlwInt *ptr, PlwError *error);
+
+PlwRefId PlwBasicArrayRef_MakeInline(PlwRefManager *refMan, PlwInt size, PlwInt itemSize, PlwInt **ptr, PlwError *error);
 
 PlwInt PlwBasicArrayRef_Size(PlwBasicArrayRef *ref);
 
-PlwInt *PlwBasicArrayRef_Ptr(PlwBasicArrayRef *ref);
+PlwInt PlwBasicArrayRef_ItemSize(PlwBasicArrayRef *ref);
+
+/* the words of the items in one buffer, that a chunked array gathers and keeps */
+PlwInt *PlwBasicArrayRef_Ptr(PlwRefManager *refMan, PlwBasicArrayRef *ref, PlwError *error);
+
+/* copies the bytes of count items from offset without gathering a chunked array */
+void PlwBasicArrayRef_CopyItems(PlwBasicArrayRef *ref, PlwInt offset, PlwInt count, void *items);
+
+/* appends the items in place to an array that is not shared, holds its items apart and has the same item size, returns PlwFalse when it cannot */
+PlwBoolean PlwBasicArrayRef_Append(PlwRefManager *refMan, PlwBasicArrayRef *ref, PlwBasicArrayRef *items, PlwError *error);
 
 void PlwBasicArrayRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error);
 
@@ -23,6 +46,6 @@ PlwBoolean PlwBasicArrayRef_CompareTo(PlwRefManager *refMan, void *ref1, void *r
 
 void PlwBasicArrayRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwBasicArrayRef_QuickDestroy(void *ref);
+void PlwBasicArrayRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
@@ -1,5 +1,57 @@
 #include "PlwCodeBlock.h"
 #include "PlwCommon.h"
+#include "PlwOpcode.h"
+#include <stdio.h>
+#include <string.h>
+
+const char * const PlwCodeBlockErrorInvalidOpcode = "PlwCodeBlockErrorInvalidOpcode";
+
+static void PlwCodeBlockError_InvalidOpcode(PlwError *error, const char *codeBlockName, PlwInt offset, PlwInt code) {
+	error->code = PlwCodeBlockErrorInvalidOpcode;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid opcode %ld at offset %ld of block %s", code, offset, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorMissingArg = "PlwCodeBlockErrorMissingArg";
+
+static void PlwCodeBlockError_MissingArg(PlwError *error, const char *codeBlockName, PlwInt offset) {
+	error->code = PlwCodeBlockErrorMissingArg;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Missing arg at offset %ld of block %s", offset, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorInvalidArg = "PlwCodeBlockErrorInvalidArg";
+
+static void PlwCodeBlockError_InvalidArg(PlwError *error, const char *codeBlockName, PlwInt offset, PlwInt arg1) {
+	error->code = PlwCodeBlockErrorInvalidArg;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid arg %ld at offset %ld of block %s", arg1, offset, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorStackUnderflow = "PlwCodeBlockErrorStackUnderflow";
+
+static void PlwCodeBlockError_StackUnderflow(PlwError *error, const char *codeBlockName, PlwInt index) {
+	error->code = PlwCodeBlockErrorStackUnderflow;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Stack underflow at instruction %ld of block %s", index, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorStackMismatch = "PlwCodeBlockErrorStackMismatch";
+
+static void PlwCodeBlockError_StackMismatch(PlwError *error, const char *codeBlockName, PlwInt index, PlwInt depth1, PlwInt depth2) {
+	error->code = PlwCodeBlockErrorStackMismatch;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Stack depth %ld and %ld at instruction %ld of block %s", depth1, depth2, index, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorInvalidCall = "PlwCodeBlockErrorInvalidCall";
+
+static void PlwCodeBlockError_InvalidCall(PlwError *error, const char *codeBlockName, PlwInt index) {
+	error->code = PlwCodeBlockErrorInvalidCall;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid call at instruction %ld of block %s", index, codeBlockName);
+}
+
+const char * const PlwCodeBlockErrorInvalidReturn = "PlwCodeBlockErrorInvalidReturn";
+
+static void PlwCodeBlockError_InvalidReturn(PlwError *error, const char *codeBlockName, PlwInt index) {
+	error->code = PlwCodeBlockErrorInvalidReturn;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid return at instruction %ld of block %s", index, codeBlockName);
+}
 
 void PlwCodeBlock_Init(PlwCodeBlock *cb, char *name) {
 	cb->name = name;
@@ -7,5 +59,492 @@ void PlwCodeBlock_Init(PlwCodeBlock *cb, char *name) {
 	cb->codes = NULL;
 	cb->strConstCount = 0;
 	cb->strConsts = NULL;
+	cb->floatConstCount = 0;
+	cb->floatConsts = NULL;
+	cb->instructionCount = 0;
+	cb->instructions = NULL;
+	cb->callCacheCount = 0;
+	cb->callCaches = NULL;
+	cb->resultCount = -1;
+	cb->maxStackDepth = 0;
+}
+
+static PlwBoolean PlwCodeBlock_IsValidArg(const PlwCodeBlock *cb, PlwInt code, PlwInt arg1, PlwInt codeBlockCount, PlwInt nativeCount) {
+	switch (code) {
+	case PLW_OPCODE_CREATE_STRING:
+		return arg1 >= 0 && arg1 < cb->strConstCount;
+	case PLW_OPCODE_PUSHF:
+		return arg1 >= 0 && arg1 < cb->floatConstCount;
+	case PLW_OPCODE_CALL:
+	case PLW_OPCODE_TAIL_CALL:
+	case PLW_OPCODE_INIT_GENERATOR:
+		return arg1 >= 0 && arg1 < codeBlockCount;
+	case PLW_OPCODE_CALL_NATIVE:
+		return arg1 >= 0 && arg1 < nativeCount;
+	case PLW_OPCODE_CALL_ABSTRACT:
+	case PLW_OPCODE_POP_VOID:
+	case PLW_OPCODE_CREATE_RECORD:
+	case PLW_OPCODE_CREATE_BASIC_ARRAY:
+	case PLW_OPCODE_CREATE_ARRAY:
+	case PLW_OPCODE_CREATE_BYTE_ARRAY:
+		return arg1 >= 0;
+	default:
+		return PlwTrue;
+	}
+}
+
+static PlwInt PlwCodeBlock_ArgCount(PlwInt code) {
+	if (code <= PLW_OPCODE1_MAX) {
+		return 0;
+	}
+	if (code <= PLW_OPCODE2_MAX) {
+		return 1;
+	}
+	if (code <= PLW_OPCODE3_MAX) {
+		return 2;
+	}
+	return 3;
+}
+
+/* returns the index (1 to 3) of the arg holding a jump target, 0 if none */
+static PlwInt PlwCodeBlock_JumpArg(PlwInt code) {
+	switch (code) {
+	case PLW_OPCODE_JZ:
+	case PLW_OPCODE_JNZ:
+	case PLW_OPCODE_JMP:
+	case PLW_OPCODE_CREATE_EXCEPTION_HANDLER:
+		return 1;
+	case PLW_OPCODE_JGT_LOCAL_LOCAL:
+	case PLW_OPCODE_JLT_LOCAL_LOCAL:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+void PlwCodeBlock_Decode(PlwCodeBlock *cb, PlwInt codeBlockCount, PlwInt nativeCount, PlwError *error) {
+	PlwInt *indexOfOffset;
+	PlwInstruction *instructions;
+	PlwInt instructionCount;
+	PlwInt offset;
+	PlwInt code;
+	PlwInt argCount;
+	PlwInt args[3];
+	PlwInt jumpArg;
+	PlwInt resultCount;
+	PlwCallCache *callCaches;
+	PlwInt callCacheCount = 0;
+	PlwInt i;
+	PlwInt j;
+	
+	/* index of the instruction starting at each offset, -1 inside an instruction */
+	indexOfOffset = PlwAlloc((cb->codeCount + 1) * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	instructionCount = 0;
+	offset = 0;
+	while (offset < cb->codeCount) {
+		code = cb->codes[offset];
+		if (code <= PLW_OPCODE_NOP || code > PLW_OPCODE_MAX) {
+			PlwCodeBlockError_InvalidOpcode(error, cb->name, offset, code);
+			PlwFree(indexOfOffset);
+			return;
+		}
+		indexOfOffset[offset] = instructionCount;
+		instructionCount++;
+		offset++;
+		argCount = PlwCodeBlock_ArgCount(code);
+		for (j = 0; j < argCount; j++) {
+			if (offset >= cb->codeCount) {
+				PlwCodeBlockError_MissingArg(error, cb->name, offset);
+				PlwFree(indexOfOffset);
+				return;
+			}
+			indexOfOffset[offset] = -1;
+			offset++;
+		}
+	}
+	indexOfOffset[cb->codeCount] = instructionCount;
+	
+	instructions = PlwAlloc((instructionCount + 1) * sizeof(PlwInstruction), error);
+	if (PlwIsError(error)) {
+		PlwFree(indexOfOffset);
+		return;
+	}
+	resultCount = -1;
+	offset = 0;
+	for (i = 0; i < instructionCount; i++) {
+		code = cb->codes[offset];
+		if (code == PLW_OPCODE_RET_VAL || code == PLW_OPCODE_TAIL_CALL) {
+			resultCount = 1;
+		} else if (code == PLW_OPCODE_RET && resultCount == -1) {
+			resultCount = 0;
+		}
+		offset++;
+		argCount = PlwCodeBlock_ArgCount(code);
+		jumpArg = PlwCodeBlock_JumpArg(code);
+		args[0] = 0;
+		args[1] = 0;
+		args[2] = 0;
+		for (j = 0; j < argCount; j++) {
+			args[j] = cb->codes[offset];
+			if (j + 1 == jumpArg) {
+				if (args[j] < 0 || args[j] > cb->codeCount || indexOfOffset[args[j]] == -1) {
+					PlwCodeBlockError_InvalidArg(error, cb->name, offset, args[j]);
+					PlwFree(instructions);
+					PlwFree(indexOfOffset);
+					return;
+				}
+				args[j] = indexOfOffset[args[j]];
+			} else if (j == 0 && !PlwCodeBlock_IsValidArg(cb, code, args[j], codeBlockCount, nativeCount)) {
+				PlwCodeBlockError_InvalidArg(error, cb->name, offset, args[j]);
+				PlwFree(instructions);
+				PlwFree(indexOfOffset);
+				return;
+			}
+			offset++;
+		}
+		if (code == PLW_OPCODE_CALL_ABSTRACT || code == PLW_OPCODE_CALL_ABSTRACT_PROC) {
+			args[1] = callCacheCount;
+			callCacheCount++;
+		}
+		instructions[i].opcode = code;
+		instructions[i].arg1 = args[0];
+		instructions[i].arg2 = args[1];
+		instructions[i].arg3 = args[2];
+	}
+	PlwFree(indexOfOffset);
+	callCaches = PlwAlloc(callCacheCount * sizeof(PlwCallCache), error);
+	if (PlwIsError(error)) {
+		PlwFree(instructions);
+		return;
+	}
+	for (i = 0; i < callCacheCount; i++) {
+		callCaches[i].count = 0;
+	}
+	instructions[instructionCount].opcode = PLW_OPCODE_NOP;
+	instructions[instructionCount].arg1 = 0;
+	instructions[instructionCount].arg2 = 0;
+	instructions[instructionCount].arg3 = 0;
+	cb->instructionCount = instructionCount;
+	cb->instructions = instructions;
+	cb->callCacheCount = callCacheCount;
+	cb->callCaches = callCaches;
+	cb->resultCount = resultCount;
+}
+
+static void PlwCodeBlock_Reach(const PlwCodeBlock *cb, PlwInt *depths, PlwInt *pending, PlwInt *pendingCount, PlwInt index, PlwInt depth, PlwError *error) {
+	/* the end of the block stops the run loop whatever the depth */
+	if (index == cb->instructionCount) {
+		return;
+	}
+	if (depths[index] == -1) {
+		depths[index] = depth;
+		pending[*pendingCount] = index;
+		(*pendingCount)++;
+	} else if (depths[index] != depth) {
+		PlwCodeBlockError_StackMismatch(error, cb->name, index, depths[index], depth);
+	}
+}
+
+/* returns the arg count pushed just before the call at index, -1 if it is not a constant */
+static PlwInt PlwCodeBlock_CallArgCount(const PlwCodeBlock *cb, const PlwBoolean *isTarget, PlwInt index) {
+	if (index == 0 || isTarget[index] || cb->instructions[index - 1].opcode != PLW_OPCODE_PUSH) {
+		return -1;
+	}
+	if (cb->instructions[index - 1].arg1 < 0) {
+		return -1;
+	}
+	return cb->instructions[index - 1].arg1;
+}
+
+/* whether the cells after the first of the record created at index are constants pushed just before it */
+static PlwBoolean PlwCodeBlock_HasConstantCells(const PlwCodeBlock *cb, const PlwBoolean *isTarget, PlwInt index) {
+	PlwInt cellCount = cb->instructions[index].arg1;
+	PlwInt i;
+	if (cellCount < 2 || index < cellCount - 1) {
+		return PlwFalse;
+	}
+	for (i = index - cellCount + 1; i < index; i++) {
+		if (cb->instructions[i].opcode != PLW_OPCODE_PUSH || isTarget[i + 1]) {
+			return PlwFalse;
+		}
+	}
+	return PlwTrue;
+}
+
+void PlwCodeBlock_Verify(PlwCodeBlock *cb, const PlwCodeBlock *codeBlocks, const PlwInt *nativeArgCounts, const PlwInt *nativeResultCounts, PlwInt *outDepths, PlwInt *outDepthsAfter, PlwError *error) {
+	PlwInt *depths;
+	PlwInt *pending;
+	PlwBoolean *isTarget;
+	PlwInt pendingCount;
+	const PlwInstruction *instruction;
+	PlwInt index;
+	PlwInt depth;
+	PlwInt maxDepth;
+	PlwInt popCount;
+	PlwInt pushCount;
+	PlwInt argCount;
+	PlwInt jumpArg;
+	PlwBoolean fallsThrough;
+	PlwInt i;
+	
+	depths = PlwAlloc(cb->instructionCount * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	pending = PlwAlloc(cb->instructionCount * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		PlwFree(depths);
+		return;
+	}
+	isTarget = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwBoolean), error);
+	if (PlwIsError(error)) {
+		PlwFree(pending);
+		PlwFree(depths);
+		return;
+	}
+	for (i = 0; i <= cb->instructionCount; i++) {
+		isTarget[i] = PlwFalse;
+	}
+	for (i = 0; i < cb->instructionCount; i++) {
+		depths[i] = -1;
+		if (outDepthsAfter != NULL) {
+			outDepthsAfter[i] = -1;
+		}
+		jumpArg = PlwCodeBlock_JumpArg(cb->instructions[i].opcode);
+		if (jumpArg == 1) {
+			isTarget[cb->instructions[i].arg1] = PlwTrue;
+		} else if (jumpArg == 3) {
+			isTarget[cb->instructions[i].arg3] = PlwTrue;
+		}
+	}
+	
+	maxDepth = 0;
+	pendingCount = 0;
+	PlwCodeBlock_Reach(cb, depths, pending, &pendingCount, 0, 0, error);
+	while (pendingCount > 0 && !PlwIsError(error)) {
+		pendingCount--;
+		index = pending[pendingCount];
+		instruction = &cb->instructions[index];
+		depth = depths[index];
+		popCount = 0;
+		pushCount = 0;
+		fallsThrough = PlwTrue;
+		switch (instruction->opcode) {
+		case PLW_OPCODE_SUSPEND:
+		case PLW_OPCODE_INC_LOCAL:
+		case PLW_OPCODE_JGT_LOCAL_LOCAL:
+		case PLW_OPCODE_JLT_LOCAL_LOCAL:
+			break;
+		case PLW_OPCODE_PUSH:
+		case PLW_OPCODE_PUSH_GLOBAL:
+		case PLW_OPCODE_PUSH_GLOBAL_FOR_MUTATE:
+		case PLW_OPCODE_PUSH_LOCAL:
+		case PLW_OPCODE_PUSH_LOCAL_FOR_MUTATE:
+		case PLW_OPCODE_PUSH_GLOBAL_MOVE:
+		case PLW_OPCODE_PUSH_LOCAL_MOVE:
+		case PLW_OPCODE_PUSH_GLOBAL_BORROW:
+		case PLW_OPCODE_PUSH_LOCAL_BORROW:
+		case PLW_OPCODE_PUSH_INDIRECTION:
+		case PLW_OPCODE_PUSH_INDIRECT:
+		case PLW_OPCODE_PUSH_INDIRECT_FOR_MUTATE:
+		case PLW_OPCODE_CREATE_STRING:
+		case PLW_OPCODE_CREATE_EXCEPTION_HANDLER:
+		case PLW_OPCODE_PUSHF:
+			pushCount = 1;
+			break;
+		case PLW_OPCODE_PUSH_LOCAL_PUSH_LOCAL:
+		case PLW_OPCODE_PUSH_GLOBAL_PUSH_GLOBAL:
+			pushCount = 2;
+			break;
+		case PLW_OPCODE_DUP:
+			popCount = 1;
+			pushCount = 2;
+			break;
+		case PLW_OPCODE_NEG:
+		case PLW_OPCODE_NEGF:
+		case PLW_OPCODE_NOT:
+		case PLW_OPCODE_NEXT:
+		case PLW_OPCODE_ENDED:
+		case PLW_OPCODE_PUSH_PTR_OFFSET_CONST:
+		case PLW_OPCODE_ADD_CONST:
+		case PLW_OPCODE_EQ_CONST:
+			popCount = 1;
+			pushCount = 1;
+			break;
+		case PLW_OPCODE_SWAP:
+			popCount = 2;
+			pushCount = 2;
+			break;
+		case PLW_OPCODE_JZ:
+		case PLW_OPCODE_JNZ:
+		case PLW_OPCODE_POP_GLOBAL:
+		case PLW_OPCODE_POP_LOCAL:
+		case PLW_OPCODE_POP_INDIRECT:
+		case PLW_OPCODE_YIELD:
+			popCount = 1;
+			break;
+		case PLW_OPCODE_POP_PTR_OFFSET:
+			popCount = 3;
+			break;
+		case PLW_OPCODE_JMP:
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_RAISE:
+			popCount = 1;
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_YIELD_DONE:
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_RET_VAL:
+			if (cb->resultCount != 1) {
+				PlwCodeBlockError_InvalidReturn(error, cb->name, index);
+			}
+			popCount = 1;
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_RET:
+			if (cb->resultCount != 0) {
+				PlwCodeBlockError_InvalidReturn(error, cb->name, index);
+			}
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_POP_VOID:
+			popCount = instruction->arg1;
+			break;
+		case PLW_OPCODE_CREATE_RECORD:
+			if (PlwCodeBlock_HasConstantCells(cb, isTarget, index)) {
+				cb->instructions[index].arg2 = index + 1;
+			}
+			popCount = instruction->arg1;
+			pushCount = 1;
+			break;
+		case PLW_OPCODE_CREATE_BASIC_ARRAY:
+		case PLW_OPCODE_CREATE_ARRAY:
+		case PLW_OPCODE_CREATE_BYTE_ARRAY:
+			popCount = instruction->arg1;
+			pushCount = 1;
+			break;
+		case PLW_OPCODE_CALL:
+			argCount = PlwCodeBlock_CallArgCount(cb, isTarget, index);
+			if (argCount == -1) {
+				PlwCodeBlockError_InvalidCall(error, cb->name, index);
+			}
+			popCount = argCount + 1;
+			pushCount = codeBlocks[instruction->arg1].resultCount;
+			if (pushCount == -1) {
+				pushCount = 0;
+				fallsThrough = PlwFalse;
+			}
+			break;
+		case PLW_OPCODE_TAIL_CALL:
+			/* the result of the callee is returned in place of the result of the current block */
+			argCount = PlwCodeBlock_CallArgCount(cb, isTarget, index);
+			if (argCount == -1 || codeBlocks[instruction->arg1].resultCount == 0) {
+				PlwCodeBlockError_InvalidCall(error, cb->name, index);
+			}
+			if (cb->resultCount != 1) {
+				PlwCodeBlockError_InvalidReturn(error, cb->name, index);
+			}
+			popCount = argCount + 1;
+			fallsThrough = PlwFalse;
+			break;
+		case PLW_OPCODE_CALL_ABSTRACT:
+		case PLW_OPCODE_CALL_ABSTRACT_PROC:
+			/* the record holding the concrete function is the last arg */
+			argCount = PlwCodeBlock_CallArgCount(cb, isTarget, index);
+			if (argCount < 1) {
+				PlwCodeBlockError_InvalidCall(error, cb->name, index);
+			}
+			popCount = argCount + 1;
+			pushCount = instruction->opcode == PLW_OPCODE_CALL_ABSTRACT ? 1 : 0;
+			break;
+		case PLW_OPCODE_CALL_NATIVE:
+			argCount = PlwCodeBlock_CallArgCount(cb, isTarget, index);
+			if (argCount != nativeArgCounts[instruction->arg1]) {
+				PlwCodeBlockError_InvalidCall(error, cb->name, index);
+			}
+			popCount = argCount + 1;
+			pushCount = nativeResultCounts[instruction->arg1];
+			break;
+		case PLW_OPCODE_INIT_GENERATOR:
+			argCount = PlwCodeBlock_CallArgCount(cb, isTarget, index);
+			if (argCount == -1) {
+				PlwCodeBlockError_InvalidCall(error, cb->name, index);
+			}
+			popCount = argCount + 1;
+			pushCount = 1;
+			break;
+		case PLW_OPCODE_ADD:
+		case PLW_OPCODE_ADDF:
+		case PLW_OPCODE_SUB:
+		case PLW_OPCODE_SUBF:
+		case PLW_OPCODE_DIV:
+		case PLW_OPCODE_DIVF:
+		case PLW_OPCODE_REM:
+		case PLW_OPCODE_MUL:
+		case PLW_OPCODE_MULF:
+		case PLW_OPCODE_GT:
+		case PLW_OPCODE_GTF:
+		case PLW_OPCODE_LT:
+		case PLW_OPCODE_LTF:
+		case PLW_OPCODE_GTE:
+		case PLW_OPCODE_GTEF:
+		case PLW_OPCODE_LTE:
+		case PLW_OPCODE_LTEF:
+		case PLW_OPCODE_AND:
+		case PLW_OPCODE_OR:
+		case PLW_OPCODE_EQ:
+		case PLW_OPCODE_EQF:
+		case PLW_OPCODE_EQ_REF:
+		case PLW_OPCODE_NE:
+		case PLW_OPCODE_NEF:
+		case PLW_OPCODE_PUSH_PTR_OFFSET:
+		case PLW_OPCODE_PUSH_PTR_OFFSET_FOR_MUTATE:
+		case PLW_OPCODE_BASIC_ARRAY_TIMES:
+		case PLW_OPCODE_ARRAY_TIMES:
+		case PLW_OPCODE_BYTE_ARRAY_TIMES:
+			popCount = 2;
+			pushCount = 1;
+			break;
+		}
+		if (PlwIsError(error)) {
+			break;
+		}
+		if (depth < popCount) {
+			PlwCodeBlockError_StackUnderflow(error, cb->name, index);
+			break;
+		}
+		depth = depth - popCount + pushCount;
+		if (depth > maxDepth) {
+			maxDepth = depth;
+		}
+		if (outDepthsAfter != NULL) {
+			outDepthsAfter[index] = depth;
+		}
+		/* a raised exception lands on its handler with the error code in place of the handler ref */
+		jumpArg = PlwCodeBlock_JumpArg(instruction->opcode);
+		if (jumpArg == 1) {
+			PlwCodeBlock_Reach(cb, depths, pending, &pendingCount, instruction->arg1, depth, error);
+		} else if (jumpArg == 3) {
+			PlwCodeBlock_Reach(cb, depths, pending, &pendingCount, instruction->arg3, depth, error);
+		}
+		if (fallsThrough) {
+			PlwCodeBlock_Reach(cb, depths, pending, &pendingCount, index + 1, depth, error);
+		}
+	}
+	if (outDepths != NULL) {
+		memcpy(outDepths, depths, cb->instructionCount * sizeof(PlwInt));
+	}
+	PlwFree(isTarget);
+	PlwFree(pending);
+	PlwFree(depths);
+	if (PlwIsError(error)) {
+		return;
+	}
+	cb->maxStackDepth = maxDepth;
 }
 
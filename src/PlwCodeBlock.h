@@ -3,6 +3,44 @@
 
 #include "PlwCommon.h"
 
+extern const char * const PlwCodeBlockErrorInvalidOpcode;
+extern const char * const PlwCodeBlockErrorMissingArg;
+extern const char * const PlwCodeBlockErrorInvalidArg;
+extern const char * const PlwCodeBlockErrorStackUnderflow;
+extern const char * const PlwCodeBlockErrorStackMismatch;
+extern const char * const PlwCodeBlockErrorInvalidCall;
+extern const char * const PlwCodeBlockErrorInvalidReturn;
+
+/*
+ * A decoded instruction. Jump targets are instruction indexes and every
+ * constant, code block and native id has been checked against its table.
+ * arg2 of CALL_ABSTRACT and CALL_ABSTRACT_PROC is the index of the inline
+ * cache of the call site in callCaches. arg2 of CREATE_RECORD is set by the
+ * verifier to the index of the instruction + 1 when the cells after the first
+ * are constants pushed just before it, 0 otherwise.
+ */
+typedef struct PlwInstruction {
+	PlwInt opcode;
+	PlwInt arg1;
+	PlwInt arg2;
+	PlwInt arg3;
+} PlwInstruction;
+
+#define PLW_CALL_CACHE_SIZE 4
+
+/*
+ * Inline cache of an abstract call site, for the receivers it has seen.
+ * An entry is keyed on the layout id of the record, that fixes its method
+ * slots, so a hit takes the code block without reading the slot. Records
+ * without a layout and the receivers past the size of the cache are left
+ * to the full lookup.
+ */
+typedef struct PlwCallCache {
+	PlwInt count;
+	PlwInt layoutIds[PLW_CALL_CACHE_SIZE];
+	PlwInt codeBlockIds[PLW_CALL_CACHE_SIZE];
+} PlwCallCache;
+
 typedef struct PlwCodeBlock {
 	char *name;
 	PlwInt codeCount;
@@ -11,8 +49,35 @@ typedef struct PlwCodeBlock {
 	char **strConsts;
 	PlwInt floatConstCount;
 	PlwFloat *floatConsts;
+	PlwInt instructionCount;
+	PlwInstruction *instructions;
+	PlwInt callCacheCount;
+	PlwCallCache *callCaches;
+	PlwInt resultCount;
+	PlwInt maxStackDepth;
 } PlwCodeBlock;
 
 void PlwCodeBlock_Init(PlwCodeBlock *cb, char *name);
+
+/*
+ * Translates codes into instructions. The instructions are terminated by
+ * an extra PLW_OPCODE_NOP that ends the run loop, so the vm does not have
+ * to check ip against instructionCount. Also sets resultCount to 1 if the
+ * block returns a value, 0 if it returns without one, -1 if it never returns.
+ */
+void PlwCodeBlock_Decode(PlwCodeBlock *cb, PlwInt codeBlockCount, PlwInt nativeCount, PlwError *error);
+
+/*
+ * Computes the stack depth above bp at every reachable instruction and
+ * rejects any instruction that would pop below bp, any mismatch of depths
+ * where paths join, and calls or returns that do not match their target.
+ * Sets maxStackDepth, that the vm reserves when it enters the block so
+ * the opcodes themselves never check the stack. All the blocks must have
+ * been decoded first, for their resultCount.
+ * When outDepths and outDepthsAfter are not NULL, they receive for each
+ * instruction the depth before it, and the depth it leaves to the next
+ * instruction and to its jump target, -1 if the instruction is unreachable.
+ */
+void PlwCodeBlock_Verify(PlwCodeBlock *cb, const PlwCodeBlock *codeBlocks, const PlwInt *nativeArgCounts, const PlwInt *nativeResultCounts, PlwInt *outDepths, PlwInt *outDepthsAfter, PlwError *error);
 		
 #endif
@@ -25,7 +25,7 @@ const PlwAbstractRefTag PlwExceptionHandlerRefTag = {
 PlwRefId PlwExceptionHandlerRef_Make(PlwRefManager *refMan, PlwInt codeBlockId, PlwInt ip, PlwInt bp, PlwError *error) {
 	PlwExceptionHandlerRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwExceptionHandlerRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwExceptionHandlerRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
@@ -36,7 +36,7 @@ PlwRefId PlwExceptionHandlerRef_Make(PlwRefManager *refMan, PlwInt codeBlockId,
 	ref->bp = bp;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwExceptionHandlerRef));
 		return -1;
 	}
 	return refId;
@@ -73,10 +73,10 @@ PlwBoolean PlwExceptionHandlerRef_CompareTo(PlwRefManager *refMan, void *ref1, v
 }
 
 void PlwExceptionHandlerRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
-	PlwFree(ref);
+	PlwRefManager_Free(refMan, ref, sizeof(PlwExceptionHandlerRef));
 }
 
-void PlwExceptionHandlerRef_QuickDestroy(void *ref) {
-	PlwFree(ref);
+void PlwExceptionHandlerRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
+	PlwRefManager_Free(refMan, ref, sizeof(PlwExceptionHandlerRef));
 }
 
@@ -25,6 +25,6 @@ PlwBoolean PlwExceptionHandlerRef_CompareTo(PlwRefManager *refMan, void *ref1, v
 
 void PlwExceptionHandlerRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwExceptionHandlerRef_QuickDestroy(void *ref);
+void PlwExceptionHandlerRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
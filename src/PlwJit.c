@@ -0,0 +1,848 @@
+#include "PlwJit.h"
+#include "PlwCommon.h"
+#include "PlwOpcode.h"
+#include "PlwStackMachine.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define PLW_JIT_X86_64
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const char * const PlwJitErrorUnsupported = "PlwJitErrorUnsupported";
+
+void PlwJitError_Unsupported(PlwError *error) {
+	error->code = PlwJitErrorUnsupported;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Jit is only available on x86-64 unix");
+}
+
+const char * const PlwJitErrorExecMem = "PlwJitErrorExecMem";
+
+void PlwJitError_ExecMem(PlwError *error, PlwInt size) {
+	error->code = PlwJitErrorExecMem;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Can't map %ld bytes of executable memory", size);
+}
+
+#ifndef PLW_JIT_CALL_THRESHOLD
+#define PLW_JIT_CALL_THRESHOLD 1000
+#endif
+
+/* upper bound of the native code of one instruction, slow paths included */
+#define PLW_JIT_MAX_INSTRUCTION_SIZE 512
+
+typedef struct PlwJitCode {
+	unsigned char *bytes;
+	PlwInt size;
+	/* native offset of each instruction, and of the end of the block */
+	PlwInt *offsets;
+} PlwJitCode;
+
+struct PlwJit {
+	PlwInt codeBlockCount;
+	const PlwJitOpcode *opcodes;
+	PlwInt *callCounts;
+	PlwJitCode *codes;
+	int zeroFd;
+};
+
+/*
+ * Entry of the native code of a block. It jumps to target, the native
+ * offset of sm->ip, and returns with sm->sp, sm->ip and the rest of the
+ * stack machine up to date.
+ */
+typedef void (*PlwJitEntry)(PlwStackMachine *sm, PlwError *error, unsigned char *target);
+
+#ifdef PLW_JIT_X86_64
+
+#define PLW_JIT_NONE -1
+#define PLW_JIT_RAX 0
+#define PLW_JIT_RCX 1
+#define PLW_JIT_RDX 2
+#define PLW_JIT_RBX 3
+#define PLW_JIT_RSP 4
+#define PLW_JIT_RBP 5
+#define PLW_JIT_RSI 6
+#define PLW_JIT_RDI 7
+#define PLW_JIT_R8 8
+#define PLW_JIT_R12 12
+#define PLW_JIT_R13 13
+#define PLW_JIT_R14 14
+#define PLW_JIT_R15 15
+
+/* the stack machine state lives in callee saved registers while native code runs */
+#define PLW_JIT_SM PLW_JIT_RBX
+#define PLW_JIT_BP PLW_JIT_RBP
+#define PLW_JIT_ERROR PLW_JIT_R12
+#define PLW_JIT_SP PLW_JIT_R13
+#define PLW_JIT_STACK PLW_JIT_R14
+#define PLW_JIT_MAP PLW_JIT_R15
+
+#define PLW_JIT_CC_AE 0x3
+#define PLW_JIT_CC_E 0x4
+#define PLW_JIT_CC_NE 0x5
+#define PLW_JIT_CC_A 0x7
+#define PLW_JIT_CC_P 0xA
+#define PLW_JIT_CC_NP 0xB
+#define PLW_JIT_CC_L 0xC
+#define PLW_JIT_CC_GE 0xD
+#define PLW_JIT_CC_LE 0xE
+#define PLW_JIT_CC_G 0xF
+
+typedef struct PlwJitBuffer {
+	unsigned char *bytes;
+	PlwInt size;
+	PlwInt capacity;
+	PlwInt *offsets;
+	/* pairs of rel32 position and target instruction */
+	PlwInt *patches;
+	PlwInt patchSize;
+	PlwInt patchCapacity;
+	PlwInt exitOffset;
+} PlwJitBuffer;
+
+static void PlwJit_Reserve(PlwJitBuffer *b, PlwInt size, PlwError *error) {
+	if (b->size + size > b->capacity) {
+		b->capacity = 2 * b->capacity + size;
+		b->bytes = PlwRealloc(b->bytes, b->capacity, error);
+	}
+}
+
+static void PlwJit_Byte(PlwJitBuffer *b, PlwInt byte) {
+	b->bytes[b->size] = (unsigned char) (byte & 0xFF);
+	b->size++;
+}
+
+static void PlwJit_Int32(PlwJitBuffer *b, PlwInt value) {
+	PlwInt i;
+	for (i = 0; i < 4; i++) {
+		PlwJit_Byte(b, (PlwInt) ((uint64_t) value >> (8 * i)));
+	}
+}
+
+static void PlwJit_Int64(PlwJitBuffer *b, PlwInt value) {
+	PlwInt i;
+	for (i = 0; i < 8; i++) {
+		PlwJit_Byte(b, (PlwInt) ((uint64_t) value >> (8 * i)));
+	}
+}
+
+static void PlwJit_PatchInt32(PlwJitBuffer *b, PlwInt at, PlwInt value) {
+	PlwInt i;
+	for (i = 0; i < 4; i++) {
+		b->bytes[at + i] = (unsigned char) (((uint64_t) value >> (8 * i)) & 0xFF);
+	}
+}
+
+static PlwBoolean PlwJit_FitsInt32(PlwInt value) {
+	return value >= -2147483647L - 1 && value <= 2147483647L;
+}
+
+/* legacy prefix, rex and opcode, 0x0Fxx stands for a two byte opcode */
+static void PlwJit_Opcode(PlwJitBuffer *b, PlwInt prefix, PlwInt w, PlwInt opcode, PlwInt reg, PlwInt index, PlwInt base) {
+	PlwInt rex = 0x40;
+	if (prefix != 0) {
+		PlwJit_Byte(b, prefix);
+	}
+	if (w) {
+		rex |= 0x08;
+	}
+	if (reg & 8) {
+		rex |= 0x04;
+	}
+	if (index != PLW_JIT_NONE && (index & 8)) {
+		rex |= 0x02;
+	}
+	if (base & 8) {
+		rex |= 0x01;
+	}
+	if (rex != 0x40) {
+		PlwJit_Byte(b, rex);
+	}
+	if (opcode > 0xFF) {
+		PlwJit_Byte(b, opcode >> 8);
+	}
+	PlwJit_Byte(b, opcode);
+}
+
+/* op reg, [base + index * 8 + disp] */
+static void PlwJit_Mem(PlwJitBuffer *b, PlwInt prefix, PlwInt w, PlwInt opcode, PlwInt reg, PlwInt base, PlwInt index, PlwInt disp) {
+	PlwInt mod;
+	PlwJit_Opcode(b, prefix, w, opcode, reg, index, base);
+	if (disp == 0 && (base & 7) != PLW_JIT_RBP) {
+		mod = 0;
+	} else if (disp >= -128 && disp <= 127) {
+		mod = 1;
+	} else {
+		mod = 2;
+	}
+	if (index == PLW_JIT_NONE && (base & 7) != PLW_JIT_RSP) {
+		PlwJit_Byte(b, (mod << 6) | ((reg & 7) << 3) | (base & 7));
+	} else {
+		PlwJit_Byte(b, (mod << 6) | ((reg & 7) << 3) | 4);
+		PlwJit_Byte(b, (3 << 6) | (((index == PLW_JIT_NONE ? PLW_JIT_RSP : index) & 7) << 3) | (base & 7));
+	}
+	if (mod == 1) {
+		PlwJit_Byte(b, disp);
+	} else if (mod == 2) {
+		PlwJit_Int32(b, disp);
+	}
+}
+
+/* op reg, rm with two registers */
+static void PlwJit_Reg(PlwJitBuffer *b, PlwInt w, PlwInt opcode, PlwInt reg, PlwInt rm) {
+	PlwJit_Opcode(b, 0, w, opcode, reg, PLW_JIT_NONE, rm);
+	PlwJit_Byte(b, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+/* op reg, [stack + sp * 8 - 8 * depth] where depth 1 is the top of the stack */
+static void PlwJit_Top(PlwJitBuffer *b, PlwInt prefix, PlwInt w, PlwInt opcode, PlwInt reg, PlwInt depth) {
+	PlwJit_Mem(b, prefix, w, opcode, reg, PLW_JIT_STACK, PLW_JIT_SP, -8 * depth);
+}
+
+static void PlwJit_MovRegReg(PlwJitBuffer *b, PlwInt dst, PlwInt src) {
+	PlwJit_Reg(b, 1, 0x89, src, dst);
+}
+
+static void PlwJit_MovRegImm(PlwJitBuffer *b, PlwInt reg, PlwInt value) {
+	if (PlwJit_FitsInt32(value)) {
+		PlwJit_Reg(b, 1, 0xC7, 0, reg);
+		PlwJit_Int32(b, value);
+	} else {
+		PlwJit_Opcode(b, 0, 1, 0xB8 + (reg & 7), 0, PLW_JIT_NONE, reg);
+		PlwJit_Int64(b, value);
+	}
+}
+
+static void PlwJit_AddSp(PlwJitBuffer *b, PlwInt delta) {
+	PlwJit_Reg(b, 1, 0x83, 0, PLW_JIT_SP);
+	PlwJit_Byte(b, delta);
+}
+
+static void PlwJit_Push(PlwJitBuffer *b, PlwInt reg) {
+	if (reg & 8) {
+		PlwJit_Byte(b, 0x41);
+	}
+	PlwJit_Byte(b, 0x50 + (reg & 7));
+}
+
+static void PlwJit_Pop(PlwJitBuffer *b, PlwInt reg) {
+	if (reg & 8) {
+		PlwJit_Byte(b, 0x41);
+	}
+	PlwJit_Byte(b, 0x58 + (reg & 7));
+}
+
+/* reloads what a handler may have changed, bp only changes on transfers */
+static void PlwJit_LoadState(PlwJitBuffer *b) {
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_SP, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, sp));
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_STACK, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, stack));
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_MAP, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, stackMap));
+}
+
+static void PlwJit_StoreState(PlwJitBuffer *b, PlwInt ip) {
+	PlwJit_Mem(b, 0, 1, 0x89, PLW_JIT_SP, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, sp));
+	PlwJit_Mem(b, 0, 1, 0xC7, 0, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, ip));
+	PlwJit_Int32(b, ip);
+}
+
+/* jmp or jcc to a position that is bound later, returns the position of its rel32 */
+static PlwInt PlwJit_JumpForward(PlwJitBuffer *b, PlwInt cc) {
+	if (cc == PLW_JIT_NONE) {
+		PlwJit_Byte(b, 0xE9);
+	} else {
+		PlwJit_Byte(b, 0x0F);
+		PlwJit_Byte(b, 0x80 + cc);
+	}
+	PlwJit_Int32(b, 0);
+	return b->size - 4;
+}
+
+static void PlwJit_Bind(PlwJitBuffer *b, PlwInt at) {
+	PlwJit_PatchInt32(b, at, b->size - (at + 4));
+}
+
+static void PlwJit_JumpTo(PlwJitBuffer *b, PlwInt cc, PlwInt offset) {
+	PlwInt at = PlwJit_JumpForward(b, cc);
+	PlwJit_PatchInt32(b, at, offset - (at + 4));
+}
+
+static void PlwJit_JumpToInstruction(PlwJitBuffer *b, PlwInt cc, PlwInt target, PlwError *error) {
+	PlwInt at = PlwJit_JumpForward(b, cc);
+	PlwGrowArray(2, sizeof(PlwInt), &b->patches, &b->patchSize, &b->patchCapacity, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	b->patches[b->patchSize - 2] = at;
+	b->patches[b->patchSize - 1] = target;
+}
+
+/*
+ * Calls back into a handler of the vm with the state synced, ip pointing
+ * past the instruction like in the run loop. Native code goes on after
+ * the handler unless it is a transfer, or it fails.
+ */
+static void PlwJit_CallHandler(PlwJitBuffer *b, PlwInt ip, PlwJitHandler handler, PlwInt argCount, const PlwInt *args, PlwBoolean isTransfer) {
+	static const PlwInt argRegs[] = {PLW_JIT_RSI, PLW_JIT_RDX, PLW_JIT_RCX, PLW_JIT_R8};
+	PlwInt i;
+	PlwJit_StoreState(b, ip + 1);
+	PlwJit_MovRegReg(b, PLW_JIT_RDI, PLW_JIT_SM);
+	for (i = 0; i < argCount; i++) {
+		PlwJit_MovRegImm(b, argRegs[i], args[i]);
+	}
+	PlwJit_MovRegReg(b, argRegs[argCount], PLW_JIT_ERROR);
+	PlwJit_MovRegImm(b, PLW_JIT_RAX, (PlwInt) handler);
+	PlwJit_Reg(b, 0, 0xFF, 2, PLW_JIT_RAX);
+	if (isTransfer) {
+		PlwJit_JumpTo(b, PLW_JIT_NONE, b->exitOffset);
+		return;
+	}
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_RAX, PLW_JIT_ERROR, PLW_JIT_NONE, offsetof(PlwError, code));
+	PlwJit_Reg(b, 1, 0x85, PLW_JIT_RAX, PLW_JIT_RAX);
+	PlwJit_JumpTo(b, PLW_JIT_CC_NE, b->exitOffset);
+	PlwJit_LoadState(b);
+}
+
+/* setcc, then stores the 0 or 1 into the cell at depth */
+static void PlwJit_StoreFlag(PlwJitBuffer *b, PlwInt cc, PlwInt depth) {
+	PlwJit_Reg(b, 0, 0x0F90 + cc, 0, PLW_JIT_RAX);
+	PlwJit_Reg(b, 0, 0x0FB6, PLW_JIT_RAX, PLW_JIT_RAX);
+	PlwJit_Top(b, 0, 1, 0x89, PLW_JIT_RAX, depth);
+}
+
+static void PlwJit_Compare(PlwJitBuffer *b, PlwInt cc) {
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 2);
+	PlwJit_Top(b, 0, 1, 0x3B, PLW_JIT_RAX, 1);
+	PlwJit_StoreFlag(b, cc, 2);
+	PlwJit_AddSp(b, -1);
+}
+
+/* ucomisd sets the flags of an unsigned compare, and the parity flag for NaN */
+static void PlwJit_CompareFloat(PlwJitBuffer *b, PlwInt cc, PlwInt depth1, PlwInt depth2) {
+	PlwJit_Top(b, 0xF2, 0, 0x0F10, 0, depth1);
+	PlwJit_Top(b, 0x66, 0, 0x0F2E, 0, depth2);
+	PlwJit_StoreFlag(b, cc, 2);
+	PlwJit_AddSp(b, -1);
+}
+
+static void PlwJit_CompareFloatEq(PlwJitBuffer *b, PlwBoolean isEq) {
+	PlwJit_Top(b, 0xF2, 0, 0x0F10, 0, 2);
+	PlwJit_Top(b, 0x66, 0, 0x0F2E, 0, 1);
+	PlwJit_Reg(b, 0, 0x0F90 + (isEq ? PLW_JIT_CC_E : PLW_JIT_CC_NE), 0, PLW_JIT_RAX);
+	PlwJit_Reg(b, 0, 0x0F90 + (isEq ? PLW_JIT_CC_NP : PLW_JIT_CC_P), 0, PLW_JIT_RCX);
+	PlwJit_Reg(b, 0, isEq ? 0x20 : 0x08, PLW_JIT_RCX, PLW_JIT_RAX);
+	PlwJit_Reg(b, 0, 0x0FB6, PLW_JIT_RAX, PLW_JIT_RAX);
+	PlwJit_Top(b, 0, 1, 0x89, PLW_JIT_RAX, 2);
+	PlwJit_AddSp(b, -1);
+}
+
+static void PlwJit_FloatOp(PlwJitBuffer *b, PlwInt opcode) {
+	PlwJit_Top(b, 0xF2, 0, 0x0F10, 0, 2);
+	PlwJit_Top(b, 0xF2, 0, opcode, 0, 1);
+	PlwJit_Top(b, 0xF2, 0, 0x0F11, 0, 2);
+	PlwJit_AddSp(b, -1);
+}
+
+static void PlwJit_Logic(PlwJitBuffer *b, PlwInt opcode) {
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 2);
+	PlwJit_Reg(b, 1, 0x85, PLW_JIT_RAX, PLW_JIT_RAX);
+	PlwJit_Reg(b, 0, 0x0F90 + PLW_JIT_CC_NE, 0, PLW_JIT_RAX);
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RCX, 1);
+	PlwJit_Reg(b, 1, 0x85, PLW_JIT_RCX, PLW_JIT_RCX);
+	PlwJit_Reg(b, 0, 0x0F90 + PLW_JIT_CC_NE, 0, PLW_JIT_RCX);
+	PlwJit_Reg(b, 0, opcode, PLW_JIT_RCX, PLW_JIT_RAX);
+	PlwJit_Reg(b, 0, 0x0FB6, PLW_JIT_RAX, PLW_JIT_RAX);
+	PlwJit_Top(b, 0, 1, 0x89, PLW_JIT_RAX, 2);
+	PlwJit_AddSp(b, -1);
+}
+
+static void PlwJit_PushConst(PlwJitBuffer *b, PlwInt value) {
+	if (PlwJit_FitsInt32(value)) {
+		PlwJit_Mem(b, 0, 1, 0xC7, 0, PLW_JIT_STACK, PLW_JIT_SP, 0);
+		PlwJit_Int32(b, value);
+	} else {
+		PlwJit_MovRegImm(b, PLW_JIT_RAX, value);
+		PlwJit_Mem(b, 0, 1, 0x89, PLW_JIT_RAX, PLW_JIT_STACK, PLW_JIT_SP, 0);
+	}
+	PlwJit_Mem(b, 0, 1, 0xC7, 0, PLW_JIT_MAP, PLW_JIT_SP, 0);
+	PlwJit_Int32(b, PlwFalse);
+	PlwJit_AddSp(b, 1);
+}
+
+/*
+ * Loads the stack index of a local or global into reg and jumps to the
+ * slow path when it is out of [0, sp), as an unsigned compare.
+ */
+static PlwInt PlwJit_SlotIndex(PlwJitBuffer *b, PlwInt reg, PlwBoolean isLocal, PlwInt offset) {
+	if (isLocal) {
+		PlwJit_Mem(b, 0, 1, 0x8D, reg, PLW_JIT_BP, PLW_JIT_NONE, offset);
+	} else {
+		PlwJit_MovRegImm(b, reg, offset);
+	}
+	PlwJit_Reg(b, 1, 0x3B, reg, PLW_JIT_SP);
+	return PlwJit_JumpForward(b, PLW_JIT_CC_AE);
+}
+
+/*
+ * The fast paths only move cells that are not refs, the handler does the ref
+ * counting. A cell that is not a ref is pushed the same way by a move, the
+ * slot is dead after it. A borrow pushes any cell as not a ref.
+ */
+static void PlwJit_PushSlot(PlwJit *jit, PlwJitBuffer *b, PlwInt ip, PlwInt opcode, PlwInt offset) {
+	PlwBoolean isLocal = opcode == PLW_OPCODE_PUSH_LOCAL || opcode == PLW_OPCODE_PUSH_LOCAL_MOVE || opcode == PLW_OPCODE_PUSH_LOCAL_BORROW;
+	PlwBoolean isBorrow = opcode == PLW_OPCODE_PUSH_LOCAL_BORROW || opcode == PLW_OPCODE_PUSH_GLOBAL_BORROW;
+	PlwInt outOfBound, isRef = 0, done;
+	outOfBound = PlwJit_SlotIndex(b, PLW_JIT_RAX, isLocal, offset);
+	if (!isBorrow) {
+		PlwJit_Mem(b, 0, 1, 0x83, 7, PLW_JIT_MAP, PLW_JIT_RAX, 0);
+		PlwJit_Byte(b, 0);
+		isRef = PlwJit_JumpForward(b, PLW_JIT_CC_NE);
+	}
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_RCX, PLW_JIT_STACK, PLW_JIT_RAX, 0);
+	PlwJit_Mem(b, 0, 1, 0x89, PLW_JIT_RCX, PLW_JIT_STACK, PLW_JIT_SP, 0);
+	PlwJit_Mem(b, 0, 1, 0xC7, 0, PLW_JIT_MAP, PLW_JIT_SP, 0);
+	PlwJit_Int32(b, PlwFalse);
+	PlwJit_AddSp(b, 1);
+	done = PlwJit_JumpForward(b, PLW_JIT_NONE);
+	PlwJit_Bind(b, outOfBound);
+	if (!isBorrow) {
+		PlwJit_Bind(b, isRef);
+	}
+	PlwJit_CallHandler(b, ip, jit->opcodes[opcode].handler, 1, &offset, PlwFalse);
+	PlwJit_Bind(b, done);
+}
+
+static void PlwJit_PopSlot(PlwJit *jit, PlwJitBuffer *b, PlwInt ip, PlwBoolean isLocal, PlwInt offset) {
+	PlwInt outOfBound, isRef, done;
+	outOfBound = PlwJit_SlotIndex(b, PLW_JIT_RAX, isLocal, offset);
+	PlwJit_Mem(b, 0, 1, 0x83, 7, PLW_JIT_MAP, PLW_JIT_RAX, 0);
+	PlwJit_Byte(b, 0);
+	isRef = PlwJit_JumpForward(b, PLW_JIT_CC_NE);
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RCX, 1);
+	PlwJit_Mem(b, 0, 1, 0x89, PLW_JIT_RCX, PLW_JIT_STACK, PLW_JIT_RAX, 0);
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_RCX, PLW_JIT_MAP, PLW_JIT_SP, -8);
+	PlwJit_Mem(b, 0, 1, 0x89, PLW_JIT_RCX, PLW_JIT_MAP, PLW_JIT_RAX, 0);
+	PlwJit_AddSp(b, -1);
+	done = PlwJit_JumpForward(b, PLW_JIT_NONE);
+	PlwJit_Bind(b, outOfBound);
+	PlwJit_Bind(b, isRef);
+	PlwJit_CallHandler(b, ip, jit->opcodes[isLocal ? PLW_OPCODE_POP_LOCAL : PLW_OPCODE_POP_GLOBAL].handler, 1, &offset, PlwFalse);
+	PlwJit_Bind(b, done);
+}
+
+static void PlwJit_DivRem(PlwJit *jit, PlwJitBuffer *b, PlwInt ip, PlwInt opcode) {
+	PlwInt divByZero, done;
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RCX, 1);
+	PlwJit_Reg(b, 1, 0x85, PLW_JIT_RCX, PLW_JIT_RCX);
+	divByZero = PlwJit_JumpForward(b, PLW_JIT_CC_E);
+	PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 2);
+	PlwJit_Opcode(b, 0, 1, 0x99, 0, PLW_JIT_NONE, 0);
+	PlwJit_Reg(b, 1, 0xF7, 7, PLW_JIT_RCX);
+	PlwJit_Top(b, 0, 1, 0x89, opcode == PLW_OPCODE_DIV ? PLW_JIT_RAX : PLW_JIT_RDX, 2);
+	PlwJit_AddSp(b, -1);
+	done = PlwJit_JumpForward(b, PLW_JIT_NONE);
+	PlwJit_Bind(b, divByZero);
+	PlwJit_CallHandler(b, ip, jit->opcodes[opcode].handler, 0, NULL, PlwTrue);
+	PlwJit_Bind(b, done);
+}
+
+static void PlwJit_JumpLocalLocal(PlwJit *jit, PlwJitBuffer *b, PlwInt ip, const PlwInstruction *instruction, PlwError *error) {
+	PlwInt outOfBound1, outOfBound2, done;
+	PlwInt args[3];
+	outOfBound1 = PlwJit_SlotIndex(b, PLW_JIT_RAX, PlwTrue, instruction->arg1);
+	outOfBound2 = PlwJit_SlotIndex(b, PLW_JIT_RCX, PlwTrue, instruction->arg2);
+	PlwJit_Mem(b, 0, 1, 0x8B, PLW_JIT_RAX, PLW_JIT_STACK, PLW_JIT_RAX, 0);
+	PlwJit_Mem(b, 0, 1, 0x3B, PLW_JIT_RAX, PLW_JIT_STACK, PLW_JIT_RCX, 0);
+	PlwJit_JumpToInstruction(b, instruction->opcode == PLW_OPCODE_JGT_LOCAL_LOCAL ? PLW_JIT_CC_G : PLW_JIT_CC_L, instruction->arg3, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	done = PlwJit_JumpForward(b, PLW_JIT_NONE);
+	PlwJit_Bind(b, outOfBound1);
+	PlwJit_Bind(b, outOfBound2);
+	args[0] = instruction->arg1;
+	args[1] = instruction->arg2;
+	args[2] = instruction->arg3;
+	/* the handler decides the jump, the interpreter loop resumes at sm->ip */
+	PlwJit_CallHandler(b, ip, jit->opcodes[instruction->opcode].handler, 3, args, PlwTrue);
+	PlwJit_Bind(b, done);
+}
+
+static void PlwJit_CompileInstruction(PlwJit *jit, PlwJitBuffer *b, const PlwCodeBlock *cb, PlwInt ip, PlwError *error) {
+	const PlwInstruction *instruction = &cb->instructions[ip];
+	PlwInt args[3];
+	PlwInt argCount;
+	PlwInt outOfBound, done;
+	PlwWord w;
+	switch (instruction->opcode) {
+	case PLW_OPCODE_ADD:
+		PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 1);
+		PlwJit_Top(b, 0, 1, 0x01, PLW_JIT_RAX, 2);
+		PlwJit_AddSp(b, -1);
+		return;
+	case PLW_OPCODE_SUB:
+		PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 1);
+		PlwJit_Top(b, 0, 1, 0x29, PLW_JIT_RAX, 2);
+		PlwJit_AddSp(b, -1);
+		return;
+	case PLW_OPCODE_MUL:
+		PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 2);
+		PlwJit_Top(b, 0, 1, 0x0FAF, PLW_JIT_RAX, 1);
+		PlwJit_Top(b, 0, 1, 0x89, PLW_JIT_RAX, 2);
+		PlwJit_AddSp(b, -1);
+		return;
+	case PLW_OPCODE_DIV:
+	case PLW_OPCODE_REM:
+		PlwJit_DivRem(jit, b, ip, instruction->opcode);
+		return;
+	case PLW_OPCODE_NEG:
+		PlwJit_Top(b, 0, 1, 0xF7, 3, 1);
+		return;
+	case PLW_OPCODE_ADDF:
+		PlwJit_FloatOp(b, 0x0F58);
+		return;
+	case PLW_OPCODE_SUBF:
+		PlwJit_FloatOp(b, 0x0F5C);
+		return;
+	case PLW_OPCODE_MULF:
+		PlwJit_FloatOp(b, 0x0F59);
+		return;
+	case PLW_OPCODE_DIVF:
+		PlwJit_FloatOp(b, 0x0F5E);
+		return;
+	case PLW_OPCODE_NEGF:
+		/* btc on the sign bit */
+		PlwJit_Top(b, 0, 1, 0x0FBA, 7, 1);
+		PlwJit_Byte(b, 63);
+		return;
+	case PLW_OPCODE_GT:
+		PlwJit_Compare(b, PLW_JIT_CC_G);
+		return;
+	case PLW_OPCODE_LT:
+		PlwJit_Compare(b, PLW_JIT_CC_L);
+		return;
+	case PLW_OPCODE_GTE:
+		PlwJit_Compare(b, PLW_JIT_CC_GE);
+		return;
+	case PLW_OPCODE_LTE:
+		PlwJit_Compare(b, PLW_JIT_CC_LE);
+		return;
+	case PLW_OPCODE_EQ:
+		PlwJit_Compare(b, PLW_JIT_CC_E);
+		return;
+	case PLW_OPCODE_NE:
+		PlwJit_Compare(b, PLW_JIT_CC_NE);
+		return;
+	case PLW_OPCODE_GTF:
+		PlwJit_CompareFloat(b, PLW_JIT_CC_A, 2, 1);
+		return;
+	case PLW_OPCODE_LTF:
+		PlwJit_CompareFloat(b, PLW_JIT_CC_A, 1, 2);
+		return;
+	case PLW_OPCODE_GTEF:
+		PlwJit_CompareFloat(b, PLW_JIT_CC_AE, 2, 1);
+		return;
+	case PLW_OPCODE_LTEF:
+		PlwJit_CompareFloat(b, PLW_JIT_CC_AE, 1, 2);
+		return;
+	case PLW_OPCODE_EQF:
+		PlwJit_CompareFloatEq(b, PlwTrue);
+		return;
+	case PLW_OPCODE_NEF:
+		PlwJit_CompareFloatEq(b, PlwFalse);
+		return;
+	case PLW_OPCODE_AND:
+		PlwJit_Logic(b, 0x20);
+		return;
+	case PLW_OPCODE_OR:
+		PlwJit_Logic(b, 0x08);
+		return;
+	case PLW_OPCODE_NOT:
+		PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 1);
+		PlwJit_Reg(b, 1, 0x85, PLW_JIT_RAX, PLW_JIT_RAX);
+		PlwJit_StoreFlag(b, PLW_JIT_CC_E, 1);
+		return;
+	case PLW_OPCODE_JZ:
+	case PLW_OPCODE_JNZ:
+		PlwJit_Top(b, 0, 1, 0x8B, PLW_JIT_RAX, 1);
+		PlwJit_AddSp(b, -1);
+		PlwJit_Reg(b, 1, 0x85, PLW_JIT_RAX, PLW_JIT_RAX);
+		PlwJit_JumpToInstruction(b, instruction->opcode == PLW_OPCODE_JZ ? PLW_JIT_CC_E : PLW_JIT_CC_NE, instruction->arg1, error);
+		return;
+	case PLW_OPCODE_JMP:
+		PlwJit_JumpToInstruction(b, PLW_JIT_NONE, instruction->arg1, error);
+		return;
+	case PLW_OPCODE_PUSH:
+		PlwJit_PushConst(b, instruction->arg1);
+		return;
+	case PLW_OPCODE_PUSHF:
+		w.f = cb->floatConsts[instruction->arg1];
+		PlwJit_PushConst(b, w.i);
+		return;
+	case PLW_OPCODE_PUSH_LOCAL:
+	case PLW_OPCODE_PUSH_GLOBAL:
+	case PLW_OPCODE_PUSH_LOCAL_MOVE:
+	case PLW_OPCODE_PUSH_GLOBAL_MOVE:
+	case PLW_OPCODE_PUSH_LOCAL_BORROW:
+	case PLW_OPCODE_PUSH_GLOBAL_BORROW:
+		PlwJit_PushSlot(jit, b, ip, instruction->opcode, instruction->arg1);
+		return;
+	case PLW_OPCODE_PUSH_LOCAL_PUSH_LOCAL:
+		PlwJit_PushSlot(jit, b, ip, PLW_OPCODE_PUSH_LOCAL, instruction->arg1);
+		PlwJit_PushSlot(jit, b, ip, PLW_OPCODE_PUSH_LOCAL, instruction->arg2);
+		return;
+	case PLW_OPCODE_PUSH_GLOBAL_PUSH_GLOBAL:
+		PlwJit_PushSlot(jit, b, ip, PLW_OPCODE_PUSH_GLOBAL, instruction->arg1);
+		PlwJit_PushSlot(jit, b, ip, PLW_OPCODE_PUSH_GLOBAL, instruction->arg2);
+		return;
+	case PLW_OPCODE_POP_LOCAL:
+		PlwJit_PopSlot(jit, b, ip, PlwTrue, instruction->arg1);
+		return;
+	case PLW_OPCODE_POP_GLOBAL:
+		PlwJit_PopSlot(jit, b, ip, PlwFalse, instruction->arg1);
+		return;
+	case PLW_OPCODE_JGT_LOCAL_LOCAL:
+	case PLW_OPCODE_JLT_LOCAL_LOCAL:
+		if (PlwJit_FitsInt32(instruction->arg1) && PlwJit_FitsInt32(instruction->arg2)) {
+			PlwJit_JumpLocalLocal(jit, b, ip, instruction, error);
+			return;
+		}
+		args[0] = instruction->arg1;
+		args[1] = instruction->arg2;
+		args[2] = instruction->arg3;
+		PlwJit_CallHandler(b, ip, jit->opcodes[instruction->opcode].handler, 3, args, PlwTrue);
+		return;
+	case PLW_OPCODE_INC_LOCAL:
+		if (PlwJit_FitsInt32(instruction->arg1) && PlwJit_FitsInt32(instruction->arg2)) {
+			outOfBound = PlwJit_SlotIndex(b, PLW_JIT_RAX, PlwTrue, instruction->arg1);
+			PlwJit_Mem(b, 0, 1, 0x81, 0, PLW_JIT_STACK, PLW_JIT_RAX, 0);
+			PlwJit_Int32(b, instruction->arg2);
+			done = PlwJit_JumpForward(b, PLW_JIT_NONE);
+			PlwJit_Bind(b, outOfBound);
+			args[0] = instruction->arg1;
+			args[1] = instruction->arg2;
+			PlwJit_CallHandler(b, ip, jit->opcodes[PLW_OPCODE_INC_LOCAL].handler, 2, args, PlwFalse);
+			PlwJit_Bind(b, done);
+			return;
+		}
+		break;
+	case PLW_OPCODE_ADD_CONST:
+		if (PlwJit_FitsInt32(instruction->arg1)) {
+			PlwJit_Top(b, 0, 1, 0x81, 0, 1);
+			PlwJit_Int32(b, instruction->arg1);
+			return;
+		}
+		break;
+	case PLW_OPCODE_EQ_CONST:
+		if (PlwJit_FitsInt32(instruction->arg1)) {
+			PlwJit_Top(b, 0, 1, 0x81, 7, 1);
+			PlwJit_Int32(b, instruction->arg1);
+			PlwJit_StoreFlag(b, PLW_JIT_CC_E, 1);
+			return;
+		}
+		break;
+	}
+	/* everything else, and the locals too far away for a disp32, goes through the handlers */
+	if (instruction->opcode <= PLW_OPCODE1_MAX) {
+		argCount = 0;
+	} else if (instruction->opcode <= PLW_OPCODE2_MAX) {
+		argCount = 1;
+	} else if (instruction->opcode <= PLW_OPCODE3_MAX) {
+		argCount = 2;
+	} else {
+		argCount = 3;
+	}
+	args[0] = instruction->arg1;
+	args[1] = instruction->arg2;
+	args[2] = instruction->arg3;
+	PlwJit_CallHandler(b, ip, jit->opcodes[instruction->opcode].handler, argCount, args, jit->opcodes[instruction->opcode].isTransfer);
+}
+
+/*
+ * The native code of a block starts with the entry, the exit back to the
+ * caller of the entry, then one template per instruction. The offset of
+ * every instruction is recorded as the interpreter may enter the block
+ * anywhere, after a call returns or when an exception is caught.
+ */
+static void PlwJit_Compile(PlwJit *jit, const PlwCodeBlock *cb, PlwJitCode *code, PlwError *error) {
+	PlwJitBuffer b;
+	PlwInt i;
+	unsigned char *bytes;
+
+	b.size = 0;
+	b.capacity = 256 + 64 * cb->instructionCount;
+	b.patches = NULL;
+	b.patchSize = 0;
+	b.patchCapacity = 0;
+	b.offsets = NULL;
+	b.bytes = PlwAlloc(b.capacity, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	b.offsets = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		goto error;
+	}
+
+	PlwJit_Push(&b, PLW_JIT_RBX);
+	PlwJit_Push(&b, PLW_JIT_RBP);
+	PlwJit_Push(&b, PLW_JIT_R12);
+	PlwJit_Push(&b, PLW_JIT_R13);
+	PlwJit_Push(&b, PLW_JIT_R14);
+	PlwJit_Push(&b, PLW_JIT_R15);
+	/* realigns rsp on 16 bytes for the handler calls */
+	PlwJit_Reg(&b, 1, 0x83, 5, PLW_JIT_RSP);
+	PlwJit_Byte(&b, 8);
+	PlwJit_MovRegReg(&b, PLW_JIT_SM, PLW_JIT_RDI);
+	PlwJit_MovRegReg(&b, PLW_JIT_ERROR, PLW_JIT_RSI);
+	PlwJit_Mem(&b, 0, 1, 0x8B, PLW_JIT_BP, PLW_JIT_SM, PLW_JIT_NONE, offsetof(PlwStackMachine, bp));
+	PlwJit_LoadState(&b);
+	PlwJit_Reg(&b, 0, 0xFF, 4, PLW_JIT_RDX);
+
+	b.exitOffset = b.size;
+	PlwJit_Reg(&b, 1, 0x83, 0, PLW_JIT_RSP);
+	PlwJit_Byte(&b, 8);
+	PlwJit_Pop(&b, PLW_JIT_R15);
+	PlwJit_Pop(&b, PLW_JIT_R14);
+	PlwJit_Pop(&b, PLW_JIT_R13);
+	PlwJit_Pop(&b, PLW_JIT_R12);
+	PlwJit_Pop(&b, PLW_JIT_RBP);
+	PlwJit_Pop(&b, PLW_JIT_RBX);
+	PlwJit_Byte(&b, 0xC3);
+
+	for (i = 0; i < cb->instructionCount; i++) {
+		PlwJit_Reserve(&b, PLW_JIT_MAX_INSTRUCTION_SIZE, error);
+		if (PlwIsError(error)) {
+			goto error;
+		}
+		b.offsets[i] = b.size;
+		PlwJit_CompileInstruction(jit, &b, cb, i, error);
+		if (PlwIsError(error)) {
+			goto error;
+		}
+	}
+	/* the end of the block goes back to the interpreter, to its NOP */
+	PlwJit_Reserve(&b, PLW_JIT_MAX_INSTRUCTION_SIZE, error);
+	if (PlwIsError(error)) {
+		goto error;
+	}
+	b.offsets[i] = b.size;
+	PlwJit_StoreState(&b, i);
+	PlwJit_JumpTo(&b, PLW_JIT_NONE, b.exitOffset);
+
+	for (i = 0; i < b.patchSize; i += 2) {
+		PlwJit_PatchInt32(&b, b.patches[i], b.offsets[b.patches[i + 1]] - (b.patches[i] + 4));
+	}
+
+	bytes = mmap(NULL, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, jit->zeroFd, 0);
+	if (bytes == MAP_FAILED) {
+		PlwJitError_ExecMem(error, b.size);
+		goto error;
+	}
+	memcpy(bytes, b.bytes, b.size);
+	if (mprotect(bytes, b.size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(bytes, b.size);
+		PlwJitError_ExecMem(error, b.size);
+		goto error;
+	}
+	code->bytes = bytes;
+	code->size = b.size;
+	code->offsets = b.offsets;
+	PlwFree(b.bytes);
+	PlwFree(b.patches);
+	return;
+
+error:
+	PlwFree(b.bytes);
+	PlwFree(b.offsets);
+	PlwFree(b.patches);
+}
+
+#endif
+
+PlwJit *PlwJit_Create(PlwInt codeBlockCount, const PlwJitOpcode *opcodes, PlwError *error) {
+#ifndef PLW_JIT_X86_64
+	PlwJitError_Unsupported(error);
+	return NULL;
+#else
+	PlwJit *jit;
+	PlwInt i;
+	jit = PlwAlloc(sizeof(PlwJit), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	jit->codeBlockCount = codeBlockCount;
+	jit->opcodes = opcodes;
+	jit->callCounts = PlwAlloc(codeBlockCount * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		PlwFree(jit);
+		return NULL;
+	}
+	jit->codes = PlwAlloc(codeBlockCount * sizeof(PlwJitCode), error);
+	if (PlwIsError(error)) {
+		PlwFree(jit->callCounts);
+		PlwFree(jit);
+		return NULL;
+	}
+	for (i = 0; i < codeBlockCount; i++) {
+		jit->callCounts[i] = 0;
+		jit->codes[i].bytes = NULL;
+		jit->codes[i].size = 0;
+		jit->codes[i].offsets = NULL;
+	}
+	/* private mappings of /dev/zero are anonymous memory, without MAP_ANONYMOUS */
+	jit->zeroFd = open("/dev/zero", O_RDWR);
+	if (jit->zeroFd < 0) {
+		PlwJitError_ExecMem(error, 0);
+		PlwFree(jit->codes);
+		PlwFree(jit->callCounts);
+		PlwFree(jit);
+		return NULL;
+	}
+	return jit;
+#endif
+}
+
+void PlwJit_Destroy(PlwJit *jit) {
+#ifdef PLW_JIT_X86_64
+	PlwInt i;
+	for (i = 0; i < jit->codeBlockCount; i++) {
+		if (jit->codes[i].bytes != NULL) {
+			munmap(jit->codes[i].bytes, jit->codes[i].size);
+			PlwFree(jit->codes[i].offsets);
+		}
+	}
+	close(jit->zeroFd);
+	PlwFree(jit->codes);
+	PlwFree(jit->callCounts);
+	PlwFree(jit);
+#endif
+}
+
+void PlwJit_CountCall(PlwJit *jit, const PlwCodeBlock *codeBlocks, PlwInt codeBlockId, PlwError *error) {
+	jit->callCounts[codeBlockId]++;
+	if (jit->callCounts[codeBlockId] == PLW_JIT_CALL_THRESHOLD + 1) {
+#ifdef PLW_JIT_X86_64
+		PlwJit_Compile(jit, &codeBlocks[codeBlockId], &jit->codes[codeBlockId], error);
+#endif
+	}
+}
+
+void PlwJit_Run(PlwJit *jit, PlwStackMachine *sm, PlwError *error) {
+	PlwJitCode *code;
+	PlwJitEntry entry;
+	for (;;) {
+		code = &jit->codes[sm->codeBlockId];
+		if (code->bytes == NULL || sm->ip >= sm->codeBlocks[sm->codeBlockId].instructionCount) {
+			return;
+		}
+		memcpy(&entry, &code->bytes, sizeof(entry));
+		entry(sm, error, code->bytes + code->offsets[sm->ip]);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef PLWJIT_H_
+#define PLWJIT_H_
+
+#include "PlwCommon.h"
+#include "PlwCodeBlock.h"
+
+extern const char * const PlwJitErrorUnsupported;
+extern const char * const PlwJitErrorExecMem;
+
+/*
+ * An opcode handler of the vm, cast to a common type. The native code calls
+ * it with the stack machine, the instruction args and the error, like the
+ * run loop does.
+ */
+typedef void (*PlwJitHandler)(void);
+
+typedef struct PlwJitOpcode {
+	PlwJitHandler handler;
+	/* the handler may leave the code block or unwind the frame */
+	PlwBoolean isTransfer;
+} PlwJitOpcode;
+
+struct PlwStackMachine;
+
+struct PlwJit;
+typedef struct PlwJit PlwJit;
+
+/* opcodes is indexed by opcode and must outlive the jit */
+PlwJit *PlwJit_Create(PlwInt codeBlockCount, const PlwJitOpcode *opcodes, PlwError *error);
+
+void PlwJit_Destroy(PlwJit *jit);
+
+/* compiles the code block to native code once it has been called often enough */
+void PlwJit_CountCall(PlwJit *jit, const PlwCodeBlock *codeBlocks, PlwInt codeBlockId, PlwError *error);
+
+/*
+ * Runs native code as long as the current code block of the stack machine
+ * is compiled, and returns when it reaches a block that is not, or the end
+ * of the block. The stack machine is up to date when it returns.
+ */
+void PlwJit_Run(PlwJit *jit, struct PlwStackMachine *sm, PlwError *error);
+
+#endif
@@ -25,7 +25,7 @@ const PlwAbstractRefTag PlwMappedRecordRefTag = {
 PlwRefId PlwMappedRecordRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt *ptr, PlwBoolean *mapPtr, PlwError *error) {
 	PlwMappedRecordRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwMappedRecordRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwMappedRecordRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
@@ -36,7 +36,7 @@ PlwRefId PlwMappedRecordRef_Make(PlwRefManager *refMan, PlwInt size, PlwInt *ptr
 	ref->mapPtr = mapPtr;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwMappedRecordRef));
 		return -1;
 	}
 	return refId;
@@ -101,15 +101,13 @@ void PlwMappedRecordRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *erro
 			}
 		}
 	}
-	PlwFree(mappedRef->mapPtr);
-	PlwFree(mappedRef->ptr);
-	PlwFree(mappedRef);
+	PlwMappedRecordRef_QuickDestroy(refMan, ref);
 }
 
-void PlwMappedRecordRef_QuickDestroy(void *ref) {
+void PlwMappedRecordRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwMappedRecordRef *mappedRef = ref;
 	PlwFree(mappedRef->mapPtr);
 	PlwFree(mappedRef->ptr);
-	PlwFree(mappedRef);
+	PlwRefManager_Free(refMan, mappedRef, sizeof(PlwMappedRecordRef));
 }
 
@@ -27,6 +27,6 @@ PlwBoolean PlwMappedRecordRef_CompareTo(PlwRefManager *refMan, void *ref1, void
 
 void PlwMappedRecordRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwMappedRecordRef_QuickDestroy(void *ref);
+void PlwMappedRecordRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
@@ -3,6 +3,8 @@
 #include "PlwArrayRef.h"
 #include "PlwBasicArrayRef.h"
 #include "PlwRecordRef.h"
+#include "PlwTextSearch.h"
+#include "PlwSort.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -29,7 +31,7 @@ static void PlwNativeProc_Write_Text(PlwStackMachine *sm, PlwError *error) {
 	if (PlwIsError(error)) {
 		return;
 	}
-	printf("%s", PlwStringRef_Ptr(ref));
+	fwrite(PlwStringRef_Ptr(ref), 1, PlwStringRef_Len(ref), stdout);
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -45,7 +47,8 @@ static void PlwNativeProc_Print_Text(PlwStackMachine *sm, PlwError *error) {
 	if (PlwIsError(error)) {
 		return;
 	}
-	printf("%s\n", PlwStringRef_Ptr(ref));
+	fwrite(PlwStringRef_Ptr(ref), 1, PlwStringRef_Len(ref), stdout);
+	putchar('\n');
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -57,18 +60,74 @@ static void PlwNativeFunc_Print_Text(PlwStackMachine *sm, PlwError *error) {
 	PlwNativeError_NotImplemented(error, "PlwNativeFunc_Print_Text");
 }
 
-static void PlwNativeFunc_Text_Integer(PlwStackMachine *sm, PlwError *error) {
-	char buffer[128];
+/* a string ref holding a copy of the len chars at str */
+static PlwRefId PlwNative_MakeString(PlwRefManager *refMan, const char *str, PlwInt len, PlwError *error) {
 	char *ptr;
 	PlwRefId refId;
-	snprintf(buffer, 128, "%ld", sm->stack[sm->sp - 2]);
-	ptr = PlwStrDup(buffer, error);
+	refId = PlwStringRef_MakeInline(refMan, len, &ptr, error);
 	if (PlwIsError(error)) {
-		return;
+		return -1;
 	}
-	refId = PlwStringRef_Make(sm->refMan, ptr, error);
+	memcpy(ptr, str, len);
+	return refId;
+}
+
+/* the chars of the longest integer, -9223372036854775808 */
+#define PLW_NATIVE_INTEGER_TEXT_MAX 20
+
+static const char PlwNative_DigitPairs[] =
+	"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+	"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+/* writes the chars of value so that they end at end, returns where they start */
+static char *PlwNative_FormatInteger(PlwInt value, char *end) {
+	uint64_t digits = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+	char *p = end;
+	PlwInt pair;
+	while (digits >= 100) {
+		pair = (digits % 100) * 2;
+		digits /= 100;
+		*--p = PlwNative_DigitPairs[pair + 1];
+		*--p = PlwNative_DigitPairs[pair];
+	}
+	if (digits >= 10) {
+		*--p = PlwNative_DigitPairs[digits * 2 + 1];
+		*--p = PlwNative_DigitPairs[digits * 2];
+	} else {
+		*--p = '0' + digits;
+	}
+	if (value < 0) {
+		*--p = '-';
+	}
+	return p;
+}
+
+/* the integer at the start of the len chars at ptr read like atol does, 0 when there is none */
+static PlwInt PlwNative_ParseInteger(const char *ptr, PlwInt len) {
+	const char *end = ptr + len;
+	PlwBoolean negative = PlwFalse;
+	uint64_t value = 0;
+	while (ptr < end && (*ptr == ' ' || (*ptr >= '\t' && *ptr <= '\r'))) {
+		ptr++;
+	}
+	if (ptr < end && (*ptr == '-' || *ptr == '+')) {
+		negative = *ptr == '-';
+		ptr++;
+	}
+	while (ptr < end && *ptr >= '0' && *ptr <= '9') {
+		value = value * 10 + (*ptr - '0');
+		ptr++;
+	}
+	return negative ? (PlwInt) (0 - value) : (PlwInt) value;
+}
+
+static void PlwNativeFunc_Text_Integer(PlwStackMachine *sm, PlwError *error) {
+	char buffer[PLW_NATIVE_INTEGER_TEXT_MAX];
+	char *start;
+	PlwRefId refId;
+	start = PlwNative_FormatInteger(sm->stack[sm->sp - 2], buffer + PLW_NATIVE_INTEGER_TEXT_MAX);
+	refId = PlwNative_MakeString(sm->refMan, start, buffer + PLW_NATIVE_INTEGER_TEXT_MAX - start, error);
 	if (PlwIsError(error)) {
-		PlwFree(ptr);
 		return;
 	}
 	sm->stack[sm->sp - 2] = refId;
@@ -79,56 +138,39 @@ static void PlwNativeFunc_Text_Integer(PlwStackMachine *sm, PlwError *error) {
 static void PlwNativeFunc_Text_Real(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w;
 	char buffer[128];
-	char *ptr;
 	PlwRefId refId;
 	w.i = sm->stack[sm->sp - 2];
 	snprintf(buffer, 128, "%f", w.f);
-	ptr = PlwStrDup(buffer, error);
+	refId = PlwNative_MakeString(sm->refMan, buffer, strlen(buffer), error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	refId = PlwStringRef_Make(sm->refMan, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
 	sm->stack[sm->sp - 2] = refId;
 	sm->stackMap[sm->sp - 2] = PlwTrue;
 	sm->sp--;
 }
 
 static void PlwNativeFunc_Text_Char(PlwStackMachine *sm, PlwError *error) {
-	char buffer[2];
-	char *ptr;
+	char c;
 	PlwRefId refId;
-	buffer[0] = sm->stack[sm->sp - 2];
-	buffer[1] = '\0';
-	ptr = PlwStrDup(buffer, error);
+	c = sm->stack[sm->sp - 2];
+	refId = PlwNative_MakeString(sm->refMan, &c, 1, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	refId = PlwStringRef_Make(sm->refMan, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
 	sm->stack[sm->sp - 2] = refId;
 	sm->stackMap[sm->sp - 2] = PlwTrue;
 	sm->sp--;
 }
 
 static void PlwNativeFunc_Text_Boolean(PlwStackMachine *sm, PlwError *error) {
-	char *ptr;
+	const char *ptr;
 	PlwRefId refId;
-	ptr = PlwStrDup(sm->stack[sm->sp - 2] ? "true" : "false", error);
+	ptr = sm->stack[sm->sp - 2] ? "true" : "false";
+	refId = PlwNative_MakeString(sm->refMan, ptr, strlen(ptr), error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	refId = PlwStringRef_Make(sm->refMan, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
 	sm->stack[sm->sp - 2] = refId;
 	sm->stackMap[sm->sp - 2] = PlwTrue;
 	sm->sp--;
@@ -219,7 +261,7 @@ static void PlwNativeFunc_Length_Text(PlwStackMachine *sm, PlwError *error) {
 	if (PlwIsError(error)) {
 		return;
 	}
-	length = strlen(PlwStringRef_Ptr(ref));
+	length = PlwStringRef_Len(ref);
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -244,7 +286,10 @@ static void PlwNativeFunc_IndexOfArray_Ref_Ref(PlwStackMachine *sm, PlwError *er
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwArrayRef_Ptr(ref);
+	ptr = PlwArrayRef_Ptr(sm->refMan, ref, error);
+	if (PlwIsError(error)) {
+		return;
+	}
 	size = PlwArrayRef_Size(ref);
 	for (i = 0; i < size; i++) {
 		isEqual = PlwRefManager_CompareRefs(sm->refMan, itemRefId, ptr[i], error);
@@ -275,6 +320,7 @@ static void PlwNativeFunc_IndexOfBasicArray_Integer_Ref(PlwStackMachine *sm, Plw
 	PlwBasicArrayRef *ref;
 	PlwInt *ptr;
 	PlwInt size;
+	PlwInt itemSize;
 	PlwInt i;
 	PlwInt indexOf = -1;
 	item = sm->stack[sm->sp - 3];
@@ -283,10 +329,14 @@ static void PlwNativeFunc_IndexOfBasicArray_Integer_Ref(PlwStackMachine *sm, Plw
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwBasicArrayRef_Ptr(ref);
+	ptr = PlwBasicArrayRef_Ptr(sm->refMan, ref, error);
+	if (PlwIsError(error)) {
+		return;
+	}
 	size = PlwBasicArrayRef_Size(ref);
+	itemSize = PlwBasicArrayRef_ItemSize(ref);
 	for (i = 0; i < size; i++) {
-		if (item == ptr[i]) {
+		if (item == PlwBasicArrayRef_PtrItem(ptr, itemSize, i)) {
 			indexOf = i;
 			break;
 		}
@@ -304,6 +354,7 @@ static void PlwNativeFunc_Text_ArrayOfChar(PlwStackMachine *sm, PlwError *error)
 	PlwRefId refId;
 	PlwBasicArrayRef *ref;
 	PlwInt size;
+	PlwInt itemSize;
 	PlwInt *ptr;
 	PlwInt i;
 	char *resultPtr;
@@ -314,20 +365,18 @@ static void PlwNativeFunc_Text_ArrayOfChar(PlwStackMachine *sm, PlwError *error)
 		return;
 	}
 	size = PlwBasicArrayRef_Size(ref);
-	ptr = PlwBasicArrayRef_Ptr(ref);
-	resultPtr = PlwAlloc(size + 1, error);
+	ptr = PlwBasicArrayRef_Ptr(sm->refMan, ref, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	for (i = 0; i < size; i++) {
-		resultPtr[i] = ptr[i];
-	}
-	resultPtr[size] = '\0';
-	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, error);
+	resultRefId = PlwStringRef_MakeInline(sm->refMan, size, &resultPtr, error);
 	if (PlwIsError(error)) {
-		PlwFree(resultPtr);
 		return;
 	}
+	itemSize = PlwBasicArrayRef_ItemSize(ref);
+	for (i = 0; i < size; i++) {
+		resultPtr[i] = PlwBasicArrayRef_PtrItem(ptr, itemSize, i);
+	}
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -341,13 +390,15 @@ static void PlwNativeFunc_Text_ArrayOfInteger(PlwStackMachine *sm, PlwError *err
 	PlwRefId refId;
 	PlwBasicArrayRef *ref;
 	PlwInt size;
+	PlwInt itemSize;
 	PlwInt *ptr;
 	char *resultPtr = NULL;
 	PlwInt resultPtrLen = 0;
 	PlwInt resultPtrCapacity = 0;
 	PlwRefId resultRefId;
 	PlwInt i;
-	char buffer[128];
+	char buffer[PLW_NATIVE_INTEGER_TEXT_MAX];
+	char *itemStart;
 	PlwInt itemLen;
 	refId = sm->stack[sm->sp - 2];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwBasicArrayRefTagName, error);
@@ -355,14 +406,19 @@ static void PlwNativeFunc_Text_ArrayOfInteger(PlwStackMachine *sm, PlwError *err
 		return;
 	}
 	size = PlwBasicArrayRef_Size(ref);
-	ptr = PlwBasicArrayRef_Ptr(ref);
+	itemSize = PlwBasicArrayRef_ItemSize(ref);
+	ptr = PlwBasicArrayRef_Ptr(sm->refMan, ref, error);
+	if (PlwIsError(error)) {
+		return;
+	}
 	PlwGrowArray(1, 1, &resultPtr, &resultPtrLen, &resultPtrCapacity, error);
 	if (PlwIsError(error)) {
 		return;
 	}
 	resultPtr[0] = '[';
 	for (i = 0; i < size; i++) {
-		itemLen = snprintf(buffer, 128, "%ld", ptr[i]);
+		itemStart = PlwNative_FormatInteger(PlwBasicArrayRef_PtrItem(ptr, itemSize, i), buffer + PLW_NATIVE_INTEGER_TEXT_MAX);
+		itemLen = buffer + PLW_NATIVE_INTEGER_TEXT_MAX - itemStart;
 		if (itemLen > 0) {
 			PlwGrowArray(itemLen + (i > 0 ? 2 : 0), 1, &resultPtr, &resultPtrLen, &resultPtrCapacity, error);
 			if (PlwIsError(error)) {
@@ -373,7 +429,7 @@ static void PlwNativeFunc_Text_ArrayOfInteger(PlwStackMachine *sm, PlwError *err
 				resultPtr[resultPtrLen - itemLen - 2] = ',';
 				resultPtr[resultPtrLen - itemLen - 1] = ' ';
 			}
-			memcpy(&resultPtr[resultPtrLen - itemLen], buffer, itemLen);
+			memcpy(&resultPtr[resultPtrLen - itemLen], itemStart, itemLen);
 		}
 	}
 	resultPtr = PlwRealloc(resultPtr, resultPtrLen + 2, error);
@@ -383,7 +439,7 @@ static void PlwNativeFunc_Text_ArrayOfInteger(PlwStackMachine *sm, PlwError *err
 	}
 	resultPtr[resultPtrLen] = ']';
 	resultPtr[resultPtrLen + 1] = '\0';
-	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, error);
+	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, resultPtrLen + 1, error);
 	if (PlwIsError(error)) {
 		PlwFree(resultPtr);
 		return;
@@ -403,9 +459,9 @@ static void PlwNativeFunc_Text_ArrayOfBoolean(PlwStackMachine *sm, PlwError *err
 
 static void PlwNativeFunc_Text_ArrayOfText(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
-	PlwBasicArrayRef *ref;
+	PlwArrayRef *ref;
 	PlwInt size;
-	PlwInt *ptr;
+	PlwRefId *ptr;
 	char *resultPtr = NULL;
 	PlwInt resultPtrLen = 0;
 	PlwInt resultPtrCapacity = 0;
@@ -419,8 +475,11 @@ static void PlwNativeFunc_Text_ArrayOfText(PlwStackMachine *sm, PlwError *error)
 	if (PlwIsError(error)) {
 		return;
 	}
-	size = PlwBasicArrayRef_Size(ref);
-	ptr = PlwBasicArrayRef_Ptr(ref);
+	size = PlwArrayRef_Size(ref);
+	ptr = PlwArrayRef_Ptr(sm->refMan, ref, error);
+	if (PlwIsError(error)) {
+		return;
+	}
 	PlwGrowArray(1, 1, &resultPtr, &resultPtrLen, &resultPtrCapacity, error);
 	if (PlwIsError(error)) {
 		return;
@@ -433,7 +492,7 @@ static void PlwNativeFunc_Text_ArrayOfText(PlwStackMachine *sm, PlwError *error)
 			return;
 		}
 		itemPtr = PlwStringRef_Ptr(itemRef);
-		itemLen = strlen(itemPtr);
+		itemLen = PlwStringRef_Len(itemRef);
 		PlwGrowArray(itemLen + (i > 0 ? 2 : 0), 1, &resultPtr, &resultPtrLen, &resultPtrCapacity, error);
 		if (PlwIsError(error)) {
 			PlwFree(resultPtr);
@@ -452,7 +511,7 @@ static void PlwNativeFunc_Text_ArrayOfText(PlwStackMachine *sm, PlwError *error)
 	}
 	resultPtr[resultPtrLen] = ']';
 	resultPtr[resultPtrLen + 1] = '\0';
-	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, error);
+	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, resultPtrLen + 1, error);
 	if (PlwIsError(error)) {
 		PlwFree(resultPtr);
 		return;
@@ -489,22 +548,31 @@ static void PlwNativeFunc_Concat_Text_Text(PlwStackMachine *sm, PlwError *error)
 	}
 	ptr1 = PlwStringRef_Ptr(ref1);
 	ptr2 = PlwStringRef_Ptr(ref2);
-	len1 = strlen(ptr1);
-	len2 = strlen(ptr2);
-	ptr = PlwAlloc(len1 + len2 + 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
-	memcpy(ptr, ptr1, len1);
-	memcpy(ptr + len1, ptr2, len2 + 1);
-	resultRefId = PlwStringRef_Make(sm->refMan, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
-	PlwRefManager_DecRefCount(sm->refMan, refId1, error);
-	if (PlwIsError(error)) {
-		return;
+	len1 = PlwStringRef_Len(ref1);
+	len2 = PlwStringRef_Len(ref2);
+	if (PlwStringRef_Append(ref1, ptr2, len2, error)) {
+		resultRefId = refId1;
+	} else {
+		if (PlwIsError(error)) {
+			return;
+		}
+		/* the chars of the result are apart from it, so that appending to it grows them in place */
+		ptr = PlwAlloc(len1 + len2 + 1, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		memcpy(ptr, ptr1, len1);
+		memcpy(ptr + len1, ptr2, len2);
+		ptr[len1 + len2] = '\0';
+		resultRefId = PlwStringRef_Make(sm->refMan, ptr, len1 + len2, error);
+		if (PlwIsError(error)) {
+			PlwFree(ptr);
+			return;
+		}
+		PlwRefManager_DecRefCount(sm->refMan, refId1, error);
+		if (PlwIsError(error)) {
+			return;
+		}
 	}
 	PlwRefManager_DecRefCount(sm->refMan, refId2, error);
 	if (PlwIsError(error)) {
@@ -519,41 +587,34 @@ static void PlwNativeFunc_Concat_Text_Text(PlwStackMachine *sm, PlwError *error)
 static void PlwNativeFunc_Subtext_Text_Integer_Integer(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwStringRef *ref;
-	char *ptr;
 	PlwInt len;
 	PlwInt index;
 	PlwInt sublen;
-	char *resultPtr;
 	PlwRefId resultRefId;
 	refId = sm->stack[sm->sp - 4];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwStringRefTagName, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwStringRef_Ptr(ref);
-	len = strlen(ptr);
+	len = PlwStringRef_Len(ref);
 	index = sm->stack[sm->sp - 3];
 	sublen = sm->stack[sm->sp - 2];
 	if (index < 0) {
 		index = 0;
 	}
+	if (index > len) {
+		index = len;
+	}
 	if (sublen < 0) {
 		sublen = 0;
 	}
 	if (index + sublen > len) {
 		sublen = len - index;
 	}
-	resultPtr = PlwAlloc(sublen + 1, error);
+	resultRefId = PlwStringRef_MakeSubtext(sm->refMan, refId, ref, index, sublen, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	memcpy(resultPtr, ptr + index, sublen);
-	resultPtr[sublen] = '\0';
-	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, error);
-	if (PlwIsError(error)) {
-		PlwFree(resultPtr);
-		return;
-	}
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -566,19 +627,16 @@ static void PlwNativeFunc_Subtext_Text_Integer_Integer(PlwStackMachine *sm, PlwE
 static void PlwNativeFunc_Subtext_Text_Integer(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwStringRef *ref;
-	char *ptr;
 	PlwInt len;
 	PlwInt index;
 	PlwInt sublen;
-	char *resultPtr;
 	PlwRefId resultRefId;
 	refId = sm->stack[sm->sp - 3];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwStringRefTagName, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwStringRef_Ptr(ref);
-	len = strlen(ptr);
+	len = PlwStringRef_Len(ref);
 	index = sm->stack[sm->sp - 2];
 	if (index < 0) {
 		index = 0;
@@ -587,17 +645,10 @@ static void PlwNativeFunc_Subtext_Text_Integer(PlwStackMachine *sm, PlwError *er
 	if (sublen < 0) {
 		sublen = 0;
 	}
-	resultPtr = PlwAlloc(sublen + 1, error);
+	resultRefId = PlwStringRef_MakeSubtext(sm->refMan, refId, ref, index, sublen, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	memcpy(resultPtr, ptr + index, sublen);
-	resultPtr[sublen] = '\0';
-	resultRefId = PlwStringRef_Make(sm->refMan, resultPtr, error);
-	if (PlwIsError(error)) {
-		PlwFree(resultPtr);
-		return;
-	}
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -642,8 +693,6 @@ static void PlwNativeFunc_IndexOf_Char_Text(PlwStackMachine *sm, PlwError *error
 	PlwInt charCode;
 	PlwRefId refId;
 	PlwStringRef *ref;
-	char *ptr;
-	char *p;
 	PlwInt indexOf;
 	charCode = sm->stack[sm->sp - 3];
 	refId = sm->stack[sm->sp - 2];
@@ -651,9 +700,7 @@ static void PlwNativeFunc_IndexOf_Char_Text(PlwStackMachine *sm, PlwError *error
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwStringRef_Ptr(ref);
-	p = strchr(ptr, charCode);
-	indexOf = p == NULL ? -1 : p - ptr;
+	indexOf = PlwTextSearch_FindChar(PlwStringRef_Ptr(ref), PlwStringRef_Len(ref), charCode);
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -670,7 +717,6 @@ static void PlwNativeFunc_IndexOf_Text_Text(PlwStackMachine *sm, PlwError *error
 	PlwRefId refId2;
 	PlwStringRef *ref2;
 	char *ptr2;
-	char *p;
 	PlwInt indexOf;
 	refId1 = sm->stack[sm->sp - 3];
 	ref1 = PlwRefManager_GetRefOfType(sm->refMan, refId1, PlwStringRefTagName, error);
@@ -684,8 +730,7 @@ static void PlwNativeFunc_IndexOf_Text_Text(PlwStackMachine *sm, PlwError *error
 	}
 	ptr1 = PlwStringRef_Ptr(ref1); 
 	ptr2 = PlwStringRef_Ptr(ref2);
-	p = strstr(ptr2, ptr1);
-	indexOf = p == NULL ? -1 : p - ptr2;
+	indexOf = PlwTextSearch_Find(ptr2, PlwStringRef_Len(ref2), ptr1, PlwStringRef_Len(ref1));
 	PlwRefManager_DecRefCount(sm->refMan, refId2, error);
 	if (PlwIsError(error)) {
 		return;
@@ -706,14 +751,15 @@ static void PlwNativeFunc_Split_Text_Text(PlwStackMachine *sm, PlwError *error)
 	PlwRefId refId2;
 	PlwStringRef *ref2;
 	char *ptr2;
-	size_t ptr2len;
+	PlwInt ptr1len;
+	PlwInt ptr2len;
 	PlwRefId *resultPtr = NULL;
 	PlwInt resultSize = 0;
 	PlwInt resultCapacity = 0;
 	PlwRefId resultRefId;
 	char *nextPos;
+	PlwInt nextIndex;
 	char *lastPos;
-	char *itemPtr;
 	PlwRefId itemRefId;
 	PlwBoolean again;
 	/*
@@ -731,28 +777,23 @@ static void PlwNativeFunc_Split_Text_Text(PlwStackMachine *sm, PlwError *error)
 	}
 	ptr1 = PlwStringRef_Ptr(ref1); 
 	ptr2 = PlwStringRef_Ptr(ref2);
-	ptr2len = strlen(ptr2);
+	ptr1len = PlwStringRef_Len(ref1);
+	ptr2len = PlwStringRef_Len(ref2);
 	/*
 	   Split the string
 	*/
 	lastPos = ptr1;
 	again = PlwTrue;
 	do {
-		nextPos = strstr(lastPos, ptr2);
-		if (nextPos == NULL) {
-			nextPos = ptr1 + strlen(ptr1);
+		nextIndex = PlwTextSearch_Find(lastPos, ptr1 + ptr1len - lastPos, ptr2, ptr2len);
+		if (nextIndex == -1) {
+			nextPos = ptr1 + ptr1len;
 			again = PlwFalse;
+		} else {
+			nextPos = lastPos + nextIndex;
 		}
-		itemPtr = PlwStrnDup(lastPos, nextPos - lastPos, error);
-		if (PlwIsError(error)) {
-			if (resultPtr != NULL) {
-				PlwFree(resultPtr);
-			}
-			return;
-		}
-		itemRefId = PlwStringRef_Make(sm->refMan, itemPtr, error);
+		itemRefId = PlwStringRef_MakeView(sm->refMan, refId1, ref1, lastPos - ptr1, nextPos - lastPos, error);
 		if (PlwIsError(error)) {
-			PlwFree(itemPtr);
 			if (resultPtr != NULL) {
 				PlwFree(resultPtr);
 			}
@@ -802,7 +843,6 @@ static void PlwNativeFunc_Split_Text_Text(PlwStackMachine *sm, PlwError *error)
 static void PlwNativeFunc_SliceBasicArray_Ref_Integer_Integer(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwBasicArrayRef *ref;
-	PlwInt *ptr;
 	PlwInt size;
 	PlwInt beginIndex;
 	PlwInt endIndex;
@@ -813,7 +853,6 @@ static void PlwNativeFunc_SliceBasicArray_Ref_Integer_Integer(PlwStackMachine *s
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwBasicArrayRef_Ptr(ref);
 	size = PlwBasicArrayRef_Size(ref);
 	beginIndex = sm->stack[sm->sp - 3];
 	endIndex = sm->stack[sm->sp - 2] + 1;
@@ -823,16 +862,14 @@ static void PlwNativeFunc_SliceBasicArray_Ref_Integer_Integer(PlwStackMachine *s
 	if (endIndex > size) {
 		endIndex = size;
 	}
-	resultPtr = PlwAlloc((endIndex - beginIndex) * sizeof(PlwInt), error);
-	if (PlwIsError(error)) {
-		return;
+	if (endIndex < beginIndex) {
+		endIndex = beginIndex;
 	}
-	memcpy(resultPtr, ptr + beginIndex, (endIndex - beginIndex) * sizeof(PlwInt));
-	resultRefId = PlwBasicArrayRef_Make(sm->refMan, endIndex - beginIndex, resultPtr, error);
+	resultRefId = PlwBasicArrayRef_MakeInline(sm->refMan, endIndex - beginIndex, PlwBasicArrayRef_ItemSize(ref), &resultPtr, error);
 	if (PlwIsError(error)) {
-		PlwFree(resultPtr);
 		return;
 	}
+	PlwBasicArrayRef_CopyItems(ref, beginIndex, endIndex - beginIndex, resultPtr);
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -845,7 +882,6 @@ static void PlwNativeFunc_SliceBasicArray_Ref_Integer_Integer(PlwStackMachine *s
 static void PlwNativeFunc_SliceArray_Ref_Integer_Integer(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwArrayRef *ref;
-	PlwRefId *ptr;
 	PlwInt size;
 	PlwInt beginIndex;
 	PlwInt endIndex;
@@ -857,7 +893,6 @@ static void PlwNativeFunc_SliceArray_Ref_Integer_Integer(PlwStackMachine *sm, Pl
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwArrayRef_Ptr(ref);
 	size = PlwArrayRef_Size(ref);
 	beginIndex = sm->stack[sm->sp - 3];
 	endIndex = sm->stack[sm->sp - 2] + 1;
@@ -867,16 +902,14 @@ static void PlwNativeFunc_SliceArray_Ref_Integer_Integer(PlwStackMachine *sm, Pl
 	if (endIndex > size) {
 		endIndex = size;
 	}
-	resultPtr = PlwAlloc((endIndex - beginIndex) * sizeof(PlwRefId), error);
-	if (PlwIsError(error)) {
-		return;
+	if (endIndex < beginIndex) {
+		endIndex = beginIndex;
 	}
-	memcpy(resultPtr, ptr + beginIndex, (endIndex - beginIndex) * sizeof(PlwRefId));
-	resultRefId = PlwArrayRef_Make(sm->refMan, endIndex - beginIndex, resultPtr, error);
+	resultRefId = PlwArrayRef_MakeInline(sm->refMan, endIndex - beginIndex, &resultPtr, error);
 	if (PlwIsError(error)) {
-		PlwFree(resultPtr);
 		return;
 	}
+	PlwArrayRef_CopyItems(ref, beginIndex, endIndex - beginIndex, resultPtr);
 	for (i = 0; i < endIndex - beginIndex; i++) {
 		PlwRefManager_IncRefCount(sm->refMan, resultPtr[i], error);
 		if (PlwIsError(error)) {
@@ -908,15 +941,37 @@ static void PlwNativeFunc_InArray_Ref_Ref(PlwStackMachine *sm, PlwError *error)
 	sm->stack[sm->sp - 1] = sm->stack[sm->sp - 1] != -1;	
 }
 
+/* copies the items of ref to ptr from offset, where the items take itemSize bytes */
+static void PlwNative_CopyBasicArrayItems(PlwRefManager *refMan, PlwBasicArrayRef *ref, PlwInt itemSize, PlwInt *ptr, PlwInt offset, PlwError *error) {
+	PlwInt size = PlwBasicArrayRef_Size(ref);
+	PlwInt refItemSize = PlwBasicArrayRef_ItemSize(ref);
+	PlwInt *refPtr;
+	PlwInt i;
+	if (refItemSize == itemSize) {
+		PlwBasicArrayRef_CopyItems(ref, 0, size, (char *) ptr + offset * itemSize);
+		return;
+	}
+	refPtr = PlwBasicArrayRef_Ptr(refMan, ref, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	for (i = 0; i < size; i++) {
+		if (itemSize == 1) {
+			((char *) ptr)[offset + i] = PlwBasicArrayRef_PtrItem(refPtr, refItemSize, i);
+		} else {
+			ptr[offset + i] = PlwBasicArrayRef_PtrItem(refPtr, refItemSize, i);
+		}
+	}
+}
+
 static void PlwNativeFunc_ConcatBasicArray_Ref_Ref(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId1;
 	PlwBasicArrayRef *ref1;
 	PlwRefId refId2;
 	PlwBasicArrayRef *ref2;
-	PlwInt *ptr1;
-	PlwInt *ptr2;
 	PlwInt size1;
 	PlwInt size2;
+	PlwInt itemSize;
 	PlwInt *ptr;
 	PlwRefId resultRefId;
 	refId1 = sm->stack[sm->sp - 3];
@@ -929,24 +984,37 @@ static void PlwNativeFunc_ConcatBasicArray_Ref_Ref(PlwStackMachine *sm, PlwError
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr1 = PlwBasicArrayRef_Ptr(ref1);
-	ptr2 = PlwBasicArrayRef_Ptr(ref2);
 	size1 = PlwBasicArrayRef_Size(ref1);
 	size2 = PlwBasicArrayRef_Size(ref2);
-	ptr = PlwAlloc((size1 + size2) * sizeof(PlwInt), error);
-	if (PlwIsError(error)) {
-		return;
-	}
-	memcpy(ptr, ptr1, size1 * sizeof(PlwInt));
-	memcpy(ptr + size1, ptr2, size2 * sizeof(PlwInt));
-	resultRefId = PlwBasicArrayRef_Make(sm->refMan, size1 + size2, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
-	PlwRefManager_DecRefCount(sm->refMan, refId1, error);
-	if (PlwIsError(error)) {
-		return;
+	if (PlwBasicArrayRef_Append(sm->refMan, ref1, ref2, error)) {
+		resultRefId = refId1;
+	} else {
+		if (PlwIsError(error)) {
+			return;
+		}
+		/* the items of the result are apart from it, so that appending to it grows them in place */
+		itemSize = size1 > 0 ? PlwBasicArrayRef_ItemSize(ref1) : PlwBasicArrayRef_ItemSize(ref2);
+		ptr = PlwAlloc(PlwBasicArrayRef_WordCount(size1 + size2, itemSize) * sizeof(PlwInt), error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		PlwNative_CopyBasicArrayItems(sm->refMan, ref1, itemSize, ptr, 0, error);
+		if (!PlwIsError(error)) {
+			PlwNative_CopyBasicArrayItems(sm->refMan, ref2, itemSize, ptr, size1, error);
+		}
+		if (PlwIsError(error)) {
+			PlwFree(ptr);
+			return;
+		}
+		resultRefId = PlwBasicArrayRef_Make(sm->refMan, size1 + size2, itemSize, ptr, error);
+		if (PlwIsError(error)) {
+			PlwFree(ptr);
+			return;
+		}
+		PlwRefManager_DecRefCount(sm->refMan, refId1, error);
+		if (PlwIsError(error)) {
+			return;
+		}
 	}
 	PlwRefManager_DecRefCount(sm->refMan, refId2, error);
 	if (PlwIsError(error)) {
@@ -962,8 +1030,6 @@ static void PlwNativeFunc_ConcatArray_Ref_Ref(PlwStackMachine *sm, PlwError *err
 	PlwArrayRef *ref1;
 	PlwRefId refId2;
 	PlwArrayRef *ref2;
-	PlwRefId *ptr1;
-	PlwRefId *ptr2;
 	PlwInt size1;
 	PlwInt size2;
 	PlwRefId *ptr;
@@ -979,30 +1045,36 @@ static void PlwNativeFunc_ConcatArray_Ref_Ref(PlwStackMachine *sm, PlwError *err
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr1 = PlwArrayRef_Ptr(ref1);
-	ptr2 = PlwArrayRef_Ptr(ref2);
 	size1 = PlwArrayRef_Size(ref1);
 	size2 = PlwArrayRef_Size(ref2);
-	ptr = PlwAlloc((size1 + size2) * sizeof(PlwRefId), error);
-	if (PlwIsError(error)) {
-		return;
-	}
-	memcpy(ptr, ptr1, size1 * sizeof(PlwRefId));
-	memcpy(ptr + size1, ptr2, size2 * sizeof(PlwRefId));
-	resultRefId = PlwArrayRef_Make(sm->refMan, size1 + size2, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
-	for (i = 0; i < size1 + size2; i++) {
-		PlwRefManager_IncRefCount(sm->refMan, ptr[i], error);
+	if (PlwArrayRef_Append(sm->refMan, ref1, ref2, error)) {
+		resultRefId = refId1;
+	} else {
+		if (PlwIsError(error)) {
+			return;
+		}
+		/* the items of the result are apart from it, so that appending to it grows them in place */
+		ptr = PlwAlloc((size1 + size2) * sizeof(PlwRefId), error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		PlwArrayRef_CopyItems(ref1, 0, size1, ptr);
+		PlwArrayRef_CopyItems(ref2, 0, size2, ptr + size1);
+		resultRefId = PlwArrayRef_Make(sm->refMan, size1 + size2, ptr, error);
+		if (PlwIsError(error)) {
+			PlwFree(ptr);
+			return;
+		}
+		for (i = 0; i < size1 + size2; i++) {
+			PlwRefManager_IncRefCount(sm->refMan, ptr[i], error);
+			if (PlwIsError(error)) {
+				return;
+			}
+		}
+		PlwRefManager_DecRefCount(sm->refMan, refId1, error);
 		if (PlwIsError(error)) {
 			return;
 		}
-	}
-	PlwRefManager_DecRefCount(sm->refMan, refId1, error);
-	if (PlwIsError(error)) {
-		return;
 	}
 	PlwRefManager_DecRefCount(sm->refMan, refId2, error);
 	if (PlwIsError(error)) {
@@ -1065,15 +1137,13 @@ static void PlwNativeFunc_Random_Integer_Integer(PlwStackMachine *sm, PlwError *
 static void PlwNativeFunc_Integer_Text(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwStringRef *ref;
-	char *ptr;
 	PlwInt result;
 	refId = sm->stack[sm->sp - 2];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwStringRefTagName, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	ptr = PlwStringRef_Ptr(ref);
-	result = atol(ptr);
+	result = PlwNative_ParseInteger(PlwStringRef_Ptr(ref), PlwStringRef_Len(ref));
 	PlwRefManager_DecRefCount(sm->refMan, refId, error);
 	if (PlwIsError(error)) {
 		return;
@@ -1097,6 +1167,203 @@ static void PlwNativeFunc_Floor_Real(PlwStackMachine *sm, PlwError *error) {
 	sm->sp--;
 }
 
+/* an array of the size items grown at items, that are freed when the array cannot be made */
+static PlwRefId PlwNative_MakeIntegerArray(PlwRefManager *refMan, PlwInt *items, PlwInt size, PlwError *error) {
+	PlwRefId refId;
+	PlwInt *ptr;
+	if (size == 0) {
+		return PlwBasicArrayRef_MakeInline(refMan, 0, sizeof(PlwInt), &ptr, error);
+	}
+	refId = PlwBasicArrayRef_Make(refMan, size, sizeof(PlwInt), items, error);
+	if (PlwIsError(error)) {
+		PlwFree(items);
+		return -1;
+	}
+	return refId;
+}
+
+/* the integers of the pieces that split would make, read in the same pass as the search of the separator */
+static void PlwNativeFunc_ParseIntegers_Text_Text(PlwStackMachine *sm, PlwError *error) {
+	PlwRefId refId1;
+	PlwStringRef *ref1;
+	char *ptr1;
+	PlwInt len1;
+	PlwRefId refId2;
+	PlwStringRef *ref2;
+	char *ptr2;
+	PlwInt len2;
+	PlwInt *resultPtr = NULL;
+	PlwInt resultSize = 0;
+	PlwInt resultCapacity = 0;
+	PlwRefId resultRefId;
+	PlwInt pos = 0;
+	PlwInt nextIndex;
+	PlwInt pieceLen;
+	refId1 = sm->stack[sm->sp - 3];
+	ref1 = PlwRefManager_GetRefOfType(sm->refMan, refId1, PlwStringRefTagName, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	refId2 = sm->stack[sm->sp - 2];
+	ref2 = PlwRefManager_GetRefOfType(sm->refMan, refId2, PlwStringRefTagName, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	ptr1 = PlwStringRef_Ptr(ref1);
+	len1 = PlwStringRef_Len(ref1);
+	ptr2 = PlwStringRef_Ptr(ref2);
+	len2 = PlwStringRef_Len(ref2);
+	/* an empty separator leaves the text in one piece */
+	do {
+		nextIndex = len2 == 0 ? -1 : PlwTextSearch_Find(ptr1 + pos, len1 - pos, ptr2, len2);
+		pieceLen = nextIndex == -1 ? len1 - pos : nextIndex;
+		PlwGrowArray(1, sizeof(PlwInt), &resultPtr, &resultSize, &resultCapacity, error);
+		if (PlwIsError(error)) {
+			if (resultPtr != NULL) {
+				PlwFree(resultPtr);
+			}
+			return;
+		}
+		resultPtr[resultSize - 1] = PlwNative_ParseInteger(ptr1 + pos, pieceLen);
+		pos += pieceLen + len2;
+	} while (nextIndex != -1);
+	resultRefId = PlwNative_MakeIntegerArray(sm->refMan, resultPtr, resultSize, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	PlwRefManager_DecRefCount(sm->refMan, refId2, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	PlwRefManager_DecRefCount(sm->refMan, refId1, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	sm->stack[sm->sp - 3] = resultRefId;
+	sm->stackMap[sm->sp - 3] = PlwTrue;
+	sm->sp -= 2;
+}
+
+/* all the runs of digits of the text, negative when a minus sign is right before them */
+static void PlwNativeFunc_ScanIntegers_Text(PlwStackMachine *sm, PlwError *error) {
+	PlwRefId refId;
+	PlwStringRef *ref;
+	const char *ptr;
+	const char *p;
+	const char *end;
+	PlwInt *resultPtr = NULL;
+	PlwInt resultSize = 0;
+	PlwInt resultCapacity = 0;
+	PlwRefId resultRefId;
+	PlwBoolean negative;
+	uint64_t value;
+	refId = sm->stack[sm->sp - 2];
+	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwStringRefTagName, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	ptr = PlwStringRef_Ptr(ref);
+	end = ptr + PlwStringRef_Len(ref);
+	p = ptr;
+	while (p < end) {
+		if (*p < '0' || *p > '9') {
+			p++;
+			continue;
+		}
+		negative = p > ptr && p[-1] == '-';
+		value = 0;
+		do {
+			value = value * 10 + (*p - '0');
+			p++;
+		} while (p < end && *p >= '0' && *p <= '9');
+		PlwGrowArray(1, sizeof(PlwInt), &resultPtr, &resultSize, &resultCapacity, error);
+		if (PlwIsError(error)) {
+			if (resultPtr != NULL) {
+				PlwFree(resultPtr);
+			}
+			return;
+		}
+		resultPtr[resultSize - 1] = negative ? (PlwInt) (0 - value) : (PlwInt) value;
+	}
+	resultRefId = PlwNative_MakeIntegerArray(sm->refMan, resultPtr, resultSize, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	PlwRefManager_DecRefCount(sm->refMan, refId, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	sm->stack[sm->sp - 2] = resultRefId;
+	sm->stackMap[sm->sp - 2] = PlwTrue;
+	sm->sp--;
+}
+
+/* the array on the stack is sorted in place, after a copy when it is shared */
+static void PlwNative_SortArray(PlwStackMachine *sm, const char *refType, PlwBoolean isReals, PlwBoolean isReverse, PlwError *error) {
+	PlwRefId refId;
+	void *ref;
+	PlwInt *ptr;
+	PlwInt size;
+	refId = PlwRefManager_MakeMutable(sm->refMan, sm->stack[sm->sp - 2], error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	sm->stack[sm->sp - 2] = refId;
+	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, refType, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	if (refType == PlwArrayRefTagName) {
+		size = PlwArrayRef_Size(ref);
+		ptr = PlwArrayRef_Ptr(sm->refMan, ref, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		PlwSort_Texts(sm->refMan, ptr, size, error);
+	} else {
+		size = PlwBasicArrayRef_Size(ref);
+		ptr = PlwBasicArrayRef_Ptr(sm->refMan, ref, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		if (isReals) {
+			PlwSort_Reals(ptr, size, error);
+		} else {
+			PlwSort_Integers(ptr, size, error);
+		}
+	}
+	if (PlwIsError(error)) {
+		return;
+	}
+	if (isReverse) {
+		PlwSort_Reverse(ptr, size);
+	}
+	sm->sp--;
+}
+
+static void PlwNativeFunc_Sort_ArrayOfInteger(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwBasicArrayRefTagName, PlwFalse, PlwFalse, error);
+}
+
+static void PlwNativeFunc_Sort_ArrayOfReal(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwBasicArrayRefTagName, PlwTrue, PlwFalse, error);
+}
+
+static void PlwNativeFunc_Sort_ArrayOfText(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwArrayRefTagName, PlwFalse, PlwFalse, error);
+}
+
+static void PlwNativeFunc_ReverseSort_ArrayOfInteger(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwBasicArrayRefTagName, PlwFalse, PlwTrue, error);
+}
+
+static void PlwNativeFunc_ReverseSort_ArrayOfReal(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwBasicArrayRefTagName, PlwTrue, PlwTrue, error);
+}
+
+static void PlwNativeFunc_ReverseSort_ArrayOfText(PlwStackMachine *sm, PlwError *error) {
+	PlwNative_SortArray(sm, PlwArrayRefTagName, PlwFalse, PlwTrue, error);
+}
 
 const PlwNativeFunction PlwNativeFunctions[] = {
 	PlwNativeFunc_GetChar_Char,
@@ -1141,8 +1408,124 @@ const PlwNativeFunction PlwNativeFunctions[] = {
 	PlwNativeFunc_Random_Integer_Integer,
 	PlwNativeFunc_Integer_Text,
 	PlwNativeFunc_Ceil_Real,
-	PlwNativeFunc_Floor_Real
+	PlwNativeFunc_Floor_Real,
+	PlwNativeFunc_ParseIntegers_Text_Text,
+	PlwNativeFunc_ScanIntegers_Text,
+	PlwNativeFunc_Sort_ArrayOfInteger,
+	PlwNativeFunc_Sort_ArrayOfReal,
+	PlwNativeFunc_Sort_ArrayOfText,
+	PlwNativeFunc_ReverseSort_ArrayOfInteger,
+	PlwNativeFunc_ReverseSort_ArrayOfReal,
+	PlwNativeFunc_ReverseSort_ArrayOfText
 };
 
 const PlwInt PlwNativeFunctionCount = sizeof(PlwNativeFunctions) / sizeof(PlwNativeFunction);
 
+/* in the same order as PlwNativeFunctions */
+const PlwInt PlwNativeFunctionArgCounts[] = {
+	0, /* Func_GetChar_Char */
+	1, /* Proc_Write_Text */
+	1, /* Proc_Print_Text */
+	1, /* Func_Print_Text */
+	1, /* Func_Text_Integer */
+	1, /* Func_Text_Real */
+	1, /* Func_Text_Char */
+	1, /* Func_Text_Boolean */
+	1, /* Func_Length_BasicArray */
+	1, /* Func_LastIndex_BasicArray */
+	1, /* Func_Length_Array */
+	1, /* Func_LastIndex_Array */
+	1, /* Func_Length_Text */
+	2, /* Func_IndexOfArray_Ref_Ref */
+	2, /* Func_IndexOfBasicArray_Integer_Ref */
+	1, /* Func_Text_ArrayOfChar */
+	1, /* Func_Text_ArrayOfInteger */
+	1, /* Func_Text_ArrayOfBoolean */
+	1, /* Func_Text_ArrayOfText */
+	2, /* Func_Concat_Text_Text */
+	3, /* Func_Subtext_Text_Integer_Integer */
+	2, /* Func_Subtext_Text_Integer */
+	1, /* Func_Trim_Integer */
+	2, /* Func_CharCode_Text_Integer */
+	2, /* Func_CharAt_Text_Integer */
+	2, /* Func_IndexOf_Char_Text */
+	2, /* Func_IndexOf_Text_Text */
+	2, /* Func_Split_Text_Text */
+	3, /* Func_SliceBasicArray_Ref_Integer_Integer */
+	3, /* Func_SliceArray_Ref_Integer_Integer */
+	2, /* Func_InBasicArray_Integer_Ref */
+	2, /* Func_InArray_Ref_Ref */
+	2, /* Func_ConcatBasicArray_Ref_Ref */
+	2, /* Func_ConcatArray_Ref_Ref */
+	1, /* Func_Abs_Integer */
+	1, /* Func_Real_Integer */
+	1, /* Func_Sqrt_Real */
+	1, /* Func_Log_Real */
+	0, /* Func_Now */
+	2, /* Func_Random_Integer_Integer */
+	1, /* Func_Integer_Text */
+	1, /* Func_Ceil_Real */
+	1, /* Func_Floor_Real */
+	2, /* Func_ParseIntegers_Text_Text */
+	1, /* Func_ScanIntegers_Text */
+	1, /* Func_Sort_ArrayOfInteger */
+	1, /* Func_Sort_ArrayOfReal */
+	1, /* Func_Sort_ArrayOfText */
+	1, /* Func_ReverseSort_ArrayOfInteger */
+	1, /* Func_ReverseSort_ArrayOfReal */
+	1 /* Func_ReverseSort_ArrayOfText */
+};
+
+const PlwInt PlwNativeFunctionResultCounts[] = {
+	1, /* Func_GetChar_Char */
+	0, /* Proc_Write_Text */
+	0, /* Proc_Print_Text */
+	1, /* Func_Print_Text */
+	1, /* Func_Text_Integer */
+	1, /* Func_Text_Real */
+	1, /* Func_Text_Char */
+	1, /* Func_Text_Boolean */
+	1, /* Func_Length_BasicArray */
+	1, /* Func_LastIndex_BasicArray */
+	1, /* Func_Length_Array */
+	1, /* Func_LastIndex_Array */
+	1, /* Func_Length_Text */
+	1, /* Func_IndexOfArray_Ref_Ref */
+	1, /* Func_IndexOfBasicArray_Integer_Ref */
+	1, /* Func_Text_ArrayOfChar */
+	1, /* Func_Text_ArrayOfInteger */
+	1, /* Func_Text_ArrayOfBoolean */
+	1, /* Func_Text_ArrayOfText */
+	1, /* Func_Concat_Text_Text */
+	1, /* Func_Subtext_Text_Integer_Integer */
+	1, /* Func_Subtext_Text_Integer */
+	1, /* Func_Trim_Integer */
+	1, /* Func_CharCode_Text_Integer */
+	1, /* Func_CharAt_Text_Integer */
+	1, /* Func_IndexOf_Char_Text */
+	1, /* Func_IndexOf_Text_Text */
+	1, /* Func_Split_Text_Text */
+	1, /* Func_SliceBasicArray_Ref_Integer_Integer */
+	1, /* Func_SliceArray_Ref_Integer_Integer */
+	1, /* Func_InBasicArray_Integer_Ref */
+	1, /* Func_InArray_Ref_Ref */
+	1, /* Func_ConcatBasicArray_Ref_Ref */
+	1, /* Func_ConcatArray_Ref_Ref */
+	1, /* Func_Abs_Integer */
+	1, /* Func_Real_Integer */
+	1, /* Func_Sqrt_Real */
+	1, /* Func_Log_Real */
+	1, /* Func_Now */
+	1, /* Func_Random_Integer_Integer */
+	1, /* Func_Integer_Text */
+	1, /* Func_Ceil_Real */
+	1, /* Func_Floor_Real */
+	1, /* Func_ParseIntegers_Text_Text */
+	1, /* Func_ScanIntegers_Text */
+	1, /* Func_Sort_ArrayOfInteger */
+	1, /* Func_Sort_ArrayOfReal */
+	1, /* Func_Sort_ArrayOfText */
+	1, /* Func_ReverseSort_ArrayOfInteger */
+	1, /* Func_ReverseSort_ArrayOfReal */
+	1 /* Func_ReverseSort_ArrayOfText */
+};
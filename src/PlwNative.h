@@ -3,10 +3,14 @@
 
 #include "PlwStackMachine.h"
 
-const char * const PlwNativeErrorNotImplemented;
+extern const char * const PlwNativeErrorNotImplemented;
 
 extern const PlwNativeFunction PlwNativeFunctions[];
 
 extern const PlwInt PlwNativeFunctionCount;
 
+extern const PlwInt PlwNativeFunctionArgCounts[];
+
+extern const PlwInt PlwNativeFunctionResultCounts[];
+
 #endif
@@ -42,6 +42,7 @@ const char * const PlwOpcodes[] = {
 	"ENDED",
 	"BASIC_ARRAY_TIMES",
 	"ARRAY_TIMES",
+	"BYTE_ARRAY_TIMES",
 	"JZ",
 	"JNZ",
 	"JMP",
@@ -66,6 +67,21 @@ const char * const PlwOpcodes[] = {
 	"CALL_NATIVE",
 	"INIT_GENERATOR",
 	"CREATE_EXCEPTION_HANDLER",
-	"PUSHF"
+	"PUSHF",
+	"PUSH_PTR_OFFSET_CONST",
+	"ADD_CONST",
+	"EQ_CONST",
+	"CALL_ABSTRACT_PROC",
+	"TAIL_CALL",
+	"PUSH_GLOBAL_MOVE",
+	"PUSH_LOCAL_MOVE",
+	"PUSH_GLOBAL_BORROW",
+	"PUSH_LOCAL_BORROW",
+	"CREATE_BYTE_ARRAY",
+	"PUSH_LOCAL_PUSH_LOCAL",
+	"PUSH_GLOBAL_PUSH_GLOBAL",
+	"INC_LOCAL",
+	"JGT_LOCAL_LOCAL",
+	"JLT_LOCAL_LOCAL"
 };
 
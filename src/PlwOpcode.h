@@ -1,6 +1,9 @@
 #ifndef PLWOPCODE_H_
 #define PLWOPCODE_H_
 
+/* written at the start of the .plwc files, to bump whenever opcodes are added, renumbered or change */
+#define PLW_OPCODE_VERSION									1
+
 #define PLW_OPCODE_NOP										0
 #define PLW_OPCODE_SUSPEND									1
 #define PLW_OPCODE_DUP										2
@@ -44,36 +47,64 @@
 #define PLW_OPCODE_ENDED									40
 #define PLW_OPCODE_BASIC_ARRAY_TIMES						41
 #define PLW_OPCODE_ARRAY_TIMES								42
+#define PLW_OPCODE_BYTE_ARRAY_TIMES							43
 
-#define PLW_OPCODE1_MAX										42
+#define PLW_OPCODE1_MAX										43
 			
 /* One arg */			
 			
-#define PLW_OPCODE_JZ										43
-#define PLW_OPCODE_JNZ										44
-#define PLW_OPCODE_JMP										45
-#define PLW_OPCODE_PUSH										46
-#define PLW_OPCODE_PUSH_GLOBAL								47
-#define PLW_OPCODE_PUSH_GLOBAL_FOR_MUTATE					48
-#define PLW_OPCODE_PUSH_LOCAL								49
-#define PLW_OPCODE_PUSH_LOCAL_FOR_MUTATE					50
-#define PLW_OPCODE_PUSH_INDIRECTION							51
-#define PLW_OPCODE_PUSH_INDIRECT							52
-#define PLW_OPCODE_PUSH_INDIRECT_FOR_MUTATE					53
-#define PLW_OPCODE_POP_GLOBAL								54
-#define PLW_OPCODE_POP_LOCAL								55
-#define PLW_OPCODE_POP_INDIRECT								56
-#define PLW_OPCODE_POP_VOID									57
-#define PLW_OPCODE_CREATE_STRING							58
-#define PLW_OPCODE_CREATE_RECORD							59
-#define PLW_OPCODE_CREATE_BASIC_ARRAY						60
-#define PLW_OPCODE_CREATE_ARRAY							 	61
-#define PLW_OPCODE_CALL										62
-#define PLW_OPCODE_CALL_ABSTRACT							63
-#define PLW_OPCODE_CALL_NATIVE								64
-#define PLW_OPCODE_INIT_GENERATOR							65
-#define PLW_OPCODE_CREATE_EXCEPTION_HANDLER					66
-#define PLW_OPCODE_PUSHF									67
+#define PLW_OPCODE_JZ										44
+#define PLW_OPCODE_JNZ										45
+#define PLW_OPCODE_JMP										46
+#define PLW_OPCODE_PUSH										47
+#define PLW_OPCODE_PUSH_GLOBAL								48
+#define PLW_OPCODE_PUSH_GLOBAL_FOR_MUTATE					49
+#define PLW_OPCODE_PUSH_LOCAL								50
+#define PLW_OPCODE_PUSH_LOCAL_FOR_MUTATE					51
+#define PLW_OPCODE_PUSH_INDIRECTION							52
+#define PLW_OPCODE_PUSH_INDIRECT							53
+#define PLW_OPCODE_PUSH_INDIRECT_FOR_MUTATE					54
+#define PLW_OPCODE_POP_GLOBAL								55
+#define PLW_OPCODE_POP_LOCAL								56
+#define PLW_OPCODE_POP_INDIRECT								57
+#define PLW_OPCODE_POP_VOID									58
+#define PLW_OPCODE_CREATE_STRING							59
+#define PLW_OPCODE_CREATE_RECORD							60
+#define PLW_OPCODE_CREATE_BASIC_ARRAY						61
+#define PLW_OPCODE_CREATE_ARRAY							 	62
+#define PLW_OPCODE_CALL										63
+#define PLW_OPCODE_CALL_ABSTRACT							64
+#define PLW_OPCODE_CALL_NATIVE								65
+#define PLW_OPCODE_INIT_GENERATOR							66
+#define PLW_OPCODE_CREATE_EXCEPTION_HANDLER					67
+#define PLW_OPCODE_PUSHF									68
+#define PLW_OPCODE_PUSH_PTR_OFFSET_CONST					69
+#define PLW_OPCODE_ADD_CONST								70
+#define PLW_OPCODE_EQ_CONST									71
+#define PLW_OPCODE_CALL_ABSTRACT_PROC						72
+#define PLW_OPCODE_TAIL_CALL								73
+#define PLW_OPCODE_PUSH_GLOBAL_MOVE							74
+#define PLW_OPCODE_PUSH_LOCAL_MOVE							75
+#define PLW_OPCODE_PUSH_GLOBAL_BORROW						76
+#define PLW_OPCODE_PUSH_LOCAL_BORROW						77
+#define PLW_OPCODE_CREATE_BYTE_ARRAY						78
+
+#define PLW_OPCODE2_MAX										78
+
+/* Two args */
+
+#define PLW_OPCODE_PUSH_LOCAL_PUSH_LOCAL					79
+#define PLW_OPCODE_PUSH_GLOBAL_PUSH_GLOBAL					80
+#define PLW_OPCODE_INC_LOCAL								81
+
+#define PLW_OPCODE3_MAX										81
+
+/* Three args */
+
+#define PLW_OPCODE_JGT_LOCAL_LOCAL							82
+#define PLW_OPCODE_JLT_LOCAL_LOCAL							83
+
+#define PLW_OPCODE_MAX										83
 
 extern const char * const PlwOpcodes[];
 
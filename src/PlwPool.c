@@ -0,0 +1,175 @@
+#include "PlwPool.h"
+#include <stdio.h>
+
+#ifdef PLW_POOL_ALLOC
+
+#define PLW_POOL_SLAB_SIZE 32768
+
+typedef struct PlwPoolBlock {
+	struct PlwPoolBlock *next;
+} PlwPoolBlock;
+
+/* a slab starts with the link to the previous slab, padded to a granule, and its blocks follow */
+typedef union PlwPoolSlab {
+	union PlwPoolSlab *next;
+	char padding[PLW_POOL_GRANULE];
+} PlwPoolSlab;
+
+typedef struct PlwPoolClass {
+	PlwPoolBlock *freeBlocks;
+	/* hits are served by the free list, misses carve a new slab first */
+	PlwInt hits;
+	PlwInt misses;
+	PlwInt liveCount;
+	PlwInt slabBytes;
+} PlwPoolClass;
+
+struct PlwPool {
+	PlwPoolClass classes[PLW_POOL_CLASS_COUNT];
+	PlwPoolSlab *slabs;
+	PlwInt largeCount;
+	PlwInt largeBytes;
+};
+
+PlwPool *PlwPool_Create(PlwError *error) {
+	PlwPool *pool;
+	PlwInt i;
+	pool = PlwAlloc(sizeof(PlwPool), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	for (i = 0; i < PLW_POOL_CLASS_COUNT; i++) {
+		pool->classes[i].freeBlocks = NULL;
+		pool->classes[i].hits = 0;
+		pool->classes[i].misses = 0;
+		pool->classes[i].liveCount = 0;
+		pool->classes[i].slabBytes = 0;
+	}
+	pool->slabs = NULL;
+	pool->largeCount = 0;
+	pool->largeBytes = 0;
+	return pool;
+}
+
+void PlwPool_Destroy(PlwPool *pool) {
+	PlwPoolSlab *slab;
+	PlwPoolSlab *next;
+	for (slab = pool->slabs; slab != NULL; slab = next) {
+		next = slab->next;
+		PlwFree(slab);
+	}
+	PlwFree(pool);
+}
+
+/* threads the blocks of a new slab into the free list of the class */
+static void PlwPool_AddSlab(PlwPool *pool, PlwInt classIndex, PlwError *error) {
+	PlwPoolClass *sizeClass = &pool->classes[classIndex];
+	size_t blockSize = (classIndex + 1) * PLW_POOL_GRANULE;
+	size_t blockCount = (PLW_POOL_SLAB_SIZE - sizeof(PlwPoolSlab)) / blockSize;
+	PlwPoolSlab *slab;
+	char *blocks;
+	PlwPoolBlock *block;
+	size_t i;
+	slab = PlwAlloc(PLW_POOL_SLAB_SIZE, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	blocks = (char *) (slab + 1);
+	for (i = blockCount; i > 0; i--) {
+		block = (PlwPoolBlock *) (blocks + (i - 1) * blockSize);
+		block->next = sizeClass->freeBlocks;
+		sizeClass->freeBlocks = block;
+	}
+	sizeClass->slabBytes += PLW_POOL_SLAB_SIZE;
+}
+
+void *PlwPool_Alloc(PlwPool *pool, size_t size, PlwError *error) {
+	PlwPoolClass *sizeClass;
+	PlwPoolBlock *block;
+	PlwInt classIndex;
+	if (size == 0 || size > PLW_POOL_MAX_SIZE) {
+		pool->largeCount++;
+		pool->largeBytes += size;
+		return PlwAlloc(size, error);
+	}
+	classIndex = (size - 1) / PLW_POOL_GRANULE;
+	sizeClass = &pool->classes[classIndex];
+	if (sizeClass->freeBlocks == NULL) {
+		PlwPool_AddSlab(pool, classIndex, error);
+		if (PlwIsError(error)) {
+			return NULL;
+		}
+		sizeClass->misses++;
+	} else {
+		sizeClass->hits++;
+	}
+	block = sizeClass->freeBlocks;
+	sizeClass->freeBlocks = block->next;
+	sizeClass->liveCount++;
+	return block;
+}
+
+void PlwPool_Free(PlwPool *pool, void *ptr, size_t size) {
+	PlwPoolClass *sizeClass;
+	PlwPoolBlock *block = ptr;
+	if (size == 0 || size > PLW_POOL_MAX_SIZE) {
+		PlwFree(ptr);
+		return;
+	}
+	sizeClass = &pool->classes[(size - 1) / PLW_POOL_GRANULE];
+	block->next = sizeClass->freeBlocks;
+	sizeClass->freeBlocks = block;
+	sizeClass->liveCount--;
+}
+
+void PlwPool_PrintStats(PlwPool *pool) {
+	PlwPoolClass *sizeClass;
+	PlwInt i;
+	for (i = 0; i < PLW_POOL_CLASS_COUNT; i++) {
+		sizeClass = &pool->classes[i];
+		if (sizeClass->hits + sizeClass->misses > 0) {
+			fprintf(stderr, "pool %3ld bytes: hits %ld, misses %ld, live %ld, slab bytes %ld\n", (i + 1) * PLW_POOL_GRANULE, sizeClass->hits, sizeClass->misses, sizeClass->liveCount, sizeClass->slabBytes);
+		}
+	}
+	fprintf(stderr, "pool large: allocs %ld, bytes %ld\n", pool->largeCount, pool->largeBytes);
+}
+
+#else
+
+struct PlwPool {
+	PlwInt allocCount;
+	PlwInt allocBytes;
+};
+
+PlwPool *PlwPool_Create(PlwError *error) {
+	PlwPool *pool;
+	pool = PlwAlloc(sizeof(PlwPool), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	pool->allocCount = 0;
+	pool->allocBytes = 0;
+	return pool;
+}
+
+void PlwPool_Destroy(PlwPool *pool) {
+	PlwFree(pool);
+}
+
+void *PlwPool_Alloc(PlwPool *pool, size_t size, PlwError *error) {
+	pool->allocCount++;
+	pool->allocBytes += size;
+	return PlwAlloc(size, error);
+}
+
+void PlwPool_Free(PlwPool *pool, void *ptr, size_t size) {
+	PlwFree(ptr);
+}
+
+void PlwPool_PrintStats(PlwPool *pool) {
+	fprintf(stderr, "pool disabled, built without PLW_POOL_ALLOC: allocs %ld, bytes %ld\n", pool->allocCount, pool->allocBytes);
+}
+
+#endif
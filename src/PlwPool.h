@@ -0,0 +1,33 @@
+#ifndef PLWPOOL_H_
+#define PLWPOOL_H_
+
+#include "PlwCommon.h"
+
+/*
+ * Allocator of the refs of a ref manager. Built with PLW_POOL_ALLOC, the
+ * blocks up to PLW_POOL_MAX_SIZE bytes are carved from slabs and recycled
+ * through a free list per size class, the bigger ones go to PlwAlloc.
+ * Built without it, every block goes to PlwAlloc. A block is freed with
+ * the size it was allocated with.
+ */
+
+#define PLW_POOL_GRANULE 16
+#define PLW_POOL_CLASS_COUNT 16
+#define PLW_POOL_MAX_SIZE (PLW_POOL_GRANULE * PLW_POOL_CLASS_COUNT)
+
+struct PlwPool;
+typedef struct PlwPool PlwPool;
+
+PlwPool *PlwPool_Create(PlwError *error);
+
+/* frees the slabs with the blocks they still hold, the bigger blocks must have been freed */
+void PlwPool_Destroy(PlwPool *pool);
+
+void *PlwPool_Alloc(PlwPool *pool, size_t size, PlwError *error);
+
+void PlwPool_Free(PlwPool *pool, void *ptr, size_t size);
+
+/* prints the counters of each size class to stderr */
+void PlwPool_PrintStats(PlwPool *pool);
+
+#endif
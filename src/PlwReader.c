@@ -0,0 +1,265 @@
+#include "PlwReader.h"
+#include "PlwCommon.h"
+#include "PlwOpcode.h"
+#include <string.h>
+#include <stdio.h>
+
+void PlwSetError(PlwError *error, const char *code, char *message) {
+	error->code = code;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "%s", message);
+}
+
+PlwBoolean IsCharBlank(int c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+int PlwSkipBlank(FILE *file) {
+	int c;
+	for (;;) {
+		c = fgetc(file);
+		if (!IsCharBlank(c)) {
+			return c;
+		}
+	}
+}
+
+PlwInt PlwReadNextInt(FILE *file, PlwError *error) {
+	char buffer[256];
+	char *p = buffer;
+	int c;
+	c = PlwSkipBlank(file);
+	if (c == EOF) {
+		PlwSetError(error, "EndOfFile", "Unexpected end of file");
+		return 0;
+	}
+	for(;;) {
+		if (!IsCharBlank(c)) {
+			*p = c;
+			p++;
+			if (p >= buffer + 255) break;
+			c = fgetc(file);
+		} else {
+			break;
+		}
+	}
+	*p = 0;
+	return atol(buffer);
+}
+
+PlwFloat PlwReadNextFloat(FILE *file, PlwError *error) {
+	char buffer[256];
+	char *p = buffer;
+	int c;
+	PlwFloat f;
+	c = PlwSkipBlank(file);
+	if (c == EOF) {
+		PlwSetError(error, "EndOfFile", "Unexpected end of file");
+		return 0;
+	}
+	for(;;) {
+		if (!IsCharBlank(c)) {
+			*p = c;
+			p++;
+			if (p >= buffer + 255) break;
+			c = fgetc(file);
+		} else {
+			break;
+		}
+	}
+	*p = 0;
+	f = strtod(buffer, NULL);
+	return f;
+}
+
+char *PlwReadNextString(FILE *file, PlwError *error) {
+	PlwInt len;
+	PlwInt i;
+	char *s;
+	int c;
+	len = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	s = PlwAlloc(len + 1, error);
+	for (i = 0; i < len; i++) {
+		c = fgetc(file);
+		if (c == EOF) {
+			PlwFree(s);
+			PlwSetError(error, "EndOfFile", "Unexpected end of file");
+			return NULL;
+		}
+		s[i] = c;
+	}
+	s[i] = '\0';
+	return s;
+}
+
+/* the opcodes of a file compiled for another version would decode into other opcodes without any error */
+void PlwReadVersion(FILE *file, PlwError *error) {
+	char buffer[5];
+	PlwInt version;
+	int c;
+	int i;
+	c = PlwSkipBlank(file);
+	for (i = 0; i < 4 && c != EOF && !IsCharBlank(c); i++) {
+		buffer[i] = c;
+		c = fgetc(file);
+	}
+	buffer[i] = '\0';
+	if (strcmp(buffer, "PLWC") != 0 || !IsCharBlank(c)) {
+		PlwSetError(error, "InvalidFormat", "Not a plwc file, or a plwc file without version that must be compiled again");
+		return;
+	}
+	version = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	if (version != PLW_OPCODE_VERSION) {
+		error->code = "VersionMismatch";
+		snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "plwc file of version %ld instead of %d, it must be compiled again", version, PLW_OPCODE_VERSION);
+	}
+}
+
+void PlwReadCodeBlock(FILE *file, PlwCodeBlock *codeBlock, PlwError *error) {
+	char *name = NULL;
+	PlwInt strConstSize = 0;
+	char **strConsts = NULL;
+	PlwInt floatConstSize = 0;
+	PlwFloat *floatConsts = NULL;
+	PlwInt codeSize = 0;
+	PlwInt *codes = NULL;
+	PlwInt i;
+	 
+	name = PlwReadNextString(file, error);
+	if (PlwIsError(error)) goto error;
+
+	strConstSize = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) goto error;
+	
+	strConsts = PlwAlloc(strConstSize * sizeof(char *), error);
+	if (PlwIsError(error)) goto error;
+	memset(strConsts, 0, strConstSize * sizeof(char *));
+	
+	for (i = 0; i < strConstSize; i++) {
+		strConsts[i] = PlwReadNextString(file, error);
+		if (PlwIsError(error)) goto error;
+	}
+	
+	floatConstSize = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) goto error;
+	
+	floatConsts = PlwAlloc(floatConstSize * sizeof(PlwFloat), error);	
+	if (PlwIsError(error)) goto error;
+	
+	for (i = 0; i < floatConstSize; i++) {
+		floatConsts[i] = PlwReadNextFloat(file, error);
+		if (PlwIsError(error)) goto error;
+	}
+		
+	codeSize = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) goto error;
+	
+	codes = PlwAlloc(codeSize * sizeof(PlwInt), error);
+	if (PlwIsError(error)) goto error;
+
+	for (i = 0; i < codeSize; i++) {
+		codes[i] = PlwReadNextInt(file, error);
+		if (PlwIsError(error)) goto error;
+	}
+	
+	codeBlock->name = name;
+	codeBlock->strConstCount = strConstSize;
+	codeBlock->strConsts = strConsts;
+	codeBlock->floatConstCount = floatConstSize;
+	codeBlock->floatConsts = floatConsts;
+	codeBlock->codeCount = codeSize;
+	codeBlock->codes = codes;
+	codeBlock->instructionCount = 0;
+	codeBlock->instructions = NULL;
+	codeBlock->callCacheCount = 0;
+	codeBlock->callCaches = NULL;
+	return;
+
+error:
+	if(name != NULL) PlwFree(name);
+	if (strConsts != NULL) {
+		for (i = 0; i < strConstSize; i++) {
+			if (strConsts[i] != NULL) PlwFree(strConsts[i]);
+		}
+		PlwFree(strConsts);
+	}
+	PlwFree(floatConsts);
+	PlwFree(codes);	
+}
+
+void PlwFreeCodeBlocks(PlwCodeBlock *codeBlocks, PlwInt codeBlockCount) {
+	PlwInt i, j;
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwFree(codeBlocks[i].name);
+		PlwFree(codeBlocks[i].codes);
+		for (j = 0; j < codeBlocks[i].strConstCount; j++) {
+			PlwFree(codeBlocks[i].strConsts[j]);
+		}
+		PlwFree(codeBlocks[i].strConsts);
+		PlwFree(codeBlocks[i].floatConsts);
+		PlwFree(codeBlocks[i].instructions);
+		PlwFree(codeBlocks[i].callCaches);
+	}
+	PlwFree(codeBlocks);
+}	
+
+void PlwReadCodeBlocksFromFile(
+	const char *fileName,
+	PlwCodeBlock **outCodeBlocks,
+	PlwInt *outCodeBlockCount,
+	PlwInt *outCodeBlockId,
+	PlwError *error
+) {
+	FILE *file;
+	PlwInt i;
+	PlwInt codeBlockCount;
+	PlwCodeBlock *codeBlocks;
+	PlwInt codeBlockId;
+	
+	file = fopen(fileName, "r");
+	if (file == NULL) {
+		PlwSetError(error, "FileNotFound", "File not found");
+		return;
+	}
+	
+	PlwReadVersion(file, error);
+	if (PlwIsError(error)) {
+		fclose(file);
+		return;
+	}
+	codeBlockCount = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) {
+		fclose(file);
+		return;
+	}
+	codeBlockId = PlwReadNextInt(file, error);
+	if (PlwIsError(error)) {
+		fclose(file);
+		return;
+	}
+	codeBlocks = PlwAlloc(codeBlockCount * sizeof(PlwCodeBlock), error);
+	if (PlwIsError(error)) {
+		fclose(file);
+		return;
+	}
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwReadCodeBlock(file, codeBlocks + i, error);
+		if (PlwIsError(error)) {
+			PlwFreeCodeBlocks(codeBlocks, i);
+			fclose(file);
+			return;
+		}
+#ifdef PLW_DEBUG_SM
+		printf("cs %ld: %s\n", i, codeBlocks[i].name);
+#endif
+	}
+	fclose(file);
+	*outCodeBlocks = codeBlocks;
+	*outCodeBlockCount = codeBlockCount;
+	*outCodeBlockId = codeBlockId;
+}
@@ -0,0 +1,18 @@
+#ifndef PLWREADER_H_
+#define PLWREADER_H_
+
+#include "PlwCommon.h"
+#include "PlwCodeBlock.h"
+
+/* reads the code blocks of a .plwc file, not decoded yet */
+void PlwReadCodeBlocksFromFile(
+	const char *fileName,
+	PlwCodeBlock **outCodeBlocks,
+	PlwInt *outCodeBlockCount,
+	PlwInt *outCodeBlockId,
+	PlwError *error
+);
+
+void PlwFreeCodeBlocks(PlwCodeBlock *codeBlocks, PlwInt codeBlockCount);
+
+#endif
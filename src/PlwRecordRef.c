@@ -7,6 +7,7 @@ struct PlwRecordRef {
 	PlwAbstractRef super;
 	PlwInt refSize;
 	PlwInt totalSize;
+	PlwInt layoutId;
 	PlwInt *ptr;
 };
 
@@ -25,7 +26,7 @@ const PlwAbstractRefTag PlwRecordRefTag = {
 PlwRefId PlwRecordRef_Make(PlwRefManager *refMan, PlwInt refSize, PlwInt totalSize, PlwInt *ptr, PlwError *error) {
 	PlwRecordRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwRecordRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwRecordRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
@@ -33,15 +34,40 @@ PlwRefId PlwRecordRef_Make(PlwRefManager *refMan, PlwInt refSize, PlwInt totalSi
 	ref->super.refCount = 1;
 	ref->refSize = refSize;
 	ref->totalSize = totalSize;
+	ref->layoutId = 0;
 	ref->ptr = ptr;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwRecordRef));
 		return -1;
 	}
 	return refId;
 }
 
+/* the cells follow the ref in the same allocation, *ptr is set to them for the caller to fill */
+PlwRefId PlwRecordRef_MakeInline(PlwRefManager *refMan, PlwInt refSize, PlwInt totalSize, PlwInt layoutId, PlwInt **ptr, PlwError *error) {
+	PlwRecordRef *ref;
+	PlwRefId refId;
+	*ptr = NULL;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwRecordRef) + totalSize * sizeof(PlwInt), error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	ref->super.tag = &PlwRecordRefTag;
+	ref->super.refCount = 1;
+	ref->refSize = refSize;
+	ref->totalSize = totalSize;
+	ref->layoutId = layoutId;
+	ref->ptr = (PlwInt *) (ref + 1);
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwRefManager_Free(refMan, ref, sizeof(PlwRecordRef) + totalSize * sizeof(PlwInt));
+		return -1;
+	}
+	*ptr = ref->ptr;
+	return refId;
+}
+
 PlwInt PlwRecordRef_RefSize(PlwRecordRef *ref) {
 	return ref->refSize;
 }
@@ -50,6 +76,10 @@ PlwInt PlwRecordRef_TotalSize(PlwRecordRef *ref) {
 	return ref->totalSize;
 }
 
+PlwInt PlwRecordRef_LayoutId(PlwRecordRef *ref) {
+	return ref->layoutId;
+}
+
 PlwInt *PlwRecordRef_Ptr(PlwRecordRef *ref) {
 	return ref->ptr;
 }
@@ -67,6 +97,8 @@ void PlwRecordRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset
 		}
 	}
 	recordRef->ptr[offset] = value;
+	/* the cells may no longer be the ones of the layout */
+	recordRef->layoutId = 0;
 }
 
 void PlwRecordRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwBoolean isForMutate, PlwError *error, PlwOffsetValue *result) {
@@ -88,8 +120,9 @@ void PlwRecordRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset
 PlwRefId PlwRecordRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	PlwRecordRef *recordRef = ref;
 	PlwInt *newPtr;
+	PlwRefId newRefId;
 	PlwInt i;
-	newPtr = PlwAlloc(recordRef->totalSize * sizeof(PlwInt), error);
+	newRefId = PlwRecordRef_MakeInline(refMan, recordRef->refSize, recordRef->totalSize, recordRef->layoutId, &newPtr, error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
@@ -100,7 +133,7 @@ PlwRefId PlwRecordRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *er
 			return -1;
 		}
 	}
-	return PlwRecordRef_Make(refMan, recordRef->refSize, recordRef->totalSize, newPtr, error);
+	return newRefId;
 }
 
 PlwBoolean PlwRecordRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2, PlwError *error) {
@@ -135,13 +168,16 @@ void PlwRecordRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
 			return;
 		}
 	}
-	PlwFree(recordRef->ptr);
-	PlwFree(recordRef);
+	PlwRecordRef_QuickDestroy(refMan, ref);
 }
 
-void PlwRecordRef_QuickDestroy(void *ref) {
+void PlwRecordRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwRecordRef *recordRef = ref;
-	PlwFree(recordRef->ptr);
-	PlwFree(recordRef);
+	if (recordRef->ptr != (PlwInt *) (recordRef + 1)) {
+		PlwFree(recordRef->ptr);
+		PlwRefManager_Free(refMan, recordRef, sizeof(PlwRecordRef));
+	} else {
+		PlwRefManager_Free(refMan, recordRef, sizeof(PlwRecordRef) + recordRef->totalSize * sizeof(PlwInt));
+	}
 }
 
@@ -9,10 +9,19 @@ typedef struct PlwRecordRef PlwRecordRef;
 
 PlwRefId PlwRecordRef_Make(PlwRefManager *refMan, PlwInt refSize, PlwInt totalSize, PlwInt *ptr, PlwError *error);
 
+/*
+ * layoutId is nonzero when the cells after the first are the constants of a
+ * creation site, the same for every record of the id. A write to the record
+ * resets it to 0.
+ */
+PlwRefId PlwRecordRef_MakeInline(PlwRefManager *refMan, PlwInt refSize, PlwInt totalSize, PlwInt layoutId, PlwInt **ptr, PlwError *error);
+
 PlwInt PlwRecordRef_RefSize(PlwRecordRef *ref);
 
 PlwInt PlwRecordRef_TotalSize(PlwRecordRef *ref);
 
+PlwInt PlwRecordRef_LayoutId(PlwRecordRef *ref);
+
 PlwInt *PlwRecordRef_Ptr(PlwRecordRef *ref);
 
 void PlwRecordRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error);
@@ -25,6 +34,6 @@ PlwBoolean PlwRecordRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2,
 
 void PlwRecordRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwRecordRef_QuickDestroy(void *ref);
+void PlwRecordRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
@@ -1,5 +1,6 @@
 #include "PlwRefManager.h"
 #include "PlwAbstractRef.h"
+#include "PlwPool.h"
 #include "PlwCommon.h"
 #include <stdio.h>
 #include <string.h>
@@ -32,13 +33,110 @@ void PlwRefManError_InvalidOperation(PlwError *error, const char *refType, const
 	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid operation %s for type %s", operation, refType);
 }
 
+/*
+ * With PLW_DIRECT_REFS a ref id is the address of the ref, so an access is a
+ * single load and is not checked: it relies on the compiler only emitting ref
+ * reads on cells that hold refs, which the code block verifier does not check.
+ * Without it, the ids index a table of the refs and every access is checked,
+ * which is the build to use when debugging the vm or running untrusted plwc.
+ */
+#ifdef PLW_DIRECT_REFS
+
+#define PlwRefManager_Ref(refMan, refId) ((PlwAbstractRef *) (intptr_t) (refId))
+
 struct PlwRefManagerStruct {
+	PlwPool *pool;
+	PlwAbstractRef *liveRefs;
+	PlwInt pendingRefIdCount;
+	PlwInt pendingRefIdCapacity;
+	PlwRefId *pendingRefIds;
+	PlwBoolean isFreeing;
+	PlwInt freeBudget;
+};
+
+PlwRefManager *PlwRefManager_Create(PlwError *error) {
+	PlwRefManager *refMan = PlwAlloc(sizeof(PlwRefManager), error);
+	if (PlwIsError(error)) {
+		return NULL;
+	}
+	refMan->pool = PlwPool_Create(error);
+	if (PlwIsError(error)) {
+		PlwFree(refMan);
+		return NULL;
+	}
+	refMan->liveRefs = NULL;
+	refMan->pendingRefIdCount = 0;
+	refMan->pendingRefIdCapacity = 0;
+	refMan->pendingRefIds = NULL;
+	refMan->isFreeing = PlwFalse;
+	refMan->freeBudget = 0;
+	return refMan;
+}
+
+void PlwRefManager_Destroy(PlwRefManager *refMan) {
+	PlwAbstractRef *ref;
+	PlwAbstractRef *next;
+	for (ref = refMan->liveRefs; ref != NULL; ref = next) {
+		next = ref->next;
+		PlwAbstractRef_QuickDestroy(refMan, ref);
+	}
+	PlwFree(refMan->pendingRefIds);
+	PlwPool_Destroy(refMan->pool);
+	PlwFree(refMan);
+}
+
+PlwInt PlwRefManager_RefCount(PlwRefManager *refMan) {
+	PlwAbstractRef *ref;
+	PlwInt count = 0;
+	for (ref = refMan->liveRefs; ref != NULL; ref = ref->next) {
+		count++;
+	}
+	return count - refMan->pendingRefIdCount;
+}
+
+PlwRefId PlwRefManager_AddRef(PlwRefManager *refMan, void *ref, PlwError *error) {
+	PlwAbstractRef *abstractRef = ref;
+	abstractRef->previous = NULL;
+	abstractRef->next = refMan->liveRefs;
+	if (refMan->liveRefs != NULL) {
+		refMan->liveRefs->previous = abstractRef;
+	}
+	refMan->liveRefs = abstractRef;
+	return (PlwRefId) (intptr_t) abstractRef;
+}
+
+#define PlwRefManager_CheckRefIdValid(refMan, refId, error) ((void) 0)
+
+static void PlwRefManager_FreeRef(PlwRefManager *refMan, PlwRefId refId, PlwError *error) {
+	PlwAbstractRef *ref = PlwRefManager_Ref(refMan, refId);
+	if (ref->previous != NULL) {
+		ref->previous->next = ref->next;
+	} else {
+		refMan->liveRefs = ref->next;
+	}
+	if (ref->next != NULL) {
+		ref->next->previous = ref->previous;
+	}
+	PlwAbstractRef_Destroy(refMan, ref, error);
+}
+
+#else
+
+#define PlwRefManager_Ref(refMan, refId) ((refMan)->refs[refId])
+
+struct PlwRefManagerStruct {
+	PlwPool *pool;
 	PlwInt refCount;
 	PlwInt refCapacity;
 	PlwAbstractRef **refs;
 	PlwInt freeRefIdCount;
 	PlwInt freeRefIdCapacity;
 	PlwInt *freeRefIds;
+	PlwInt pendingRefIdCount;
+	PlwInt pendingRefIdCapacity;
+	PlwRefId *pendingRefIds;
+	PlwBoolean isFreeing;
+	PlwInt freeBudget;
 };
 
 PlwRefManager *PlwRefManager_Create(PlwError *error) {
@@ -46,12 +144,22 @@ PlwRefManager *PlwRefManager_Create(PlwError *error) {
 	if (PlwIsError(error)) {
 		return NULL;
 	}
+	refMan->pool = PlwPool_Create(error);
+	if (PlwIsError(error)) {
+		PlwFree(refMan);
+		return NULL;
+	}
 	refMan->refCount = 0;
 	refMan->refCapacity = 0;
 	refMan->refs = NULL;
 	refMan->freeRefIdCount = 0;
 	refMan->freeRefIdCapacity = 0;
 	refMan->freeRefIds = NULL;
+	refMan->pendingRefIdCount = 0;
+	refMan->pendingRefIdCapacity = 0;
+	refMan->pendingRefIds = NULL;
+	refMan->isFreeing = PlwFalse;
+	refMan->freeBudget = 0;
 	return refMan;
 }
 
@@ -59,11 +167,13 @@ void PlwRefManager_Destroy(PlwRefManager *refMan) {
 	PlwInt i;
 	for (i = 0; i < refMan->refCount; i++) {
 		if (refMan->refs[i] != NULL) {
-			PlwAbstractRef_QuickDestroy(refMan->refs[i]);
+			PlwAbstractRef_QuickDestroy(refMan, refMan->refs[i]);
 		}
 	}
 	PlwFree(refMan->refs);
 	PlwFree(refMan->freeRefIds);
+	PlwFree(refMan->pendingRefIds);
+	PlwPool_Destroy(refMan->pool);
 	PlwFree(refMan);
 }
 
@@ -75,7 +185,7 @@ PlwInt PlwRefManager_RefCount(PlwRefManager *refMan) {
 			count++;
 		}
 	}
-	return count;
+	return count - refMan->pendingRefIdCount;
 }
 
 PlwRefId PlwRefManager_AddRef(PlwRefManager *refMan, void *ref, PlwError *error) {
@@ -101,12 +211,100 @@ static void PlwRefManager_CheckRefIdValid(PlwRefManager *refMan, PlwRefId refId,
 	}
 }
 
+static void PlwRefManager_FreeRef(PlwRefManager *refMan, PlwRefId refId, PlwError *error) {
+	PlwAbstractRef_Destroy(refMan, refMan->refs[refId], error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	refMan->refs[refId] = NULL;
+	PlwGrowArray(1, sizeof(PlwInt), &refMan->freeRefIds, &refMan->freeRefIdCount, &refMan->freeRefIdCapacity, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	refMan->freeRefIds[refMan->freeRefIdCount - 1] = refId;
+}
+
+#endif
+
+/*
+ * A ref whose count drops to zero is freed by the loop below instead of by
+ * recursion: the destroy of a ref releases its items, and the ones that drop
+ * to zero meanwhile are pushed on the pending refs. Out of the loop the
+ * pending refs are only garbage, still counted among the live ones. With a
+ * free budget, a release frees at most that many refs and each allocation
+ * frees one more, so that it reuses a block that was just freed.
+ */
+static void PlwRefManager_FreePendingRefs(PlwRefManager *refMan, PlwInt maxCount, PlwError *error) {
+	PlwRefId refId;
+	PlwInt freedCount = 0;
+	refMan->isFreeing = PlwTrue;
+	while (refMan->pendingRefIdCount > 0 && (maxCount < 0 || freedCount < maxCount)) {
+		refMan->pendingRefIdCount--;
+		refId = refMan->pendingRefIds[refMan->pendingRefIdCount];
+		PlwRefManager_FreeRef(refMan, refId, error);
+		if (PlwIsError(error)) {
+			break;
+		}
+		freedCount++;
+	}
+	refMan->isFreeing = PlwFalse;
+}
+
+static void PlwRefManager_ReleaseRef(PlwRefManager *refMan, PlwRefId refId, PlwError *error) {
+	if (!refMan->isFreeing && refMan->pendingRefIdCount == 0) {
+		/* most refs release no other, this one is freed without being pushed */
+		refMan->isFreeing = PlwTrue;
+		PlwRefManager_FreeRef(refMan, refId, error);
+		refMan->isFreeing = PlwFalse;
+		if (PlwIsError(error) || refMan->pendingRefIdCount == 0) {
+			return;
+		}
+		PlwRefManager_FreePendingRefs(refMan, refMan->freeBudget > 0 ? refMan->freeBudget - 1 : -1, error);
+		return;
+	}
+	PlwGrowArray(1, sizeof(PlwRefId), &refMan->pendingRefIds, &refMan->pendingRefIdCount, &refMan->pendingRefIdCapacity, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	refMan->pendingRefIds[refMan->pendingRefIdCount - 1] = refId;
+	if (!refMan->isFreeing) {
+		/* a negative count frees them all */
+		PlwRefManager_FreePendingRefs(refMan, refMan->freeBudget > 0 ? refMan->freeBudget : -1, error);
+	}
+}
+
+void PlwRefManager_SetFreeBudget(PlwRefManager *refMan, PlwInt freeBudget) {
+	refMan->freeBudget = freeBudget;
+}
+
+void PlwRefManager_FreeAllPendingRefs(PlwRefManager *refMan, PlwError *error) {
+	PlwRefManager_FreePendingRefs(refMan, -1, error);
+}
+
+void *PlwRefManager_Alloc(PlwRefManager *refMan, size_t size, PlwError *error) {
+	if (refMan->pendingRefIdCount > 0 && !refMan->isFreeing) {
+		PlwRefManager_FreePendingRefs(refMan, 1, error);
+		if (PlwIsError(error)) {
+			return NULL;
+		}
+	}
+	return PlwPool_Alloc(refMan->pool, size, error);
+}
+
+void PlwRefManager_Free(PlwRefManager *refMan, void *ptr, size_t size) {
+	PlwPool_Free(refMan->pool, ptr, size);
+}
+
+void PlwRefManager_PrintAllocStats(PlwRefManager *refMan) {
+	PlwPool_PrintStats(refMan->pool);
+}
+
 void *PlwRefManager_GetRef(PlwRefManager *refMan, PlwRefId refId, PlwError *error) {
 	PlwRefManager_CheckRefIdValid(refMan, refId, error);
 	if (PlwIsError(error)) {
 		return NULL;
 	}
-	return refMan->refs[refId];	
+	return PlwRefManager_Ref(refMan, refId);
 }
 
 void *PlwRefManager_GetRefOfType(PlwRefManager *refMan, PlwRefId refId, const char *refType, PlwError *error) {
@@ -128,7 +326,7 @@ void PlwRefManager_IncRefCount(PlwRefManager *refMan, PlwRefId refId, PlwError *
 	if (PlwIsError(error)) {
 		return;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	ref->refCount++;	
 }
 
@@ -138,7 +336,7 @@ void PlwRefManager_AddRefCount(PlwRefManager *refMan, PlwRefId refId, PlwInt cou
 	if (PlwIsError(error)) {
 		return;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	ref->refCount += count;	
 }
 
@@ -148,19 +346,10 @@ void PlwRefManager_DecRefCount(PlwRefManager *refMan, PlwRefId refId, PlwError *
 	if (PlwIsError(error)) {
 		return;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	ref->refCount--;
 	if (ref->refCount == 0) {
-		PlwAbstractRef_Destroy(refMan, ref, error);
-		if (PlwIsError(error)) {
-			return;
-		}
-		refMan->refs[refId] = NULL;
-		PlwGrowArray(1, sizeof(PlwInt), &refMan->freeRefIds, &refMan->freeRefIdCount, &refMan->freeRefIdCapacity, error);
-		if (PlwIsError(error)) {
-			return;
-		}
-		refMan->freeRefIds[refMan->freeRefIdCount - 1] = refId;
+		PlwRefManager_ReleaseRef(refMan, refId, error);
 	}	
 }
 
@@ -178,8 +367,8 @@ PlwBoolean PlwRefManager_CompareRefs(PlwRefManager *refMan, PlwRefId refId1, Plw
 	if (refId1 == refId2) {
 		return PlwTrue;
 	}
-	ref1 = refMan->refs[refId1];
-	ref2 = refMan->refs[refId2];
+	ref1 = PlwRefManager_Ref(refMan, refId1);
+	ref2 = PlwRefManager_Ref(refMan, refId2);
 	if (ref1->tag->name != ref2->tag->name) {
 		return PlwFalse;
 	}
@@ -193,7 +382,7 @@ PlwRefId PlwRefManager_MakeMutable(PlwRefManager *refMan, PlwRefId refId, PlwErr
 	if (PlwIsError(error)) {
 		return -1;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	if (ref->refCount == 1) {
 		return refId;
 	}
@@ -211,7 +400,7 @@ void PlwRefManager_GetOffsetValue(PlwRefManager *refMan, PlwRefId refId, PlwInt
 	if (PlwIsError(error)) {
 		return;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	PlwAbstractRef_GetOffsetValue(refMan, ref, offset, isForMutate, error, result);
 	if (PlwIsError(error)) {
 		int msgLen = strlen(error->message);
@@ -226,7 +415,7 @@ void PlwRefManager_SetOffsetValue(PlwRefManager *refMan, PlwRefId refId, PlwInt
 	if (PlwIsError(error)) {
 		return;
 	}
-	ref = refMan->refs[refId];
+	ref = PlwRefManager_Ref(refMan, refId);
 	PlwAbstractRef_SetOffsetValue(refMan, ref, offset, val, error);
 }
 
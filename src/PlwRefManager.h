@@ -28,6 +28,19 @@ void PlwRefManager_Destroy(PlwRefManager *refMan);
 
 PlwInt PlwRefManager_RefCount(PlwRefManager *refMan);
 
+/* allocates the memory of a ref, that is freed with the same size */
+void *PlwRefManager_Alloc(PlwRefManager *refMan, size_t size, PlwError *error);
+
+void PlwRefManager_Free(PlwRefManager *refMan, void *ptr, size_t size);
+
+void PlwRefManager_PrintAllocStats(PlwRefManager *refMan);
+
+/* a release frees at most freeBudget refs, 0 for no limit, and leaves the others to the next releases and allocations */
+void PlwRefManager_SetFreeBudget(PlwRefManager *refMan, PlwInt freeBudget);
+
+/* frees the refs left over by the free budget */
+void PlwRefManager_FreeAllPendingRefs(PlwRefManager *refMan, PlwError *error);
+
 PlwRefId PlwRefManager_AddRef(PlwRefManager *refMan, void *ref, PlwError *error);
 
 void *PlwRefManager_GetRef(PlwRefManager *refMan, PlwRefId refId, PlwError *error);
@@ -0,0 +1,281 @@
+#include "PlwSort.h"
+#include "PlwStringRef.h"
+#include <string.h>
+
+#define PLW_SORT_SIGN_BIT ((uint64_t) 1 << 63)
+
+static void PlwSort_InsertionKeys(uint64_t *keys, PlwInt count) {
+	PlwInt i;
+	PlwInt j;
+	uint64_t key;
+	for (i = 1; i < count; i++) {
+		key = keys[i];
+		for (j = i; j > 0 && keys[j - 1] > key; j--) {
+			keys[j] = keys[j - 1];
+		}
+		keys[j] = key;
+	}
+}
+
+/* the counts of the 8 bytes are taken in one pass, a byte that is the same in all the keys needs no pass */
+static void PlwSort_RadixKeys(uint64_t *keys, PlwInt count, PlwError *error) {
+	PlwInt counts[8][256];
+	uint64_t *tmp;
+	uint64_t *src;
+	uint64_t *dst;
+	uint64_t *swap;
+	PlwInt byteIndex;
+	PlwInt shift;
+	PlwInt offset;
+	PlwInt itemCount;
+	PlwInt i;
+	if (count <= PLW_SORT_INSERTION_MAX) {
+		PlwSort_InsertionKeys(keys, count);
+		return;
+	}
+	tmp = PlwAlloc(count * sizeof(uint64_t), error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < count; i++) {
+		for (byteIndex = 0; byteIndex < 8; byteIndex++) {
+			counts[byteIndex][(keys[i] >> (byteIndex * 8)) & 0xff]++;
+		}
+	}
+	src = keys;
+	dst = tmp;
+	for (byteIndex = 0; byteIndex < 8; byteIndex++) {
+		shift = byteIndex * 8;
+		if (counts[byteIndex][(src[0] >> shift) & 0xff] == count) {
+			continue;
+		}
+		offset = 0;
+		for (i = 0; i < 256; i++) {
+			itemCount = counts[byteIndex][i];
+			counts[byteIndex][i] = offset;
+			offset += itemCount;
+		}
+		for (i = 0; i < count; i++) {
+			dst[counts[byteIndex][(src[i] >> shift) & 0xff]++] = src[i];
+		}
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+	if (src != keys) {
+		memcpy(keys, src, count * sizeof(uint64_t));
+	}
+	PlwFree(tmp);
+}
+
+/* the sign bit is flipped so that the negative integers come first */
+void PlwSort_Integers(PlwInt *items, PlwInt count, PlwError *error) {
+	uint64_t *keys = (uint64_t *) items;
+	PlwInt i;
+	for (i = 0; i < count; i++) {
+		keys[i] ^= PLW_SORT_SIGN_BIT;
+	}
+	PlwSort_RadixKeys(keys, count, error);
+	for (i = 0; i < count; i++) {
+		keys[i] ^= PLW_SORT_SIGN_BIT;
+	}
+}
+
+/* the bits of a negative real are all flipped so that the larger magnitudes come first, the sign bit of the others is flipped */
+void PlwSort_Reals(PlwInt *items, PlwInt count, PlwError *error) {
+	uint64_t *keys = (uint64_t *) items;
+	PlwInt i;
+	for (i = 0; i < count; i++) {
+		keys[i] = (keys[i] & PLW_SORT_SIGN_BIT) != 0 ? ~keys[i] : keys[i] ^ PLW_SORT_SIGN_BIT;
+	}
+	PlwSort_RadixKeys(keys, count, error);
+	for (i = 0; i < count; i++) {
+		keys[i] = (keys[i] & PLW_SORT_SIGN_BIT) != 0 ? keys[i] ^ PLW_SORT_SIGN_BIT : ~keys[i];
+	}
+}
+
+/* prefix holds the first 8 chars of the text, high byte first and padded with zeros */
+typedef struct PlwSortText {
+	uint64_t prefix;
+	const char *ptr;
+	PlwInt len;
+	PlwRefId refId;
+} PlwSortText;
+
+static int PlwSort_CompareTexts(const PlwSortText *text1, const PlwSortText *text2) {
+	PlwInt len;
+	int result;
+	if (text1->prefix != text2->prefix) {
+		return text1->prefix < text2->prefix ? -1 : 1;
+	}
+	len = text1->len < text2->len ? text1->len : text2->len;
+	if (len > 8) {
+		result = memcmp(text1->ptr + 8, text2->ptr + 8, len - 8);
+		if (result != 0) {
+			return result;
+		}
+	}
+	return text1->len < text2->len ? -1 : text1->len > text2->len ? 1 : 0;
+}
+
+static void PlwSort_SwapTexts(PlwSortText *texts, PlwInt i, PlwInt j) {
+	PlwSortText text = texts[i];
+	texts[i] = texts[j];
+	texts[j] = text;
+}
+
+static void PlwSort_InsertionTexts(PlwSortText *texts, PlwInt count) {
+	PlwInt i;
+	PlwInt j;
+	PlwSortText text;
+	for (i = 1; i < count; i++) {
+		text = texts[i];
+		for (j = i; j > 0 && PlwSort_CompareTexts(&texts[j - 1], &text) > 0; j--) {
+			texts[j] = texts[j - 1];
+		}
+		texts[j] = text;
+	}
+}
+
+static void PlwSort_SiftDownTexts(PlwSortText *texts, PlwInt root, PlwInt count) {
+	PlwInt child;
+	while ((child = 2 * root + 1) < count) {
+		if (child + 1 < count && PlwSort_CompareTexts(&texts[child], &texts[child + 1]) < 0) {
+			child++;
+		}
+		if (PlwSort_CompareTexts(&texts[root], &texts[child]) >= 0) {
+			return;
+		}
+		PlwSort_SwapTexts(texts, root, child);
+		root = child;
+	}
+}
+
+static void PlwSort_HeapTexts(PlwSortText *texts, PlwInt count) {
+	PlwInt i;
+	for (i = count / 2 - 1; i >= 0; i--) {
+		PlwSort_SiftDownTexts(texts, i, count);
+	}
+	for (i = count - 1; i > 0; i--) {
+		PlwSort_SwapTexts(texts, 0, i);
+		PlwSort_SiftDownTexts(texts, 0, i);
+	}
+}
+
+/* moves the median of the three texts to i */
+static void PlwSort_MedianOfThree(PlwSortText *texts, PlwInt i, PlwInt j, PlwInt k) {
+	if (PlwSort_CompareTexts(&texts[j], &texts[i]) < 0) {
+		PlwSort_SwapTexts(texts, i, j);
+	}
+	if (PlwSort_CompareTexts(&texts[k], &texts[j]) < 0) {
+		PlwSort_SwapTexts(texts, j, k);
+		if (PlwSort_CompareTexts(&texts[j], &texts[i]) < 0) {
+			PlwSort_SwapTexts(texts, i, j);
+		}
+	}
+	PlwSort_SwapTexts(texts, i, j);
+}
+
+/*
+ * The pivot is the median of three texts, or of three medians for the larger
+ * counts, moved first. The texts equal to the pivot stop both scans and are
+ * spread over both sides, so that many equal texts still split evenly. The
+ * texts left to sort after depth splits are sorted by a heapsort.
+ */
+static void PlwSort_IntroTexts(PlwSortText *texts, PlwInt count, PlwInt depth) {
+	PlwInt i;
+	PlwInt j;
+	PlwInt step;
+	while (count > PLW_SORT_INSERTION_MAX) {
+		if (depth == 0) {
+			PlwSort_HeapTexts(texts, count);
+			return;
+		}
+		depth--;
+		if (count > 128) {
+			step = count / 8;
+			PlwSort_MedianOfThree(texts, 1, 1 + step, 1 + 2 * step);
+			PlwSort_MedianOfThree(texts, count / 2, count / 2 - step, count / 2 + step);
+			PlwSort_MedianOfThree(texts, count - 1, count - 1 - step, count - 1 - 2 * step);
+			PlwSort_MedianOfThree(texts, 1, count / 2, count - 1);
+			PlwSort_SwapTexts(texts, 0, 1);
+		} else {
+			PlwSort_MedianOfThree(texts, 0, count / 2, count - 1);
+		}
+		i = 0;
+		j = count;
+		for (;;) {
+			do {
+				i++;
+			} while (i < count && PlwSort_CompareTexts(&texts[i], &texts[0]) < 0);
+			do {
+				j--;
+			} while (PlwSort_CompareTexts(&texts[j], &texts[0]) > 0);
+			if (i >= j) {
+				break;
+			}
+			PlwSort_SwapTexts(texts, i, j);
+		}
+		PlwSort_SwapTexts(texts, 0, j);
+		/* the smaller side is sorted by recursion, so that the stack stays within log2(count) frames */
+		if (j < count - j - 1) {
+			PlwSort_IntroTexts(texts, j, depth);
+			texts += j + 1;
+			count -= j + 1;
+		} else {
+			PlwSort_IntroTexts(texts + j + 1, count - j - 1, depth);
+			count = j;
+		}
+	}
+	PlwSort_InsertionTexts(texts, count);
+}
+
+void PlwSort_Texts(PlwRefManager *refMan, PlwRefId *items, PlwInt count, PlwError *error) {
+	PlwSortText *texts;
+	PlwStringRef *ref;
+	PlwInt depth = 0;
+	PlwInt len;
+	PlwInt i;
+	PlwInt k;
+	if (count < 2) {
+		return;
+	}
+	texts = PlwAlloc(count * sizeof(PlwSortText), error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	for (i = 0; i < count; i++) {
+		ref = PlwRefManager_GetRefOfType(refMan, items[i], PlwStringRefTagName, error);
+		if (PlwIsError(error)) {
+			PlwFree(texts);
+			return;
+		}
+		texts[i].ptr = PlwStringRef_Ptr(ref);
+		texts[i].len = PlwStringRef_Len(ref);
+		texts[i].refId = items[i];
+		texts[i].prefix = 0;
+		len = texts[i].len < 8 ? texts[i].len : 8;
+		for (k = 0; k < 8; k++) {
+			texts[i].prefix = (texts[i].prefix << 8) | (k < len ? (unsigned char) texts[i].ptr[k] : 0);
+		}
+	}
+	for (i = count; i > 1; i /= 2) {
+		depth += 2;
+	}
+	PlwSort_IntroTexts(texts, count, depth);
+	for (i = 0; i < count; i++) {
+		items[i] = texts[i].refId;
+	}
+	PlwFree(texts);
+}
+
+void PlwSort_Reverse(PlwInt *items, PlwInt count) {
+	PlwInt i;
+	PlwInt item;
+	for (i = 0; i < count / 2; i++) {
+		item = items[i];
+		items[i] = items[count - 1 - i];
+		items[count - 1 - i] = item;
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef PLWSORT_H_
+#define PLWSORT_H_
+
+#include "PlwRefManager.h"
+
+/*
+ * Sorts of the items of arrays in ascending order. The integers and the reals
+ * are turned into unsigned keys that keep their order and sorted by an LSD
+ * radix sort, a byte per pass, that skips the bytes all the keys share. The
+ * texts are sorted by an introsort on the first 8 chars of each text kept
+ * next to it, the chars after them are compared with memcmp when needed.
+ */
+
+/* below this count the items are sorted by insertion */
+#define PLW_SORT_INSERTION_MAX 16
+
+void PlwSort_Integers(PlwInt *items, PlwInt count, PlwError *error);
+
+/* the items hold the bits of PlwFloat values */
+void PlwSort_Reals(PlwInt *items, PlwInt count, PlwError *error);
+
+/* the items are refs of strings, the counts of the refs move with them */
+void PlwSort_Texts(PlwRefManager *refMan, PlwRefId *items, PlwInt count, PlwError *error);
+
+void PlwSort_Reverse(PlwInt *items, PlwInt count);
+
+#endif
@@ -25,13 +25,6 @@ void PlwStackMachineError_StackAccessOutOfBound(PlwError *error) {
 	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Stack access out of bound");
 }
 
-const char * const PlwStackMachineErrorCodeAccessOutOfBound = "PlwStackMachineErrorCodeAccessOutOfBound";
-
-void PlwStackMachineError_CodeAccessOutOfBound(PlwError *error, char *codeBlockName, PlwInt offset) {
-	error->code = PlwStackMachineErrorCodeAccessOutOfBound;
-	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Offset %ld of block %s out of bound", offset, codeBlockName);
-}
-
 const char * const PlwStackMachineErrorCodeBlockAccessOutOfBound = "PlwStackMachineErrorCodeBlockAccessOutOfBound";
 
 void PlwStackMachineError_CodeBlockAccessOutOfBound(PlwError *error, PlwInt codeBlockId) {
@@ -39,13 +32,6 @@ void PlwStackMachineError_CodeBlockAccessOutOfBound(PlwError *error, PlwInt code
 	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Code block id %ld out of bound", codeBlockId);
 }
 
-const char * const PlwStackMachineErrorNativeAccessOutOfBound = "PlwStackMachineErrorNativeAccessOutOfBound";
-
-void PlwStackMachineError_NativeAccessOutOfBound(PlwError *error, PlwInt nativeId) {
-	error->code = PlwStackMachineErrorNativeAccessOutOfBound;
-	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Native id %ld out of bound", nativeId);
-}
-
 const char * const PlwStackMachineErrorInvalidFuncId = "PlwStackMachineErrorInvalidFuncId";
 
 void PlwStackMachineError_InvalidFuncId(PlwError *error, PlwInt funcId, PlwRefId refId) {
@@ -53,6 +39,13 @@ void PlwStackMachineError_InvalidFuncId(PlwError *error, PlwInt funcId, PlwRefId
 	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Invalid func id %ld in ref id %ld", funcId, refId);
 }
 
+const char * const PlwStackMachineErrorResultCountMismatch = "PlwStackMachineErrorResultCountMismatch";
+
+void PlwStackMachineError_ResultCountMismatch(PlwError *error, PlwInt codeBlockId, PlwInt resultCount) {
+	error->code = PlwStackMachineErrorResultCountMismatch;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Code block id %ld does not return %ld result", codeBlockId, resultCount);
+}
+
 const char * const PlwStackMachineErrorSuspended = "PlwStackMachineErrorSuspended";
 
 void PlwStackMachineError_Suspended(PlwError *error) {
@@ -81,14 +74,6 @@ void PlwStackMachineError_Exception(PlwError *error, PlwInt errorCode) {
 	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Exception %ld", errorCode);
 }
 
-const char * const PlwStackMachineErrorConstAccessOutOfBound = "PlwStackMachineErrorConstAccessOutOfBound";
-
-void StackMachineError_ConstAccessOutOfBound(PlwError *error, PlwInt codeBlockId, PlwInt strId) {
-	error->code = PlwStackMachineErrorConstAccessOutOfBound;
-	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "String constant %ld in code block %ld does not exist", strId, codeBlockId);
-}
-
-
 PlwStackMachine *PlwStackMachine_Create(PlwError *error) {
 	PlwStackMachine *sm;
 	if (sizeof(PlwInt) != sizeof(PlwFloat)) {
@@ -125,10 +110,14 @@ PlwStackMachine *PlwStackMachine_Create(PlwError *error) {
 	sm->codeBlocks = NULL;
 	sm->nativeCount = 0;
 	sm->natives = NULL;
+	sm->jit = NULL;
 	return sm;
 }
 
 void PlwStackMachine_Destroy(PlwStackMachine *sm) {
+	if (sm->jit != NULL) {
+		PlwJit_Destroy(sm->jit);
+	}
 	PlwFree(sm->stackMap);
 	PlwFree(sm->stack);
 	PlwRefManager_Destroy(sm->refMan);
@@ -198,15 +187,11 @@ static void PlwStackMachine_GrowStack(PlwStackMachine *sm, PlwInt addedSize, Plw
 	}
 }
 
+static void PlwStackMachine_OpcodeSuspend(PlwStackMachine *sm, PlwError *error) {
+	PlwStackMachineError_Suspended(error);
+}
+
 static void PlwStackMachine_OpcodeDup(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->sp] = sm->stack[sm->sp - 1];
 	sm->stackMap[sm->sp] = sm->stackMap[sm->sp - 1];
 	if (sm->stackMap[sm->sp]) {
@@ -221,10 +206,6 @@ static void PlwStackMachine_OpcodeDup(PlwStackMachine *sm, PlwError *error) {
 static void PlwStackMachine_OpcodeSwap(PlwStackMachine *sm, PlwError *error) {
 	PlwInt tmp;
 	PlwInt tmpMap;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	tmp = sm->stack[sm->sp - 2];
 	tmpMap = sm->stackMap[sm->sp - 2];
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 1];
@@ -234,20 +215,12 @@ static void PlwStackMachine_OpcodeSwap(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeAdd(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] += sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeAddf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	w1.f += w2.f;
@@ -256,20 +229,12 @@ static void PlwStackMachine_OpcodeAddf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeSub(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] -= sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeSubf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	w1.f -= w2.f;
@@ -278,10 +243,6 @@ static void PlwStackMachine_OpcodeSubf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeDiv(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	if (sm->stack[sm->sp - 1] == 0) {
 		if (!PlwStackMachine_RaiseError(sm, 0, error)) {
 			if (PlwIsError(error)) {
@@ -298,10 +259,6 @@ static void PlwStackMachine_OpcodeDiv(PlwStackMachine *sm, PlwError *error) {
 
 static void PlwStackMachine_OpcodeDivf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	w1.f /= w2.f;
@@ -310,10 +267,6 @@ static void PlwStackMachine_OpcodeDivf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeRem(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	if (sm->stack[sm->sp - 1] == 0) {
 		if (!PlwStackMachine_RaiseError(sm, 0, error)) {
 			if (PlwIsError(error)) {
@@ -329,20 +282,12 @@ static void PlwStackMachine_OpcodeRem(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeMul(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] *= sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeMulf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	w1.f *= w2.f;
@@ -351,39 +296,23 @@ static void PlwStackMachine_OpcodeMulf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeNeg(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 1] = -sm->stack[sm->sp - 1];
 }
 
 static void PlwStackMachine_OpcodeNegf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w;
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w.i = sm->stack[sm->sp - 1];
 	w.f = -w.f;
 	sm->stack[sm->sp - 1] = w.i;
 }
 
 static void PlwStackMachine_OpcodeGt(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] > sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeGtf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f > w2.f;
@@ -391,20 +320,12 @@ static void PlwStackMachine_OpcodeGtf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeLt(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] < sm->stack[sm->sp - 1];
 	sm->sp--;	
 }
 
 static void PlwStackMachine_OpcodeLtf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f < w2.f;
@@ -412,20 +333,12 @@ static void PlwStackMachine_OpcodeLtf(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeGte(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] >= sm->stack[sm->sp - 1];
 	sm->sp--;	
 }
 
 static void PlwStackMachine_OpcodeGtef(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f >= w2.f;
@@ -433,20 +346,12 @@ static void PlwStackMachine_OpcodeGtef(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeLte(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] <= sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeLtef(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f <= w2.f;
@@ -454,46 +359,26 @@ static void PlwStackMachine_OpcodeLtef(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeAnd(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] && sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeOr(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] || sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeNot(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 1] = !sm->stack[sm->sp - 1];	
 }
 
 static void PlwStackMachine_OpcodeEq(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] == sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeEqf(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f == w2.f;
@@ -502,10 +387,6 @@ static void PlwStackMachine_OpcodeEqf(PlwStackMachine *sm, PlwError *error) {
 
 static void PlwStackMachine_OpcodeEqRef(PlwStackMachine *sm, PlwError *error) {
 	PlwBoolean isEqual;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	isEqual = PlwRefManager_CompareRefs(sm->refMan, sm->stack[sm->sp - 2], sm->stack[sm->sp - 1], error);
 	if (PlwIsError(error)) {
 		return;
@@ -523,20 +404,12 @@ static void PlwStackMachine_OpcodeEqRef(PlwStackMachine *sm, PlwError *error) {
 }
 
 static void PlwStackMachine_OpcodeNe(PlwStackMachine *sm, PlwError *error) {
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	sm->stack[sm->sp - 2] = sm->stack[sm->sp - 2] != sm->stack[sm->sp - 1];
 	sm->sp--;
 }
 
 static void PlwStackMachine_OpcodeNef(PlwStackMachine *sm, PlwError *error) {
 	PlwWord w1, w2;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	w1.i = sm->stack[sm->sp - 2];
 	w2.i = sm->stack[sm->sp - 1];
 	sm->stack[sm->sp - 2] = w1.f != w2.f;
@@ -545,12 +418,10 @@ static void PlwStackMachine_OpcodeNef(PlwStackMachine *sm, PlwError *error) {
 
 static void PlwStackMachine_OpcodePushPtrOffset(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
+	PlwBoolean isCounted;
 	PlwInt offset;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	refId = sm->stack[sm->sp - 2];
+	isCounted = sm->stackMap[sm->sp - 2];
 	offset = sm->stack[sm->sp - 1];
 	PlwRefManager_GetOffsetValue(sm->refMan, refId, offset, PlwFalse, error, &sm->offsetValue);
 	if (PlwIsError(error)) {
@@ -565,16 +436,15 @@ static void PlwStackMachine_OpcodePushPtrOffset(PlwStackMachine *sm, PlwError *e
 		}
 	}
 	sm->sp--;
-	PlwRefManager_DecRefCount(sm->refMan, refId, error);
+	/* a borrowed ref was pushed without a count */
+	if (isCounted) {
+		PlwRefManager_DecRefCount(sm->refMan, refId, error);
+	}
 }
 
 static void PlwStackMachine_OpcodePushPtrOffsetForMutate(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId refId;
 	PlwInt offset;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	refId = sm->stack[sm->sp - 2];
 	offset = sm->stack[sm->sp - 1];
 	PlwRefManager_GetOffsetValue(sm->refMan, refId, offset, PlwTrue, error, &sm->offsetValue);
@@ -597,10 +467,6 @@ static void PlwStackMachine_OpcodePopPtrOffset(PlwStackMachine *sm, PlwError *er
 	PlwRefId refId;
 	PlwInt offset;
 	PlwInt val;
-	if (sm->sp < 3) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}				
 	refId = sm->stack[sm->sp - 3];
 	offset = sm->stack[sm->sp - 2];
 	val = sm->stack[sm->sp - 1];
@@ -614,10 +480,6 @@ static void PlwStackMachine_OpcodePopPtrOffset(PlwStackMachine *sm, PlwError *er
 
 static void PlwStackMachine_OpcodeRaise(PlwStackMachine *sm, PlwError *error) {
 	PlwInt errorCode;
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	errorCode = sm->stack[sm->sp - 1];
 	if(!PlwStackMachine_RaiseError(sm,  errorCode, error)) {
 		if (PlwIsError(error)) {
@@ -794,10 +656,6 @@ static void PlwStackMachine_OpcodeNext(PlwStackMachine *sm, PlwError *error) {
 	PlwInt *refPtr;
 	PlwBoolean *refMapPtr;
 	PlwInt i;
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	refId = sm->stack[sm->sp - 1];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwMappedRecordRefTagName, error);
 	if (PlwIsError(error)) {
@@ -806,7 +664,7 @@ static void PlwStackMachine_OpcodeNext(PlwStackMachine *sm, PlwError *error) {
 	refSize = PlwMappedRecordRef_Size(ref);
 	refPtr = PlwMappedRecordRef_Ptr(ref);
 	refMapPtr = PlwMappedRecordRef_MapPtr(ref);
-	PlwStackMachine_GrowStack(sm, 1 + refSize, error);
+	PlwStackMachine_GrowStack(sm, 1 + refSize + sm->codeBlocks[refPtr[0]].maxStackDepth, error);
 	if (PlwIsError(error)) {
 		return;
 	}
@@ -836,10 +694,6 @@ static void PlwStackMachine_OpcodeEnded(PlwStackMachine *sm, PlwError *error) {
 	PlwInt *refPtr;
 	PlwBoolean ended;
 	const PlwCodeBlock *codeBlock;
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	refId = sm->stack[sm->sp - 1];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwMappedRecordRefTagName, error);
 	if (PlwIsError(error)) {
@@ -847,7 +701,7 @@ static void PlwStackMachine_OpcodeEnded(PlwStackMachine *sm, PlwError *error) {
 	}
 	refPtr = PlwMappedRecordRef_Ptr(ref);
 	codeBlock = &sm->codeBlocks[refPtr[0]];
-	ended = refPtr[1] >= codeBlock->codeCount;
+	ended = refPtr[1] >= codeBlock->instructionCount;
 	PlwRefManager_DecRefCount(sm->refMan, sm->stack[sm->sp - 1], error);
 	if (PlwIsError(error)) {
 		return;
@@ -855,65 +709,60 @@ static void PlwStackMachine_OpcodeEnded(PlwStackMachine *sm, PlwError *error) {
 	sm->stack[sm->sp - 1] = ended;
 }
 
-static void PlwStackMachine_OpcodeBasicArrayTimes(PlwStackMachine *sm, PlwError *error) {
+static void PlwStackMachine_BasicArrayTimes(PlwStackMachine *sm, PlwInt itemSize, PlwError *error) {
 	PlwInt val;
 	PlwInt count;
 	PlwInt *ptr;
 	PlwInt i;
 	PlwRefId refId;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	val = sm->stack[sm->sp - 2];
 	count = sm->stack[sm->sp - 1];
 	if (count < 0) {
 		count = 0;
 	}
-	ptr = PlwAlloc(count * sizeof(PlwInt), error);
+	refId = PlwBasicArrayRef_MakeInline(sm->refMan, count, itemSize, &ptr, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	for (i = 0; i < count; i++) {
-		ptr[i] = val;
-	}
-	refId = PlwBasicArrayRef_Make(sm->refMan, count, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
+	if (itemSize == 1) {
+		memset(ptr, (char) val, count);
+	} else {
+		for (i = 0; i < count; i++) {
+			ptr[i] = val;
+		}
 	}
 	sm->stack[sm->sp - 2] = refId;
 	sm->stackMap[sm->sp - 2] = PlwTrue;
 	sm->sp--;
 }
 
+static void PlwStackMachine_OpcodeBasicArrayTimes(PlwStackMachine *sm, PlwError *error) {
+	PlwStackMachine_BasicArrayTimes(sm, sizeof(PlwInt), error);
+}
+
+/* the items of a []boolean or a []char take a byte each */
+static void PlwStackMachine_OpcodeByteArrayTimes(PlwStackMachine *sm, PlwError *error) {
+	PlwStackMachine_BasicArrayTimes(sm, 1, error);
+}
+
 static void PlwStackMachine_OpcodeArrayTimes(PlwStackMachine *sm, PlwError *error) {
 	PlwRefId val;
 	PlwInt count;
 	PlwRefId *ptr;
 	PlwInt i;
 	PlwRefId refId;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	val = sm->stack[sm->sp - 2];
 	count = sm->stack[sm->sp - 1];
 	if (count < 0) {
 		count = 0;
 	}
-	ptr = PlwAlloc(count * sizeof(PlwRefId), error);
+	refId = PlwArrayRef_MakeInline(sm->refMan, count, &ptr, error);
 	if (PlwIsError(error)) {
 		return;
 	}
 	for (i = 0; i < count; i++) {
 		ptr[i] = val;
 	}
-	refId = PlwArrayRef_Make(sm->refMan, count, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}	
 	if (count == 0) {
 		PlwRefManager_DecRefCount(sm->refMan, val, error);
 	} else {
@@ -928,10 +777,6 @@ static void PlwStackMachine_OpcodeArrayTimes(PlwStackMachine *sm, PlwError *erro
 }
 
 static void PlwStackMachine_OpcodeJz(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	if (sm->stack[sm->sp - 1] == 0) {
 		sm->ip = arg1;
 	}
@@ -939,10 +784,6 @@ static void PlwStackMachine_OpcodeJz(PlwStackMachine *sm, PlwInt arg1, PlwError
 }
 
 static void PlwStackMachine_OpcodeJnz(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	if (sm->stack[sm->sp - 1] != 0) {
 		sm->ip = arg1;
 	}
@@ -954,10 +795,6 @@ static void PlwStackMachine_OpcodeJmp(PlwStackMachine *sm, PlwInt arg1, PlwError
 }
 
 static void PlwStackMachine_OpcodePush(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->sp] = arg1;
 	sm->stackMap[sm->sp] = PlwFalse;
 	sm->sp++;
@@ -968,10 +805,6 @@ static void PlwStackMachine_OpcodePushGlobal(PlwStackMachine *sm, PlwInt offset,
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->sp] = sm->stack[offset];
 	sm->stackMap[sm->sp] = sm->stackMap[offset];
 	if (sm->stackMap[sm->sp]) {
@@ -988,10 +821,6 @@ static void PlwStackMachine_OpcodePushGlobalForMutate(PlwStackMachine *sm, PlwIn
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[offset] = PlwRefManager_MakeMutable(sm->refMan, sm->stack[offset], error);
 	if (PlwIsError(error)) {
 		return;
@@ -1013,10 +842,6 @@ static void PlwStackMachine_OpcodePushLocal(PlwStackMachine *sm, PlwInt offset,
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->sp] = sm->stack[sm->bp + offset];
 	sm->stackMap[sm->sp] = sm->stackMap[sm->bp + offset];
 	if (sm->stackMap[sm->sp]) {
@@ -1033,10 +858,6 @@ static void PlwStackMachine_OpcodePushLocalForMutate(PlwStackMachine *sm, PlwInt
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->bp + offset] = PlwRefManager_MakeMutable(sm->refMan, sm->stack[sm->bp + offset], error);
 	if (PlwIsError(error)) {
 		return;
@@ -1053,11 +874,53 @@ static void PlwStackMachine_OpcodePushLocalForMutate(PlwStackMachine *sm, PlwInt
 	sm->sp++;
 }
 
-static void PlwStackMachine_OpcodePushIndirection(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
+/* the last read of a slot, its ref goes to the stack without a count and the slot is cleared */
+static void PlwStackMachine_OpcodePushGlobalMove(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
+	if (offset < 0 || offset >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
+	sm->stack[sm->sp] = sm->stack[offset];
+	sm->stackMap[sm->sp] = sm->stackMap[offset];
+	sm->stack[offset] = 0;
+	sm->stackMap[offset] = PlwFalse;
+	sm->sp++;
+}
+
+static void PlwStackMachine_OpcodePushLocalMove(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
+	if (sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	sm->stack[sm->sp] = sm->stack[sm->bp + offset];
+	sm->stackMap[sm->sp] = sm->stackMap[sm->bp + offset];
+	sm->stack[sm->bp + offset] = 0;
+	sm->stackMap[sm->bp + offset] = PlwFalse;
+	sm->sp++;
+}
+
+/* a read consumed by the next offset read, the ref stays counted by its slot and goes to the stack as a plain cell */
+static void PlwStackMachine_OpcodePushGlobalBorrow(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
+	if (offset < 0 || offset >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	sm->stack[sm->sp] = sm->stack[offset];
+	sm->stackMap[sm->sp] = PlwFalse;
+	sm->sp++;
+}
+
+static void PlwStackMachine_OpcodePushLocalBorrow(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
+	if (sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	sm->stack[sm->sp] = sm->stack[sm->bp + offset];
+	sm->stackMap[sm->sp] = PlwFalse;
+	sm->sp++;
+}
+
+static void PlwStackMachine_OpcodePushIndirection(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
 	sm->stack[sm->sp] = sm->bp + offset;
 	sm->stackMap[sm->sp] = PlwFalse;
 	sm->sp++;
@@ -1069,10 +932,6 @@ static void PlwStackMachine_OpcodePushIndirect(PlwStackMachine *sm, PlwInt offse
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	directOffset = sm->stack[sm->bp + offset];
 	if (directOffset < 0 || directOffset >= sm->sp) {
 		PlwStackMachineError_StackAccessOutOfBound(error);
@@ -1095,10 +954,6 @@ static void PlwStackMachine_OpcodePushIndirectForMutate(PlwStackMachine *sm, Plw
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	directOffset = sm->stack[sm->bp + offset];
 	if (directOffset < 0 || directOffset >= sm->sp) {
 		PlwStackMachineError_StackAccessOutOfBound(error);
@@ -1122,7 +977,7 @@ static void PlwStackMachine_OpcodePushIndirectForMutate(PlwStackMachine *sm, Plw
 }
 
 static void PlwStackMachine_OpcodePopGlobal(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
-	if (sm->sp < 1 || offset < 0 || offset >= sm->sp) {
+	if (offset < 0 || offset >= sm->sp) {
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
@@ -1138,7 +993,7 @@ static void PlwStackMachine_OpcodePopGlobal(PlwStackMachine *sm, PlwInt offset,
 }
 
 static void PlwStackMachine_OpcodePopLocal(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
-	if (sm->sp < 1 || sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
+	if (sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
@@ -1155,7 +1010,7 @@ static void PlwStackMachine_OpcodePopLocal(PlwStackMachine *sm, PlwInt offset, P
 
 static void PlwStackMachine_OpcodePopIndirect(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
 	PlwInt directOffset;
-	if (sm->sp < 1 || sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
+	if (sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
 		PlwStackMachineError_StackAccessOutOfBound(error);
 		return;
 	}
@@ -1178,10 +1033,6 @@ static void PlwStackMachine_OpcodePopIndirect(PlwStackMachine *sm, PlwInt offset
 
 static void PlwStackMachine_OpcodePopVoid(PlwStackMachine *sm, PlwInt cellCount, PlwError *error) {
 	PlwInt i;
-	if (cellCount < 0 || cellCount > sm->sp) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;
-	}
 	for (i = sm->sp - 1; i >= sm->sp - cellCount; i--) {
 		if (sm->stackMap[i]) {
 			PlwRefManager_DecRefCount(sm->refMan, sm->stack[i], error);
@@ -1195,24 +1046,14 @@ static void PlwStackMachine_OpcodePopVoid(PlwStackMachine *sm, PlwInt cellCount,
 
 static void PlwStackMachine_OpcodeCreateString(PlwStackMachine *sm, PlwInt strId, PlwError *error) {
 	const PlwCodeBlock *codeBlock = &sm->codeBlocks[sm->codeBlockId];
+	const char *strConst = codeBlock->strConsts[strId];
+	PlwInt len = strlen(strConst);
 	char *ptr;
-	if (strId < 0 || strId >= codeBlock->strConstCount) {
-		StackMachineError_ConstAccessOutOfBound(error, sm->codeBlockId, strId);
-		return;				
-	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
-	ptr = PlwStrDup(codeBlock->strConsts[strId], error);
-	if (PlwIsError(error)) {
-		return;
-	}
-	sm->stack[sm->sp] = PlwStringRef_Make(sm->refMan, ptr, error);
+	sm->stack[sm->sp] = PlwStringRef_MakeInline(sm->refMan, len, &ptr, error);
 	if (PlwIsError(error)) {
-		PlwFree(ptr);
 		return;
 	}
+	memcpy(ptr, strConst, len);
 	sm->stackMap[sm->sp] = PlwTrue;
 	sm->sp++;	
 }
@@ -1222,15 +1063,22 @@ static void PlwStackMachine_OpcodeCreateRecord(PlwStackMachine *sm, PlwInt cellC
 	PlwInt offset;
 	PlwInt i;
 	PlwInt refSize;
+	PlwInt site;
+	PlwInt layoutId;
 	PlwRefId refId;
-	if (cellCount < 0 || cellCount > sm->sp) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
+	refSize = 0;
+	for (i = 0; i < cellCount; i++) {
+		if (sm->stackMap[sm->sp - cellCount + i]) {
+			refSize++;
+		}
 	}
-	ptr = PlwAlloc(cellCount * sizeof(PlwInt), error);
+	/* ip is past the instruction, whose arg2 tells the sites of constant cells, unique over the code blocks once mixed with their id */
+	site = sm->codeBlocks[sm->codeBlockId].instructions[sm->ip - 1].arg2;
+	layoutId = site == 0 ? 0 : sm->codeBlockId + site * sm->codeBlockCount;
+	refId = PlwRecordRef_MakeInline(sm->refMan, refSize, cellCount, layoutId, &ptr, error);
 	if (PlwIsError(error)) {
 		return;
-	}	
+	}
 	offset = 0;
 	for (i = 0; i < cellCount; i++) {
 		if (sm->stackMap[sm->sp - cellCount + i]) {
@@ -1238,7 +1086,6 @@ static void PlwStackMachine_OpcodeCreateRecord(PlwStackMachine *sm, PlwInt cellC
 			offset++;
 		}
 	}
-	refSize = offset;
 	if (refSize != cellCount) {
 		for (i = 0; i < cellCount; i++) {
 			if (!sm->stackMap[sm->sp - cellCount + i]) {
@@ -1247,11 +1094,6 @@ static void PlwStackMachine_OpcodeCreateRecord(PlwStackMachine *sm, PlwInt cellC
 			}
 		}
 	}
-	refId = PlwRecordRef_Make(sm->refMan, refSize, cellCount, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}	
 	sm->sp = sm->sp - cellCount + 1;
 	sm->stack[sm->sp - 1] = refId; 
 	sm->stackMap[sm->sp - 1] = PlwTrue;
@@ -1260,20 +1102,27 @@ static void PlwStackMachine_OpcodeCreateRecord(PlwStackMachine *sm, PlwInt cellC
 static void PlwStackMachine_OpcodeCreateBasicArray(PlwStackMachine *sm, PlwInt cellCount, PlwError *error) {
 	PlwInt *ptr;
 	PlwRefId refId;
-	if (cellCount < 0 || cellCount > sm->sp) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
-	ptr = PlwAlloc(cellCount * sizeof(PlwInt), error);
+	refId = PlwBasicArrayRef_MakeInline(sm->refMan, cellCount, sizeof(PlwInt), &ptr, error);
 	if (PlwIsError(error)) {
 		return;
 	}
 	memcpy(ptr, sm->stack + sm->sp - cellCount, cellCount * sizeof(PlwInt));
-	refId = PlwBasicArrayRef_Make(sm->refMan, cellCount, ptr, error);
+	sm->sp = sm->sp - cellCount + 1;
+	sm->stack[sm->sp - 1] = refId; 
+	sm->stackMap[sm->sp - 1] = PlwTrue;
+}
+
+static void PlwStackMachine_OpcodeCreateByteArray(PlwStackMachine *sm, PlwInt cellCount, PlwError *error) {
+	PlwInt *ptr;
+	PlwRefId refId;
+	PlwInt i;
+	refId = PlwBasicArrayRef_MakeInline(sm->refMan, cellCount, 1, &ptr, error);
 	if (PlwIsError(error)) {
-		PlwFree(ptr);
 		return;
 	}
+	for (i = 0; i < cellCount; i++) {
+		((char *) ptr)[i] = sm->stack[sm->sp - cellCount + i];
+	}
 	sm->sp = sm->sp - cellCount + 1;
 	sm->stack[sm->sp - 1] = refId; 
 	sm->stackMap[sm->sp - 1] = PlwTrue;
@@ -1282,31 +1131,18 @@ static void PlwStackMachine_OpcodeCreateBasicArray(PlwStackMachine *sm, PlwInt c
 static void PlwStackMachine_OpcodeCreateArray(PlwStackMachine *sm, PlwInt cellCount, PlwError *error) {
 	PlwInt *ptr;
 	PlwRefId refId;
-	if (cellCount < 0 || cellCount > sm->sp) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
-	ptr = PlwAlloc(cellCount * sizeof(PlwInt), error);
+	refId = PlwArrayRef_MakeInline(sm->refMan, cellCount, &ptr, error);
 	if (PlwIsError(error)) {
 		return;
 	}
 	memcpy(ptr, sm->stack + sm->sp - cellCount, cellCount * sizeof(PlwInt));
-	refId = PlwArrayRef_Make(sm->refMan, cellCount, ptr, error);
-	if (PlwIsError(error)) {
-		PlwFree(ptr);
-		return;
-	}
 	sm->sp = sm->sp - cellCount + 1;
 	sm->stack[sm->sp - 1] = refId; 
 	sm->stackMap[sm->sp - 1] = PlwTrue;
 }
 
 static void PlwStackMachine_OpcodeCall(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
-	if (arg1 < 0 || arg1 > sm->codeBlockCount) {
-		PlwStackMachineError_CodeBlockAccessOutOfBound(error, arg1);
-		return;
-	}
-	PlwStackMachine_GrowStack(sm, 3, error);
+	PlwStackMachine_GrowStack(sm, 3 + sm->codeBlocks[arg1].maxStackDepth, error);
 	if (PlwIsError(error)) {
 		return;
 	}
@@ -1321,35 +1157,114 @@ static void PlwStackMachine_OpcodeCall(PlwStackMachine *sm, PlwInt arg1, PlwErro
 	sm->sp++;
 	sm->bp = sm->sp;
 	sm->codeBlockId = arg1;
-	sm->ip = 0;	
+	sm->ip = 0;
+	if (sm->jit != NULL) {
+		PlwJit_CountCall(sm->jit, sm->codeBlocks, arg1, error);
+	}
 }
 
-static void PlwStackMachine_OpcodeCallAbstract(PlwStackMachine *sm, PlwInt funcId, PlwError *error) {
+/* replaces the current frame by the frame of the callee, which returns directly to the caller */
+static void PlwStackMachine_OpcodeTailCall(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
+	PlwInt previousBp;
+	PlwInt previousIp;
+	PlwInt previousCodeBlockId;
+	PlwInt argCount;
+	PlwInt newArgCount;
+	PlwInt dest;
+	PlwInt i;
+	if (sm->bp < 4 || sm->bp > sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	previousBp = sm->stack[sm->bp - 1];
+	previousIp = sm->stack[sm->bp - 2];
+	previousCodeBlockId = sm->stack[sm->bp - 3];
+	argCount = sm->stack[sm->bp - 4];
+	newArgCount = sm->stack[sm->sp - 1];
+	if (sm->bp < 4 + argCount || sm->sp - 1 - newArgCount < sm->bp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	for (i = sm->sp - newArgCount - 2; i >= sm->bp - 4 - argCount; i--) {
+		if (sm->stackMap[i]) {
+			PlwRefManager_DecRefCount(sm->refMan, sm->stack[i], error);
+			if (PlwIsError(error)) {
+				return;
+			}
+		}
+	}
+	dest = sm->bp - 4 - argCount;
+	for (i = 0; i <= newArgCount; i++) {
+		sm->stack[dest + i] = sm->stack[sm->sp - newArgCount - 1 + i];
+		sm->stackMap[dest + i] = sm->stackMap[sm->sp - newArgCount - 1 + i];
+	}
+	sm->sp = dest + newArgCount + 1;
+	sm->bp = previousBp;
+	sm->codeBlockId = previousCodeBlockId;
+	sm->ip = previousIp;
+	PlwStackMachine_OpcodeCall(sm, arg1, error);
+}
+
+static PlwInt PlwStackMachine_FindAbstract(PlwStackMachine *sm, PlwRefId refId, PlwRecordRef *ref, PlwInt funcId, PlwInt resultCount, PlwError *error) {
+	PlwInt codeBlockId;
+	if (funcId < 0 || (1 + 2 * funcId) >= PlwRecordRef_TotalSize(ref)) {
+		PlwStackMachineError_InvalidFuncId(error, funcId, refId);
+		return -1;
+	}
+	codeBlockId =  PlwRecordRef_Ptr(ref)[1 + 2 * funcId];
+	if (codeBlockId < 0 || codeBlockId >= sm->codeBlockCount) {
+		PlwStackMachineError_CodeBlockAccessOutOfBound(error, codeBlockId);
+		return -1;
+	}
+	/* the verifier trusted the call site for the stack depth after the call */
+	if (sm->codeBlocks[codeBlockId].resultCount != resultCount && sm->codeBlocks[codeBlockId].resultCount != -1) {
+		PlwStackMachineError_ResultCountMismatch(error, codeBlockId, resultCount);
+		return -1;
+	}
+	return codeBlockId;
+}
+
+static void PlwStackMachine_CallAbstract(PlwStackMachine *sm, PlwInt funcId, PlwInt resultCount, PlwError *error) {
 	PlwRefId refId;
 	PlwRecordRef *ref;
+	PlwInt layoutId;
+	const PlwCodeBlock *codeBlock;
+	PlwCallCache *cache;
 	PlwInt codeBlockId;
 	PlwBoolean concreteIsRef;
 	PlwInt concreteVal;
-	if (sm->sp < 2) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
-	PlwStackMachine_GrowStack(sm, 3, error);
-	if (PlwIsError(error)) {
-		return;
-	}
+	PlwInt i;
 	refId = sm->stack[sm->sp - 2];
 	ref = PlwRefManager_GetRefOfType(sm->refMan, refId, PlwRecordRefTagName, error);
 	if (PlwIsError(error)) {
 		return;
 	}
-	if (funcId < 0 || (1 + 2 * funcId) >= PlwRecordRef_TotalSize(ref)) {
-		PlwStackMachineError_InvalidFuncId(error, funcId, refId);
-		return;
+	layoutId = PlwRecordRef_LayoutId(ref);
+	/* ip is past the call site, whose arg2 is the index of its cache */
+	codeBlock = &sm->codeBlocks[sm->codeBlockId];
+	cache = &codeBlock->callCaches[codeBlock->instructions[sm->ip - 1].arg2];
+	codeBlockId = -1;
+	if (layoutId != 0) {
+		for (i = 0; i < cache->count; i++) {
+			if (cache->layoutIds[i] == layoutId) {
+				codeBlockId = cache->codeBlockIds[i];
+				break;
+			}
+		}
 	}
-	codeBlockId =  PlwRecordRef_Ptr(ref)[1 + 2 * funcId];
-	if (codeBlockId < 0 || codeBlockId > sm->codeBlockCount) {
-		PlwStackMachineError_CodeBlockAccessOutOfBound(error, codeBlockId);
+	if (codeBlockId == -1) {
+		codeBlockId = PlwStackMachine_FindAbstract(sm, refId, ref, funcId, resultCount, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		if (layoutId != 0 && cache->count < PLW_CALL_CACHE_SIZE) {
+			cache->layoutIds[cache->count] = layoutId;
+			cache->codeBlockIds[cache->count] = codeBlockId;
+			cache->count++;
+		}
+	}
+	PlwStackMachine_GrowStack(sm, 3 + sm->codeBlocks[codeBlockId].maxStackDepth, error);
+	if (PlwIsError(error)) {
 		return;
 	}
 	concreteVal = PlwRecordRef_Ptr(ref)[0];
@@ -1379,21 +1294,20 @@ static void PlwStackMachine_OpcodeCallAbstract(PlwStackMachine *sm, PlwInt funcI
 	sm->bp = sm->sp;
 	sm->codeBlockId = codeBlockId;
 	sm->ip = 0;
+	if (sm->jit != NULL) {
+		PlwJit_CountCall(sm->jit, sm->codeBlocks, codeBlockId, error);
+	}
+}
+
+static void PlwStackMachine_OpcodeCallAbstract(PlwStackMachine *sm, PlwInt funcId, PlwError *error) {
+	PlwStackMachine_CallAbstract(sm, funcId, 1, error);
+}
+
+static void PlwStackMachine_OpcodeCallAbstractProc(PlwStackMachine *sm, PlwInt funcId, PlwError *error) {
+	PlwStackMachine_CallAbstract(sm, funcId, 0, error);
 }
 
 static void PlwStackMachine_OpcodeCallNative(PlwStackMachine *sm, PlwInt nativeId, PlwError *error) {
-	if (nativeId < 0 || nativeId >= sm->nativeCount) {
-		PlwStackMachineError_NativeAccessOutOfBound(error, nativeId);
-		return;
-	}
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
-	if (sm->sp < sm->stack[sm->sp - 1]) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
 	((PlwNativeFunction)(sm->natives[nativeId]))(sm, error);
 }
 
@@ -1403,19 +1317,7 @@ static void PlwStackMachine_OpcodeInitGenerator(PlwStackMachine *sm, PlwInt code
 	PlwBoolean *mapPtr;
 	PlwInt i;
 	PlwRefId refId;
-	if (sm->sp < 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}
-	if (codeBlockId < 0 || codeBlockId > sm->codeBlockCount) {
-		PlwStackMachineError_CodeBlockAccessOutOfBound(error, codeBlockId);
-		return;
-	}
 	nbParam = sm->stack[sm->sp - 1];
-	if (nbParam < 0 || sm->sp < nbParam + 1) {
-		PlwStackMachineError_StackAccessOutOfBound(error);
-		return;				
-	}					
 	ptr = PlwAlloc((nbParam + 2) * sizeof(PlwInt), error);
 	if (PlwIsError(error)) {
 		return;
@@ -1445,10 +1347,6 @@ static void PlwStackMachine_OpcodeInitGenerator(PlwStackMachine *sm, PlwInt code
 }
 
 static void PlwStackMachine_OpcodeCreateExceptionHandler(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	sm->stack[sm->sp] = PlwExceptionHandlerRef_Make(sm->refMan, sm->codeBlockId, arg1, sm->bp, error);
 	if (PlwIsError(error)) {
 		return;
@@ -1460,20 +1358,463 @@ static void PlwStackMachine_OpcodeCreateExceptionHandler(PlwStackMachine *sm, Pl
 static void PlwStackMachine_OpcodePushf(PlwStackMachine *sm, PlwInt floatId, PlwError *error) {
 	PlwWord w;
 	const PlwCodeBlock *codeBlock = &sm->codeBlocks[sm->codeBlockId];
-	if (floatId < 0 || floatId >= codeBlock->floatConstCount) {
-		StackMachineError_ConstAccessOutOfBound(error, sm->codeBlockId, floatId);
-		return;				
-	}
-	PlwStackMachine_GrowStack(sm, 1, error);
-	if (PlwIsError(error)) {
-		return;
-	}
 	w.f = codeBlock->floatConsts[floatId];
 	sm->stack[sm->sp] = w.i;
 	sm->stackMap[sm->sp] = PlwFalse;
 	sm->sp++;	
 }
 
+static void PlwStackMachine_OpcodePushPtrOffsetConst(PlwStackMachine *sm, PlwInt offset, PlwError *error) {
+	PlwRefId refId;
+	PlwBoolean isCounted;
+	refId = sm->stack[sm->sp - 1];
+	isCounted = sm->stackMap[sm->sp - 1];
+	PlwRefManager_GetOffsetValue(sm->refMan, refId, offset, PlwFalse, error, &sm->offsetValue);
+	if (PlwIsError(error)) {
+		return;
+	}
+	sm->stack[sm->sp - 1] = sm->offsetValue.value;
+	sm->stackMap[sm->sp - 1] = sm->offsetValue.isRef;
+	if (sm->offsetValue.isRef) {
+		PlwRefManager_IncRefCount(sm->refMan, sm->stack[sm->sp - 1], error);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+	if (isCounted) {
+		PlwRefManager_DecRefCount(sm->refMan, refId, error);
+	}
+}
+
+static void PlwStackMachine_OpcodeAddConst(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
+	sm->stack[sm->sp - 1] += arg1;
+}
+
+static void PlwStackMachine_OpcodeEqConst(PlwStackMachine *sm, PlwInt arg1, PlwError *error) {
+	sm->stack[sm->sp - 1] = sm->stack[sm->sp - 1] == arg1;
+}
+
+static void PlwStackMachine_OpcodePushLocalPushLocal(PlwStackMachine *sm, PlwInt offset1, PlwInt offset2, PlwError *error) {
+	PlwStackMachine_OpcodePushLocal(sm, offset1, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	PlwStackMachine_OpcodePushLocal(sm, offset2, error);
+}
+
+static void PlwStackMachine_OpcodePushGlobalPushGlobal(PlwStackMachine *sm, PlwInt offset1, PlwInt offset2, PlwError *error) {
+	PlwStackMachine_OpcodePushGlobal(sm, offset1, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	PlwStackMachine_OpcodePushGlobal(sm, offset2, error);
+}
+
+static void PlwStackMachine_OpcodeIncLocal(PlwStackMachine *sm, PlwInt offset, PlwInt arg2, PlwError *error) {
+	if (sm->bp + offset < 0 || sm->bp + offset >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	sm->stack[sm->bp + offset] += arg2;
+}
+
+static void PlwStackMachine_OpcodeJgtLocalLocal(PlwStackMachine *sm, PlwInt offset1, PlwInt offset2, PlwInt arg3, PlwError *error) {
+	if (sm->bp + offset1 < 0 || sm->bp + offset1 >= sm->sp || sm->bp + offset2 < 0 || sm->bp + offset2 >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	if (sm->stack[sm->bp + offset1] > sm->stack[sm->bp + offset2]) {
+		sm->ip = arg3;
+	}
+}
+
+static void PlwStackMachine_OpcodeJltLocalLocal(PlwStackMachine *sm, PlwInt offset1, PlwInt offset2, PlwInt arg3, PlwError *error) {
+	if (sm->bp + offset1 < 0 || sm->bp + offset1 >= sm->sp || sm->bp + offset2 < 0 || sm->bp + offset2 >= sm->sp) {
+		PlwStackMachineError_StackAccessOutOfBound(error);
+		return;
+	}
+	if (sm->stack[sm->bp + offset1] < sm->stack[sm->bp + offset2]) {
+		sm->ip = arg3;
+	}
+}
+
+/* handlers called back by jitted code and by plw2c output, indexed by opcode */
+const PlwJitOpcode PlwStackMachine_OpcodeHandlers[PLW_OPCODE_MAX + 1] = {
+	{NULL, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeSuspend, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeDup, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeSwap, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeAdd, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeAddf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeSub, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeSubf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeDiv, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeDivf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeRem, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeMul, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeMulf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNeg, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNegf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeGt, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeGtf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeLt, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeLtf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeGte, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeGtef, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeLte, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeLtef, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeAnd, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeOr, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNot, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeEq, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeEqf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeEqRef, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNe, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNef, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushPtrOffset, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushPtrOffsetForMutate, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePopPtrOffset, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeRaise, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeRetVal, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeRet, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeYield, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeYieldDone, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeNext, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeEnded, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeBasicArrayTimes, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeArrayTimes, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeByteArrayTimes, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeJz, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeJnz, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeJmp, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePush, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushGlobal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushGlobalForMutate, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushLocal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushLocalForMutate, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushIndirection, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushIndirect, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushIndirectForMutate, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePopGlobal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePopLocal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePopIndirect, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePopVoid, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateString, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateRecord, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateBasicArray, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateArray, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCall, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCallAbstract, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCallNative, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeInitGenerator, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateExceptionHandler, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushf, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushPtrOffsetConst, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeAddConst, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeEqConst, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCallAbstractProc, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodeTailCall, PlwTrue},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushGlobalMove, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushLocalMove, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushGlobalBorrow, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushLocalBorrow, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeCreateByteArray, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushLocalPushLocal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodePushGlobalPushGlobal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeIncLocal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeJgtLocalLocal, PlwFalse},
+	{(PlwJitHandler) PlwStackMachine_OpcodeJltLocalLocal, PlwFalse}
+};
+
+void PlwStackMachine_EnableJit(PlwStackMachine *sm, PlwError *error) {
+	sm->jit = PlwJit_Create(sm->codeBlockCount, PlwStackMachine_OpcodeHandlers, error);
+}
+
+#if defined(PLW_THREADED_DISPATCH) && defined(__GNUC__)
+
+/*
+ * Threaded dispatch: every handler ends with its own indirect jump to the next
+ * handler instead of going back through a shared switch. Labels as values are
+ * a GNU extension, hence the __extension__ markers to keep -pedantic quiet.
+ */
+
+#define PLW_LABEL(label) __extension__ &&label
+
+#define PLW_GOTO(target) __extension__ ({ goto *(target); })
+
+#define PLW_LOAD_CODE_BLOCK \
+	instructions = sm->codeBlocks[sm->codeBlockId].instructions
+
+#define PLW_DISPATCH \
+	instruction = &instructions[sm->ip]; \
+	sm->ip++; \
+	PLW_GOTO(dispatchTable[instruction->opcode])
+
+#ifdef PLW_DEBUG_SM
+#define PLW_TRACE1 \
+	printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode])
+#define PLW_TRACE2 \
+	printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1)
+#define PLW_TRACE3 \
+	printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1, instruction->arg2)
+#define PLW_TRACE4 \
+	printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld %ld %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1, instruction->arg2, instruction->arg3)
+#else
+#define PLW_TRACE1
+#define PLW_TRACE2
+#define PLW_TRACE3
+#define PLW_TRACE4
+#endif
+
+/* handler that stays in the current code block */
+#define PLW_OP1(label, handler) \
+	label: \
+		PLW_TRACE1; \
+		handler(sm, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		PLW_DISPATCH;
+
+/* handler that may switch to another code block, that may have native code */
+#define PLW_OP1_TRANSFER(label, handler) \
+	label: \
+		PLW_TRACE1; \
+		handler(sm, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		goto transfer;
+
+#define PLW_OP2(label, handler) \
+	label: \
+		PLW_TRACE2; \
+		handler(sm, instruction->arg1, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		PLW_DISPATCH;
+
+#define PLW_OP2_TRANSFER(label, handler) \
+	label: \
+		PLW_TRACE2; \
+		handler(sm, instruction->arg1, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		goto transfer;
+
+#define PLW_OP3(label, handler) \
+	label: \
+		PLW_TRACE3; \
+		handler(sm, instruction->arg1, instruction->arg2, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		PLW_DISPATCH;
+
+#define PLW_OP4(label, handler) \
+	label: \
+		PLW_TRACE4; \
+		handler(sm, instruction->arg1, instruction->arg2, instruction->arg3, error); \
+		if (PlwIsError(error)) { \
+			return; \
+		} \
+		PLW_DISPATCH;
+
+static void PlwStackMachine_RunLoop(PlwStackMachine *sm, PlwError *error) {
+	static void * const dispatchTable[PLW_OPCODE_MAX + 1] = {
+		PLW_LABEL(opEndOfBlock),
+		PLW_LABEL(opSuspend),
+		PLW_LABEL(opDup),
+		PLW_LABEL(opSwap),
+		PLW_LABEL(opAdd),
+		PLW_LABEL(opAddf),
+		PLW_LABEL(opSub),
+		PLW_LABEL(opSubf),
+		PLW_LABEL(opDiv),
+		PLW_LABEL(opDivf),
+		PLW_LABEL(opRem),
+		PLW_LABEL(opMul),
+		PLW_LABEL(opMulf),
+		PLW_LABEL(opNeg),
+		PLW_LABEL(opNegf),
+		PLW_LABEL(opGt),
+		PLW_LABEL(opGtf),
+		PLW_LABEL(opLt),
+		PLW_LABEL(opLtf),
+		PLW_LABEL(opGte),
+		PLW_LABEL(opGtef),
+		PLW_LABEL(opLte),
+		PLW_LABEL(opLtef),
+		PLW_LABEL(opAnd),
+		PLW_LABEL(opOr),
+		PLW_LABEL(opNot),
+		PLW_LABEL(opEq),
+		PLW_LABEL(opEqf),
+		PLW_LABEL(opEqRef),
+		PLW_LABEL(opNe),
+		PLW_LABEL(opNef),
+		PLW_LABEL(opPushPtrOffset),
+		PLW_LABEL(opPushPtrOffsetForMutate),
+		PLW_LABEL(opPopPtrOffset),
+		PLW_LABEL(opRaise),
+		PLW_LABEL(opRetVal),
+		PLW_LABEL(opRet),
+		PLW_LABEL(opYield),
+		PLW_LABEL(opYieldDone),
+		PLW_LABEL(opNext),
+		PLW_LABEL(opEnded),
+		PLW_LABEL(opBasicArrayTimes),
+		PLW_LABEL(opArrayTimes),
+		PLW_LABEL(opByteArrayTimes),
+		PLW_LABEL(opJz),
+		PLW_LABEL(opJnz),
+		PLW_LABEL(opJmp),
+		PLW_LABEL(opPush),
+		PLW_LABEL(opPushGlobal),
+		PLW_LABEL(opPushGlobalForMutate),
+		PLW_LABEL(opPushLocal),
+		PLW_LABEL(opPushLocalForMutate),
+		PLW_LABEL(opPushIndirection),
+		PLW_LABEL(opPushIndirect),
+		PLW_LABEL(opPushIndirectForMutate),
+		PLW_LABEL(opPopGlobal),
+		PLW_LABEL(opPopLocal),
+		PLW_LABEL(opPopIndirect),
+		PLW_LABEL(opPopVoid),
+		PLW_LABEL(opCreateString),
+		PLW_LABEL(opCreateRecord),
+		PLW_LABEL(opCreateBasicArray),
+		PLW_LABEL(opCreateArray),
+		PLW_LABEL(opCall),
+		PLW_LABEL(opCallAbstract),
+		PLW_LABEL(opCallNative),
+		PLW_LABEL(opInitGenerator),
+		PLW_LABEL(opCreateExceptionHandler),
+		PLW_LABEL(opPushf),
+		PLW_LABEL(opPushPtrOffsetConst),
+		PLW_LABEL(opAddConst),
+		PLW_LABEL(opEqConst),
+		PLW_LABEL(opCallAbstractProc),
+		PLW_LABEL(opTailCall),
+		PLW_LABEL(opPushGlobalMove),
+		PLW_LABEL(opPushLocalMove),
+		PLW_LABEL(opPushGlobalBorrow),
+		PLW_LABEL(opPushLocalBorrow),
+		PLW_LABEL(opCreateByteArray),
+		PLW_LABEL(opPushLocalPushLocal),
+		PLW_LABEL(opPushGlobalPushGlobal),
+		PLW_LABEL(opIncLocal),
+		PLW_LABEL(opJgtLocalLocal),
+		PLW_LABEL(opJltLocalLocal)
+	};
+	const PlwInstruction *instructions;
+	const PlwInstruction *instruction;
+	
+transfer:
+	if (sm->jit != NULL) {
+		PlwJit_Run(sm->jit, sm, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+	PLW_LOAD_CODE_BLOCK;
+	PLW_DISPATCH;
+	
+opEndOfBlock:
+	return;
+	
+opSuspend:
+	PlwStackMachineError_Suspended(error);
+	return;
+
+	PLW_OP1(opDup, PlwStackMachine_OpcodeDup)
+	PLW_OP1(opSwap, PlwStackMachine_OpcodeSwap)
+	PLW_OP1(opAdd, PlwStackMachine_OpcodeAdd)
+	PLW_OP1(opAddf, PlwStackMachine_OpcodeAddf)
+	PLW_OP1(opSub, PlwStackMachine_OpcodeSub)
+	PLW_OP1(opSubf, PlwStackMachine_OpcodeSubf)
+	PLW_OP1_TRANSFER(opDiv, PlwStackMachine_OpcodeDiv)
+	PLW_OP1(opDivf, PlwStackMachine_OpcodeDivf)
+	PLW_OP1_TRANSFER(opRem, PlwStackMachine_OpcodeRem)
+	PLW_OP1(opMul, PlwStackMachine_OpcodeMul)
+	PLW_OP1(opMulf, PlwStackMachine_OpcodeMulf)
+	PLW_OP1(opNeg, PlwStackMachine_OpcodeNeg)
+	PLW_OP1(opNegf, PlwStackMachine_OpcodeNegf)
+	PLW_OP1(opGt, PlwStackMachine_OpcodeGt)
+	PLW_OP1(opGtf, PlwStackMachine_OpcodeGtf)
+	PLW_OP1(opLt, PlwStackMachine_OpcodeLt)
+	PLW_OP1(opLtf, PlwStackMachine_OpcodeLtf)
+	PLW_OP1(opGte, PlwStackMachine_OpcodeGte)
+	PLW_OP1(opGtef, PlwStackMachine_OpcodeGtef)
+	PLW_OP1(opLte, PlwStackMachine_OpcodeLte)
+	PLW_OP1(opLtef, PlwStackMachine_OpcodeLtef)
+	PLW_OP1(opAnd, PlwStackMachine_OpcodeAnd)
+	PLW_OP1(opOr, PlwStackMachine_OpcodeOr)
+	PLW_OP1(opNot, PlwStackMachine_OpcodeNot)
+	PLW_OP1(opEq, PlwStackMachine_OpcodeEq)
+	PLW_OP1(opEqf, PlwStackMachine_OpcodeEqf)
+	PLW_OP1(opEqRef, PlwStackMachine_OpcodeEqRef)
+	PLW_OP1(opNe, PlwStackMachine_OpcodeNe)
+	PLW_OP1(opNef, PlwStackMachine_OpcodeNef)
+	PLW_OP1(opPushPtrOffset, PlwStackMachine_OpcodePushPtrOffset)
+	PLW_OP1(opPushPtrOffsetForMutate, PlwStackMachine_OpcodePushPtrOffsetForMutate)
+	PLW_OP1(opPopPtrOffset, PlwStackMachine_OpcodePopPtrOffset)
+	PLW_OP1_TRANSFER(opRaise, PlwStackMachine_OpcodeRaise)
+	PLW_OP1_TRANSFER(opRetVal, PlwStackMachine_OpcodeRetVal)
+	PLW_OP1_TRANSFER(opRet, PlwStackMachine_OpcodeRet)
+	PLW_OP1_TRANSFER(opYield, PlwStackMachine_OpcodeYield)
+	PLW_OP1_TRANSFER(opYieldDone, PlwStackMachine_OpcodeYieldDone)
+	PLW_OP1_TRANSFER(opNext, PlwStackMachine_OpcodeNext)
+	PLW_OP1(opEnded, PlwStackMachine_OpcodeEnded)
+	PLW_OP1(opBasicArrayTimes, PlwStackMachine_OpcodeBasicArrayTimes)
+	PLW_OP1(opArrayTimes, PlwStackMachine_OpcodeArrayTimes)
+	PLW_OP1(opByteArrayTimes, PlwStackMachine_OpcodeByteArrayTimes)
+	PLW_OP2(opJz, PlwStackMachine_OpcodeJz)
+	PLW_OP2(opJnz, PlwStackMachine_OpcodeJnz)
+	PLW_OP2(opJmp, PlwStackMachine_OpcodeJmp)
+	PLW_OP2(opPush, PlwStackMachine_OpcodePush)
+	PLW_OP2(opPushGlobal, PlwStackMachine_OpcodePushGlobal)
+	PLW_OP2(opPushGlobalForMutate, PlwStackMachine_OpcodePushGlobalForMutate)
+	PLW_OP2(opPushLocal, PlwStackMachine_OpcodePushLocal)
+	PLW_OP2(opPushLocalForMutate, PlwStackMachine_OpcodePushLocalForMutate)
+	PLW_OP2(opPushIndirection, PlwStackMachine_OpcodePushIndirection)
+	PLW_OP2(opPushIndirect, PlwStackMachine_OpcodePushIndirect)
+	PLW_OP2(opPushIndirectForMutate, PlwStackMachine_OpcodePushIndirectForMutate)
+	PLW_OP2(opPopGlobal, PlwStackMachine_OpcodePopGlobal)
+	PLW_OP2(opPopLocal, PlwStackMachine_OpcodePopLocal)
+	PLW_OP2(opPopIndirect, PlwStackMachine_OpcodePopIndirect)
+	PLW_OP2(opPopVoid, PlwStackMachine_OpcodePopVoid)
+	PLW_OP2(opCreateString, PlwStackMachine_OpcodeCreateString)
+	PLW_OP2(opCreateRecord, PlwStackMachine_OpcodeCreateRecord)
+	PLW_OP2(opCreateBasicArray, PlwStackMachine_OpcodeCreateBasicArray)
+	PLW_OP2(opCreateArray, PlwStackMachine_OpcodeCreateArray)
+	PLW_OP2_TRANSFER(opCall, PlwStackMachine_OpcodeCall)
+	PLW_OP2_TRANSFER(opCallAbstract, PlwStackMachine_OpcodeCallAbstract)
+	PLW_OP2(opCallNative, PlwStackMachine_OpcodeCallNative)
+	PLW_OP2(opInitGenerator, PlwStackMachine_OpcodeInitGenerator)
+	PLW_OP2(opCreateExceptionHandler, PlwStackMachine_OpcodeCreateExceptionHandler)
+	PLW_OP2(opPushf, PlwStackMachine_OpcodePushf)
+	PLW_OP2(opPushPtrOffsetConst, PlwStackMachine_OpcodePushPtrOffsetConst)
+	PLW_OP2(opAddConst, PlwStackMachine_OpcodeAddConst)
+	PLW_OP2(opEqConst, PlwStackMachine_OpcodeEqConst)
+	PLW_OP2_TRANSFER(opCallAbstractProc, PlwStackMachine_OpcodeCallAbstractProc)
+	PLW_OP2_TRANSFER(opTailCall, PlwStackMachine_OpcodeTailCall)
+	PLW_OP2(opPushGlobalMove, PlwStackMachine_OpcodePushGlobalMove)
+	PLW_OP2(opPushLocalMove, PlwStackMachine_OpcodePushLocalMove)
+	PLW_OP2(opPushGlobalBorrow, PlwStackMachine_OpcodePushGlobalBorrow)
+	PLW_OP2(opPushLocalBorrow, PlwStackMachine_OpcodePushLocalBorrow)
+	PLW_OP2(opCreateByteArray, PlwStackMachine_OpcodeCreateByteArray)
+	PLW_OP3(opPushLocalPushLocal, PlwStackMachine_OpcodePushLocalPushLocal)
+	PLW_OP3(opPushGlobalPushGlobal, PlwStackMachine_OpcodePushGlobalPushGlobal)
+	PLW_OP3(opIncLocal, PlwStackMachine_OpcodeIncLocal)
+	PLW_OP4(opJgtLocalLocal, PlwStackMachine_OpcodeJgtLocalLocal)
+	PLW_OP4(opJltLocalLocal, PlwStackMachine_OpcodeJltLocalLocal)
+}
+
+#else
+
 static void PlwStackMachine_Opcode1(PlwStackMachine *sm, PlwInt code, PlwError *error) {
 	switch(code) {
 	case PLW_OPCODE_SUSPEND:
@@ -1602,6 +1943,9 @@ static void PlwStackMachine_Opcode1(PlwStackMachine *sm, PlwInt code, PlwError *
 	case PLW_OPCODE_ARRAY_TIMES:
 		PlwStackMachine_OpcodeArrayTimes(sm, error);
 		break;
+	case PLW_OPCODE_BYTE_ARRAY_TIMES:
+		PlwStackMachine_OpcodeByteArrayTimes(sm, error);
+		break;
 	default:
 		PlwStackMachineError_UnknownOp(error, code);
 	}
@@ -1684,41 +2028,113 @@ static void PlwStackMachine_Opcode2(PlwStackMachine *sm, PlwInt code, PlwInt arg
 	case PLW_OPCODE_PUSHF:
 		PlwStackMachine_OpcodePushf(sm, arg1, error);
 		break;
+	case PLW_OPCODE_PUSH_PTR_OFFSET_CONST:
+		PlwStackMachine_OpcodePushPtrOffsetConst(sm, arg1, error);
+		break;
+	case PLW_OPCODE_ADD_CONST:
+		PlwStackMachine_OpcodeAddConst(sm, arg1, error);
+		break;
+	case PLW_OPCODE_EQ_CONST:
+		PlwStackMachine_OpcodeEqConst(sm, arg1, error);
+		break;
+	case PLW_OPCODE_CALL_ABSTRACT_PROC:
+		PlwStackMachine_OpcodeCallAbstractProc(sm, arg1, error);
+		break;
+	case PLW_OPCODE_TAIL_CALL:
+		PlwStackMachine_OpcodeTailCall(sm, arg1, error);
+		break;
+	case PLW_OPCODE_PUSH_GLOBAL_MOVE:
+		PlwStackMachine_OpcodePushGlobalMove(sm, arg1, error);
+		break;
+	case PLW_OPCODE_PUSH_LOCAL_MOVE:
+		PlwStackMachine_OpcodePushLocalMove(sm, arg1, error);
+		break;
+	case PLW_OPCODE_PUSH_GLOBAL_BORROW:
+		PlwStackMachine_OpcodePushGlobalBorrow(sm, arg1, error);
+		break;
+	case PLW_OPCODE_PUSH_LOCAL_BORROW:
+		PlwStackMachine_OpcodePushLocalBorrow(sm, arg1, error);
+		break;
+	case PLW_OPCODE_CREATE_BYTE_ARRAY:
+		PlwStackMachine_OpcodeCreateByteArray(sm, arg1, error);
+		break;
+	default:
+		PlwStackMachineError_UnknownOp(error, code);
+	}
+}
+
+static void PlwStackMachine_Opcode3(PlwStackMachine *sm, PlwInt code, PlwInt arg1, PlwInt arg2, PlwError *error) {
+	switch(code) {
+	case PLW_OPCODE_PUSH_LOCAL_PUSH_LOCAL:
+		PlwStackMachine_OpcodePushLocalPushLocal(sm, arg1, arg2, error);
+		break;
+	case PLW_OPCODE_PUSH_GLOBAL_PUSH_GLOBAL:
+		PlwStackMachine_OpcodePushGlobalPushGlobal(sm, arg1, arg2, error);
+		break;
+	case PLW_OPCODE_INC_LOCAL:
+		PlwStackMachine_OpcodeIncLocal(sm, arg1, arg2, error);
+		break;
+	default:
+		PlwStackMachineError_UnknownOp(error, code);
+	}
+}
+
+static void PlwStackMachine_Opcode4(PlwStackMachine *sm, PlwInt code, PlwInt arg1, PlwInt arg2, PlwInt arg3, PlwError *error) {
+	switch(code) {
+	case PLW_OPCODE_JGT_LOCAL_LOCAL:
+		PlwStackMachine_OpcodeJgtLocalLocal(sm, arg1, arg2, arg3, error);
+		break;
+	case PLW_OPCODE_JLT_LOCAL_LOCAL:
+		PlwStackMachine_OpcodeJltLocalLocal(sm, arg1, arg2, arg3, error);
+		break;
 	default:
 		PlwStackMachineError_UnknownOp(error, code);
 	}
 }
 
 static void PlwStackMachine_RunLoop(PlwStackMachine *sm, PlwError *error) {
-	PlwInt code;
-	PlwInt arg1;
-	const PlwCodeBlock *codeBlock;
+	const PlwInstruction *instruction;
 	for (;;) {
-		codeBlock = &sm->codeBlocks[sm->codeBlockId];
-		if (sm->ip >= codeBlock->codeCount) {
-			break;
-		}
-		code = codeBlock->codes[sm->ip];
+		instruction = &sm->codeBlocks[sm->codeBlockId].instructions[sm->ip];
 		sm->ip++;
-		if (code <= PLW_OPCODE1_MAX) {
+		if (instruction->opcode <= PLW_OPCODE1_MAX) {
+			if (instruction->opcode == PLW_OPCODE_NOP) {
+				break;
+			}
 #ifdef PLW_DEBUG_SM
-			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[code]);
+			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode]);
 #endif
-			PlwStackMachine_Opcode1(sm, code, error);
+			PlwStackMachine_Opcode1(sm, instruction->opcode, error);
 			if (PlwIsError(error)) {
 				return;
 			}
-		} else {
-			if (sm->ip >= codeBlock->codeCount) {
-				PlwStackMachineError_CodeAccessOutOfBound(error, codeBlock->name, sm->ip);
+		} else if (instruction->opcode <= PLW_OPCODE2_MAX) {
+#ifdef PLW_DEBUG_SM
+			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1);
+#endif
+			PlwStackMachine_Opcode2(sm, instruction->opcode, instruction->arg1, error);
+			if (PlwIsError(error)) {
+				return;
+			}
+		} else if (instruction->opcode <= PLW_OPCODE3_MAX) {
+#ifdef PLW_DEBUG_SM
+			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1, instruction->arg2);
+#endif
+			PlwStackMachine_Opcode3(sm, instruction->opcode, instruction->arg1, instruction->arg2, error);
+			if (PlwIsError(error)) {
 				return;
 			}
-			arg1 = codeBlock->codes[sm->ip];
-			sm->ip++;
+		} else {
 #ifdef PLW_DEBUG_SM
-			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 2, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[code], arg1);
+			printf("sp: %ld, bp: %ld, cs: %ld, ip: %ld nbrefs: %ld   %s %ld %ld %ld\n", sm->sp, sm->bp, sm->codeBlockId, sm->ip - 1, PlwRefManager_RefCount(sm->refMan), PlwOpcodes[instruction->opcode], instruction->arg1, instruction->arg2, instruction->arg3);
 #endif
-			PlwStackMachine_Opcode2(sm, code, arg1, error);
+			PlwStackMachine_Opcode4(sm, instruction->opcode, instruction->arg1, instruction->arg2, instruction->arg3, error);
+			if (PlwIsError(error)) {
+				return;
+			}
+		}
+		if (sm->jit != NULL && PlwStackMachine_OpcodeHandlers[instruction->opcode].isTransfer) {
+			PlwJit_Run(sm->jit, sm, error);
 			if (PlwIsError(error)) {
 				return;
 			}
@@ -1726,9 +2142,30 @@ static void PlwStackMachine_RunLoop(PlwStackMachine *sm, PlwError *error) {
 	}
 }
 
+#endif
+
 void PlwStackMachine_Execute(PlwStackMachine *sm, PlwInt codeBlockId, PlwError *error) {
+	PlwStackMachine_GrowStack(sm, sm->codeBlocks[codeBlockId].maxStackDepth, error);
+	if (PlwIsError(error)) {
+		return;
+	}
 	sm->ip = 0;
 	sm->codeBlockId = codeBlockId;
 	PlwStackMachine_RunLoop(sm, error);
 }
 
+void PlwStackMachine_ExecuteCompiled(PlwStackMachine *sm, PlwInt codeBlockId, const PlwCompiledCodeBlock *compiledCodeBlocks, PlwError *error) {
+	PlwStackMachine_GrowStack(sm, sm->codeBlocks[codeBlockId].maxStackDepth, error);
+	if (PlwIsError(error)) {
+		return;
+	}
+	sm->ip = 0;
+	sm->codeBlockId = codeBlockId;
+	while (sm->ip < sm->codeBlocks[sm->codeBlockId].instructionCount) {
+		compiledCodeBlocks[sm->codeBlockId](sm, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+}
+
@@ -4,14 +4,19 @@
 #include "PlwCommon.h"
 #include "PlwCodeBlock.h"
 #include "PlwRefManager.h"
-
-extern const char * const PlwStackMachineErrorCodeAccessOutOfBound;
+#include "PlwJit.h"
 
 struct PlwStackMachine;
 typedef struct PlwStackMachine PlwStackMachine;
 
 typedef void (*PlwNativeFunction)(PlwStackMachine *sm, PlwError *error);
 
+/*
+ * A code block translated to C by plw2c. It resumes the block at sm->ip and
+ * returns when the block is left, with the stack machine up to date.
+ */
+typedef void (*PlwCompiledCodeBlock)(PlwStackMachine *sm, PlwError *error);
+
 struct PlwStackMachine {
 	PlwBoolean *stackMap;
 	PlwInt *stack;
@@ -26,16 +31,27 @@ struct PlwStackMachine {
 	PlwInt nativeCount;
 	const PlwNativeFunction *natives;
 	PlwOffsetValue offsetValue;
+	PlwJit *jit;
 };
 
+/* the opcode handlers of the vm, indexed by opcode */
+extern const PlwJitOpcode PlwStackMachine_OpcodeHandlers[];
+
 PlwStackMachine *PlwStackMachine_Create(PlwError *error);
 
 void PlwStackMachine_Destroy(PlwStackMachine *sm);
 
+/* code blocks must have been decoded and verified, the opcodes rely on it for the stack bounds */
 void PlwStackMachine_SetCodeBlocks(PlwStackMachine *sm, PlwInt codeBlockCount, PlwCodeBlock *codeBlocks);
 
 void PlwStackMachine_SetNatives(PlwStackMachine *sm, PlwInt nativeCount, const PlwNativeFunction *natives);
 
+/* compiles the hot code blocks to native code, after the code blocks are set */
+void PlwStackMachine_EnableJit(PlwStackMachine *sm, PlwError *error);
+
 void PlwStackMachine_Execute(PlwStackMachine *sm, PlwInt codeBlockId, PlwError *error);
 
+/* runs the code block with compiledCodeBlocks, indexed by code block id, instead of the run loop */
+void PlwStackMachine_ExecuteCompiled(PlwStackMachine *sm, PlwInt codeBlockId, const PlwCompiledCodeBlock *compiledCodeBlocks, PlwError *error);
+
 #endif
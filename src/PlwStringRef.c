@@ -3,9 +3,18 @@
 #include "PlwCommon.h"
 #include <string.h>
 
+/*
+ * The len chars may hold nuls. The chars a string owns are followed by a nul,
+ * capacity counts the bytes allocated for them apart from the ref. A view
+ * points to chars of its parent, on which it holds a count, and is not
+ * followed by a nul.
+ */
 struct PlwStringRef {
 	PlwAbstractRef super;
+	PlwInt len;
+	PlwInt capacity;
 	char *ptr;
+	PlwRefId parentRefId;
 };
 
 const char * const PlwStringRefTagName = "PlwStringRef";
@@ -20,28 +29,131 @@ const PlwAbstractRefTag PlwStringRefTag = {
 	PlwStringRef_QuickDestroy
 };
 
-PlwRefId PlwStringRef_Make(PlwRefManager *refMan, char *ptr, PlwError *error) {
+PlwRefId PlwStringRef_Make(PlwRefManager *refMan, char *ptr, PlwInt len, PlwError *error) {
 	PlwStringRef *ref;
 	PlwRefId refId;
-	ref = PlwAlloc(sizeof(PlwStringRef), error);
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwStringRef), error);
 	if (PlwIsError(error)) {
 		return -1;
 	}
 	ref->super.tag = &PlwStringRefTag;
 	ref->super.refCount = 1;
+	ref->len = len;
+	ref->capacity = len + 1;
 	ref->ptr = ptr;
+	ref->parentRefId = -1;
 	refId = PlwRefManager_AddRef(refMan, ref, error);
 	if (PlwIsError(error)) {
-		PlwFree(ref);
+		PlwRefManager_Free(refMan, ref, sizeof(PlwStringRef));
 		return -1;
 	}
 	return refId;
 }
 
+/* the len chars and the terminating nul follow the ref in the same allocation, *ptr is set to them for the caller to fill */
+PlwRefId PlwStringRef_MakeInline(PlwRefManager *refMan, PlwInt len, char **ptr, PlwError *error) {
+	PlwStringRef *ref;
+	PlwRefId refId;
+	*ptr = NULL;
+	ref = PlwRefManager_Alloc(refMan, sizeof(PlwStringRef) + len + 1, error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	ref->super.tag = &PlwStringRefTag;
+	ref->super.refCount = 1;
+	ref->len = len;
+	ref->capacity = 0;
+	ref->ptr = (char *) (ref + 1);
+	ref->ptr[len] = '\0';
+	ref->parentRefId = -1;
+	refId = PlwRefManager_AddRef(refMan, ref, error);
+	if (PlwIsError(error)) {
+		PlwRefManager_Free(refMan, ref, sizeof(PlwStringRef) + len + 1);
+		return -1;
+	}
+	*ptr = ref->ptr;
+	return refId;
+}
+
+static PlwRefId PlwStringRef_MakeCopy(PlwRefManager *refMan, PlwStringRef *ref, PlwInt index, PlwInt len, PlwError *error) {
+	PlwRefId copyRefId;
+	char *ptr;
+	copyRefId = PlwStringRef_MakeInline(refMan, len, &ptr, error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	memcpy(ptr, ref->ptr + index, len);
+	return copyRefId;
+}
+
+/* a short piece is copied, a view of a view shares the chars of the parent */
+PlwRefId PlwStringRef_MakeView(PlwRefManager *refMan, PlwRefId refId, PlwStringRef *ref, PlwInt index, PlwInt len, PlwError *error) {
+	PlwStringRef *view;
+	PlwRefId viewRefId;
+	if (len < PLW_STRING_VIEW_MIN_LEN) {
+		return PlwStringRef_MakeCopy(refMan, ref, index, len, error);
+	}
+	view = PlwRefManager_Alloc(refMan, sizeof(PlwStringRef), error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	view->super.tag = &PlwStringRefTag;
+	view->super.refCount = 1;
+	view->len = len;
+	view->capacity = 0;
+	view->ptr = ref->ptr + index;
+	view->parentRefId = ref->parentRefId != -1 ? ref->parentRefId : refId;
+	viewRefId = PlwRefManager_AddRef(refMan, view, error);
+	if (PlwIsError(error)) {
+		PlwRefManager_Free(refMan, view, sizeof(PlwStringRef));
+		return -1;
+	}
+	PlwRefManager_IncRefCount(refMan, view->parentRefId, error);
+	if (PlwIsError(error)) {
+		return -1;
+	}
+	return viewRefId;
+}
+
+PlwRefId PlwStringRef_MakeSubtext(PlwRefManager *refMan, PlwRefId refId, PlwStringRef *ref, PlwInt index, PlwInt len, PlwError *error) {
+	PlwStringRef *root = ref;
+	if (ref->parentRefId != -1) {
+		root = PlwRefManager_GetRef(refMan, ref->parentRefId, error);
+		if (PlwIsError(error)) {
+			return -1;
+		}
+	}
+	if (root->len >= PLW_STRING_LARGE_ROOT_LEN && len * PLW_STRING_SMALL_PIECE_RATIO < root->len) {
+		return PlwStringRef_MakeCopy(refMan, ref, index, len, error);
+	}
+	return PlwStringRef_MakeView(refMan, refId, ref, index, len, error);
+}
+
 char *PlwStringRef_Ptr(PlwStringRef *ref) {
 	return ref->ptr;
 }
 
+PlwInt PlwStringRef_Len(PlwStringRef *ref) {
+	return ref->len;
+}
+
+/* the chars grow geometrically, the chars of an inline string or of a view cannot move */
+PlwBoolean PlwStringRef_Append(PlwStringRef *ref, const char *str, PlwInt len, PlwError *error) {
+	PlwInt size;
+	if (ref->super.refCount > 1 || ref->ptr == (char *) (ref + 1) || ref->parentRefId != -1) {
+		return PlwFalse;
+	}
+	size = ref->len + 1;
+	PlwGrowArray(len, 1, &ref->ptr, &size, &ref->capacity, error);
+	if (PlwIsError(error)) {
+		return PlwFalse;
+	}
+	memcpy(ref->ptr + ref->len, str, len);
+	ref->len += len;
+	ref->ptr[ref->len] = '\0';
+	return PlwTrue;
+}
+
 void PlwStringRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error) {
 	PlwRefManError_InvalidOperation(error, PlwStringRefTagName, "SetOffsetValue");
 }
@@ -58,18 +170,29 @@ PlwRefId PlwStringRef_ShallowCopy(PlwRefManager *refMan, void *ref, PlwError *er
 PlwBoolean PlwStringRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2, PlwError *error) {
 	PlwStringRef *stringRef1 = ref1;
 	PlwStringRef *stringRef2 = ref2;
-	return strcmp(stringRef1->ptr, stringRef2->ptr) == 0;
+	return stringRef1->len == stringRef2->len && memcmp(stringRef1->ptr, stringRef2->ptr, stringRef1->len) == 0;
 }
 
 void PlwStringRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error) {
 	PlwStringRef *stringRef = ref;
-	PlwFree(stringRef->ptr);
-	PlwFree(stringRef);
+	if (stringRef->parentRefId != -1) {
+		PlwRefManager_DecRefCount(refMan, stringRef->parentRefId, error);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+	PlwStringRef_QuickDestroy(refMan, ref);
 }
 
-void PlwStringRef_QuickDestroy(void *ref) {
+void PlwStringRef_QuickDestroy(PlwRefManager *refMan, void *ref) {
 	PlwStringRef *stringRef = ref;
-	PlwFree(stringRef->ptr);
-	PlwFree(stringRef);
+	if (stringRef->parentRefId != -1) {
+		PlwRefManager_Free(refMan, stringRef, sizeof(PlwStringRef));
+	} else if (stringRef->ptr != (char *) (stringRef + 1)) {
+		PlwFree(stringRef->ptr);
+		PlwRefManager_Free(refMan, stringRef, sizeof(PlwStringRef));
+	} else {
+		PlwRefManager_Free(refMan, stringRef, sizeof(PlwStringRef) + stringRef->len + 1);
+	}
 }
 
@@ -3,14 +3,36 @@
 
 #include "PlwRefManager.h"
 
+/* the shorter pieces of a string are copied instead of viewed */
+#define PLW_STRING_VIEW_MIN_LEN 32
+
+/* a subtext of a root of at least PLW_STRING_LARGE_ROOT_LEN chars is copied when it is PLW_STRING_SMALL_PIECE_RATIO times shorter */
+#define PLW_STRING_LARGE_ROOT_LEN (1024 * 1024)
+#define PLW_STRING_SMALL_PIECE_RATIO 16
+
 extern const char * const PlwStringRefTagName;
 struct PlwStringRef;
 typedef struct PlwStringRef PlwStringRef;
 
-PlwRefId PlwStringRef_Make(PlwRefManager *refMan, char *ptr, PlwError *error);
+/* ptr holds len chars followed by a nul */
+PlwRefId PlwStringRef_Make(PlwRefManager *refMan, char *ptr, PlwInt len, PlwError *error);
+
+PlwRefId PlwStringRef_MakeInline(PlwRefManager *refMan, PlwInt len, char **ptr, PlwError *error);
+
+/* the len chars at index of the string refId, that the view shares */
+PlwRefId PlwStringRef_MakeView(PlwRefManager *refMan, PlwRefId refId, PlwStringRef *ref, PlwInt index, PlwInt len, PlwError *error);
 
+/* like PlwStringRef_MakeView, but a small piece of a large string is copied so that it does not keep that string alive */
+PlwRefId PlwStringRef_MakeSubtext(PlwRefManager *refMan, PlwRefId refId, PlwStringRef *ref, PlwInt index, PlwInt len, PlwError *error);
+
+/* the chars are not followed by a nul in a view */
 char *PlwStringRef_Ptr(PlwStringRef *ref);
 
+PlwInt PlwStringRef_Len(PlwStringRef *ref);
+
+/* appends the len chars at str in place to a string that is not shared and holds its chars apart, returns PlwFalse when it cannot */
+PlwBoolean PlwStringRef_Append(PlwStringRef *ref, const char *str, PlwInt len, PlwError *error);
+
 void PlwStringRef_SetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwInt value, PlwError *error);
 
 void PlwStringRef_GetOffsetValue(PlwRefManager *refMan, void *ref, PlwInt offset, PlwBoolean isForMutate, PlwError *error, PlwOffsetValue *result);
@@ -21,6 +43,6 @@ PlwBoolean PlwStringRef_CompareTo(PlwRefManager *refMan, void *ref1, void *ref2,
 
 void PlwStringRef_Destroy(PlwRefManager *refMan, void *ref, PlwError *error);
 
-void PlwStringRef_QuickDestroy(void *ref);
+void PlwStringRef_QuickDestroy(PlwRefManager *refMan, void *ref);
 
 #endif
@@ -0,0 +1,141 @@
+#include "PlwTextSearch.h"
+#include <string.h>
+
+#ifdef PLW_TEXT_SEARCH_X86_64
+#include <immintrin.h>
+#endif
+
+PlwInt PlwTextSearch_FindChar(const char *ptr, PlwInt len, char c) {
+	const char *p = memchr(ptr, c, len);
+	return p == NULL ? -1 : p - ptr;
+}
+
+PlwInt PlwTextSearch_FindScalar(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	const char *p = ptr1;
+	const char *last;
+	if (len2 == 0) {
+		return 0;
+	}
+	if (len2 > len1) {
+		return -1;
+	}
+	last = ptr1 + len1 - len2;
+	while (p <= last) {
+		p = memchr(p, ptr2[0], last - p + 1);
+		if (p == NULL) {
+			return -1;
+		}
+		if (p[len2 - 1] == ptr2[len2 - 1] && memcmp(p, ptr2, len2) == 0) {
+			return p - ptr1;
+		}
+		p++;
+	}
+	return -1;
+}
+
+#ifdef PLW_TEXT_SEARCH_X86_64
+
+/*
+ * A bit of the mask is set for each position of a block where both the first
+ * and the last chars of the searched text match, only those positions are
+ * compared in full. The block of the last chars is read len2 - 1 chars after
+ * the block of the first chars, so the blocks stop at the last position where
+ * the searched text fits and the positions left are searched by the scalar
+ * kernel.
+ */
+
+PlwInt PlwTextSearch_FindSse2(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	__m128i first;
+	__m128i last;
+	__m128i matches;
+	unsigned int mask;
+	PlwInt positionCount;
+	PlwInt i;
+	PlwInt index;
+	if (len2 < 2 || len2 > len1) {
+		return PlwTextSearch_FindScalar(ptr1, len1, ptr2, len2);
+	}
+	first = _mm_set1_epi8(ptr2[0]);
+	last = _mm_set1_epi8(ptr2[len2 - 1]);
+	positionCount = len1 - len2 + 1;
+	for (i = 0; i + 16 <= positionCount; i += 16) {
+		matches = _mm_and_si128(
+			_mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *) (ptr1 + i))),
+			_mm_cmpeq_epi8(last, _mm_loadu_si128((const __m128i *) (ptr1 + i + len2 - 1)))
+		);
+		mask = _mm_movemask_epi8(matches);
+		while (mask != 0) {
+			index = i + __builtin_ctz(mask);
+			if (memcmp(ptr1 + index + 1, ptr2 + 1, len2 - 2) == 0) {
+				return index;
+			}
+			mask &= mask - 1;
+		}
+	}
+	index = PlwTextSearch_FindScalar(ptr1 + i, len1 - i, ptr2, len2);
+	return index == -1 ? -1 : i + index;
+}
+
+__attribute__((target("avx2")))
+PlwInt PlwTextSearch_FindAvx2(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	__m256i first;
+	__m256i last;
+	__m256i matches;
+	unsigned int mask;
+	PlwInt positionCount;
+	PlwInt i;
+	PlwInt index;
+	if (len2 < 2 || len2 > len1) {
+		return PlwTextSearch_FindScalar(ptr1, len1, ptr2, len2);
+	}
+	first = _mm256_set1_epi8(ptr2[0]);
+	last = _mm256_set1_epi8(ptr2[len2 - 1]);
+	positionCount = len1 - len2 + 1;
+	for (i = 0; i + 32 <= positionCount; i += 32) {
+		matches = _mm256_and_si256(
+			_mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i *) (ptr1 + i))),
+			_mm256_cmpeq_epi8(last, _mm256_loadu_si256((const __m256i *) (ptr1 + i + len2 - 1)))
+		);
+		mask = _mm256_movemask_epi8(matches);
+		while (mask != 0) {
+			index = i + __builtin_ctz(mask);
+			if (memcmp(ptr1 + index + 1, ptr2 + 1, len2 - 2) == 0) {
+				return index;
+			}
+			mask &= mask - 1;
+		}
+	}
+	index = PlwTextSearch_FindSse2(ptr1 + i, len1 - i, ptr2, len2);
+	return index == -1 ? -1 : i + index;
+}
+
+PlwBoolean PlwTextSearch_HasAvx2(void) {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? PlwTrue : PlwFalse;
+}
+
+static PlwInt PlwTextSearch_FindFirst(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+/* the kernel is picked from the cpu features by the first search */
+static PlwInt (*PlwTextSearch_FindKernel)(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) = PlwTextSearch_FindFirst;
+
+static PlwInt PlwTextSearch_FindFirst(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	PlwTextSearch_FindKernel = PlwTextSearch_HasAvx2() ? PlwTextSearch_FindAvx2 : PlwTextSearch_FindSse2;
+	return PlwTextSearch_FindKernel(ptr1, len1, ptr2, len2);
+}
+
+#else
+
+static PlwInt (*PlwTextSearch_FindKernel)(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) = PlwTextSearch_FindScalar;
+
+#endif
+
+PlwInt PlwTextSearch_Find(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	if (len2 == 0) {
+		return 0;
+	}
+	if (len2 == 1) {
+		return PlwTextSearch_FindChar(ptr1, len1, ptr2[0]);
+	}
+	return PlwTextSearch_FindKernel(ptr1, len1, ptr2, len2);
+}
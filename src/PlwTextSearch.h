@@ -0,0 +1,38 @@
+#ifndef PLWTEXTSEARCH_H_
+#define PLWTEXTSEARCH_H_
+
+#include "PlwCommon.h"
+
+/*
+ * Search of chars in strings that are not nul-terminated. On x86-64 with GCC
+ * or Clang the substring search filters the candidate positions with vector
+ * compares of the first and last chars of the searched text, 16 at a time
+ * with SSE2 or 32 at a time with AVX2 when the cpu has it. Single chars are
+ * left to memchr, the C library already has vector versions of it.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PLW_TEXT_SEARCH_X86_64
+#endif
+
+/* the index of the first c in the len chars at ptr, or -1 */
+PlwInt PlwTextSearch_FindChar(const char *ptr, PlwInt len, char c);
+
+/* the index of the first len2 chars at ptr2 in the len1 chars at ptr1, or -1 */
+PlwInt PlwTextSearch_Find(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+/* the kernels that PlwTextSearch_Find picks from, for the benchmark */
+
+PlwInt PlwTextSearch_FindScalar(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+#ifdef PLW_TEXT_SEARCH_X86_64
+
+PlwInt PlwTextSearch_FindSse2(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+PlwInt PlwTextSearch_FindAvx2(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+PlwBoolean PlwTextSearch_HasAvx2(void);
+
+#endif
+
+#endif
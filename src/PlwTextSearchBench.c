@@ -0,0 +1,113 @@
+#include "PlwTextSearch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Times the text search kernels on a few megabytes of words, every kernel
+ * counts all the matches of each searched text the way split walks them.
+ */
+
+#define PLW_BENCH_TEXT_SIZE (4 * 1024 * 1024)
+#define PLW_BENCH_ROUNDS 10
+
+typedef PlwInt (*PlwBenchKernel)(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2);
+
+static const char * const PlwBenchWords[] = {
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "then", "there",
+	"these", "other", "theme", "123", "-45", "6789", "and", "a", "to", "of"
+};
+
+static const char * const PlwBenchNeedles[] = {
+	",", "the", ", ", "lazy dog", "there the", "theme then other", "never written anywhere at all"
+};
+
+/* the reference is the search of the natives before the kernels */
+static PlwInt PlwBench_FindMemchr(const char *ptr1, PlwInt len1, const char *ptr2, PlwInt len2) {
+	const char *p = ptr1;
+	const char *last;
+	if (len2 == 0) {
+		return 0;
+	}
+	if (len2 > len1) {
+		return -1;
+	}
+	last = ptr1 + len1 - len2;
+	while (p <= last) {
+		p = memchr(p, ptr2[0], last - p + 1);
+		if (p == NULL) {
+			return -1;
+		}
+		if (memcmp(p, ptr2, len2) == 0) {
+			return p - ptr1;
+		}
+		p++;
+	}
+	return -1;
+}
+
+static PlwInt PlwBench_CountMatches(PlwBenchKernel kernel, const char *text, PlwInt textLen, const char *needle) {
+	PlwInt needleLen = strlen(needle);
+	PlwInt count = 0;
+	PlwInt pos = 0;
+	PlwInt index;
+	while ((index = kernel(text + pos, textLen - pos, needle, needleLen)) != -1) {
+		count++;
+		pos += index + needleLen;
+	}
+	return count;
+}
+
+static void PlwBench_Run(const char *name, PlwBenchKernel kernel, const char *text, PlwInt textLen, const char *needle, PlwInt expected) {
+	clock_t start;
+	double ms;
+	PlwInt count = 0;
+	PlwInt i;
+	start = clock();
+	for (i = 0; i < PLW_BENCH_ROUNDS; i++) {
+		count = PlwBench_CountMatches(kernel, text, textLen, needle);
+	}
+	ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC / PLW_BENCH_ROUNDS;
+	printf("  %-8s %8.2f ms %s\n", name, ms, count == expected ? "" : "WRONG COUNT");
+}
+
+int main(void) {
+	char *text;
+	PlwInt textLen = 0;
+	const char *word;
+	PlwInt wordLen;
+	PlwInt expected;
+	unsigned long seed = 12345;
+	size_t i;
+	text = malloc(PLW_BENCH_TEXT_SIZE);
+	if (text == NULL) {
+		return 1;
+	}
+	while (textLen < PLW_BENCH_TEXT_SIZE - 32) {
+		seed = seed * 1103515245 + 12345;
+		word = PlwBenchWords[(seed >> 16) % (sizeof(PlwBenchWords) / sizeof(PlwBenchWords[0]))];
+		wordLen = strlen(word);
+		memcpy(text + textLen, word, wordLen);
+		textLen += wordLen;
+		if ((seed >> 8) % 8 == 0) {
+			text[textLen++] = ',';
+		}
+		text[textLen++] = ' ';
+	}
+	for (i = 0; i < sizeof(PlwBenchNeedles) / sizeof(PlwBenchNeedles[0]); i++) {
+		expected = PlwBench_CountMatches(PlwBench_FindMemchr, text, textLen, PlwBenchNeedles[i]);
+		printf("'%s', %ld matches in %ld chars\n", PlwBenchNeedles[i], expected, textLen);
+		PlwBench_Run("memchr", PlwBench_FindMemchr, text, textLen, PlwBenchNeedles[i], expected);
+		PlwBench_Run("scalar", PlwTextSearch_FindScalar, text, textLen, PlwBenchNeedles[i], expected);
+#ifdef PLW_TEXT_SEARCH_X86_64
+		PlwBench_Run("sse2", PlwTextSearch_FindSse2, text, textLen, PlwBenchNeedles[i], expected);
+		if (PlwTextSearch_HasAvx2()) {
+			PlwBench_Run("avx2", PlwTextSearch_FindAvx2, text, textLen, PlwBenchNeedles[i], expected);
+		}
+#endif
+		PlwBench_Run("find", PlwTextSearch_Find, text, textLen, PlwBenchNeedles[i], expected);
+	}
+	free(text);
+	return 0;
+}
@@ -0,0 +1,770 @@
+#include "PlwCommon.h"
+#include "PlwCodeBlock.h"
+#include "PlwOpcode.h"
+#include "PlwStackMachine.h"
+#include "PlwNative.h"
+#include "PlwReader.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * plw2c translates a .plwc file to a C file that is compiled with PlwAot.c
+ * and the vm sources into a standalone executable. Every code block becomes
+ * a C function that keeps the stack depths found by the verifier as
+ * constants, does the simple opcodes inline on the stack of the vm and
+ * calls the handlers of the vm for all the others. A function returns when
+ * its code block is left, by a call, a return, a yield or an exception, and
+ * is resumed by PlwStackMachine_ExecuteCompiled at the ip it was left for.
+ */
+
+const char * const PlwToCErrorFile = "PlwToCErrorFile";
+
+/* longest string literal that a C89 compiler has to accept */
+#define PLW_TOC_STRING_MAX 509
+
+/* local and global offsets past this one are left to the handlers */
+#define PLW_TOC_OFFSET_MAX 0x40000000
+
+static void PlwToCError_File(PlwError *error, const char *fileName) {
+	error->code = PlwToCErrorFile;
+	snprintf(error->message, PLW_ERROR_MESSAGE_MAX, "Can't write file %s", fileName);
+}
+
+typedef struct PlwToC {
+	FILE *out;
+	const PlwCodeBlock *cb;
+	const PlwInt *depths;
+	const PlwInt *depthsAfter;
+	PlwBoolean usesStack;
+	PlwBoolean usesBp;
+	PlwBoolean usesFloat;
+} PlwToC;
+
+static void PlwPrintError(PlwError *error) {
+	printf("%s: %s\n", error->code, error->message);
+}
+
+static void PlwToC_Int(FILE *out, PlwInt value) {
+	if (value == INT64_MIN) {
+		fprintf(out, "(-9223372036854775807L - 1)");
+	} else {
+		fprintf(out, "%ld", value);
+	}
+}
+
+static PlwBoolean PlwToC_IsLongString(const char *s) {
+	return strlen(s) > PLW_TOC_STRING_MAX;
+}
+
+/* octal escapes for anything but plain characters, and for '?' that could start a trigraph */
+static void PlwToC_String(FILE *out, const char *s) {
+	const unsigned char *p;
+	fputc('"', out);
+	for (p = (const unsigned char *) s; *p != '\0'; p++) {
+		if (*p >= 0x20 && *p < 0x7f && *p != '"' && *p != '\\' && *p != '?') {
+			fputc(*p, out);
+		} else {
+			fprintf(out, "\\%03o", *p);
+		}
+	}
+	fputc('"', out);
+}
+
+static void PlwToC_StringArray(FILE *out, const char *name, PlwInt codeBlockId, PlwInt index, const char *s) {
+	const unsigned char *p;
+	PlwInt i = 0;
+	fprintf(out, "static char %s%ld_%ld[] = {", name, codeBlockId, index);
+	for (p = (const unsigned char *) s; *p != '\0'; p++, i++) {
+		fprintf(out, i % 16 == 0 ? "\n\t%d," : " %d,", *p);
+	}
+	fprintf(out, "\n\t0\n};\n\n");
+}
+
+static void PlwToC_Data(FILE *out, const PlwCodeBlock *cb, PlwInt codeBlockId) {
+	PlwWord w;
+	PlwInt i;
+	if (PlwToC_IsLongString(cb->name)) {
+		PlwToC_StringArray(out, "PlwAot_Name", codeBlockId, 0, cb->name);
+	}
+	if (cb->codeCount > 0) {
+		fprintf(out, "static PlwInt PlwAot_Codes%ld[] = {", codeBlockId);
+		for (i = 0; i < cb->codeCount; i++) {
+			fprintf(out, i % 16 == 0 ? "\n\t" : " ");
+			PlwToC_Int(out, cb->codes[i]);
+			fprintf(out, i + 1 < cb->codeCount ? "," : "\n");
+		}
+		fprintf(out, "};\n\n");
+	}
+	for (i = 0; i < cb->strConstCount; i++) {
+		if (PlwToC_IsLongString(cb->strConsts[i])) {
+			PlwToC_StringArray(out, "PlwAot_Str", codeBlockId, i, cb->strConsts[i]);
+		}
+	}
+	if (cb->strConstCount > 0) {
+		fprintf(out, "static char *PlwAot_StrConsts%ld[] = {\n", codeBlockId);
+		for (i = 0; i < cb->strConstCount; i++) {
+			fprintf(out, "\t");
+			if (PlwToC_IsLongString(cb->strConsts[i])) {
+				fprintf(out, "PlwAot_Str%ld_%ld", codeBlockId, i);
+			} else {
+				PlwToC_String(out, cb->strConsts[i]);
+			}
+			fprintf(out, i + 1 < cb->strConstCount ? ",\n" : "\n");
+		}
+		fprintf(out, "};\n\n");
+	}
+	if (cb->floatConstCount > 0) {
+		fprintf(out, "static const PlwInt PlwAot_FloatConsts%ld[] = {\n", codeBlockId);
+		for (i = 0; i < cb->floatConstCount; i++) {
+			w.f = cb->floatConsts[i];
+			fprintf(out, "\t");
+			PlwToC_Int(out, w.i);
+			fprintf(out, i + 1 < cb->floatConstCount ? ",\n" : "\n");
+		}
+		fprintf(out, "};\n\n");
+	}
+}
+
+static PlwInt PlwToC_ArgCount(PlwInt opcode) {
+	if (opcode <= PLW_OPCODE1_MAX) {
+		return 0;
+	} else if (opcode <= PLW_OPCODE2_MAX) {
+		return 1;
+	} else if (opcode <= PLW_OPCODE3_MAX) {
+		return 2;
+	}
+	return 3;
+}
+
+/* the handler leaves sm->ip past the instruction, and resumes the block there once it is back */
+static PlwBoolean PlwToC_ResumesNext(PlwInt opcode) {
+	return opcode == PLW_OPCODE_CALL
+		|| opcode == PLW_OPCODE_CALL_ABSTRACT
+		|| opcode == PLW_OPCODE_CALL_ABSTRACT_PROC
+		|| opcode == PLW_OPCODE_NEXT
+		|| opcode == PLW_OPCODE_YIELD;
+}
+
+/* the ips the block can be resumed at, and the ones it jumps to */
+static void PlwToC_FindLabels(const PlwToC *c, PlwBoolean *isEntry, PlwBoolean *isLabel) {
+	const PlwInstruction *instruction;
+	PlwInt count = c->cb->instructionCount;
+	PlwInt i;
+	for (i = 0; i <= count; i++) {
+		isEntry[i] = PlwFalse;
+		isLabel[i] = PlwFalse;
+	}
+	if (count > 0) {
+		isEntry[0] = PlwTrue;
+	}
+	for (i = 0; i < count; i++) {
+		instruction = &c->cb->instructions[i];
+		if (c->depths[i] == -1) {
+			continue;
+		}
+		if (PlwToC_ResumesNext(instruction->opcode)) {
+			isEntry[i + 1] = PlwTrue;
+		}
+		switch (instruction->opcode) {
+		case PLW_OPCODE_CREATE_EXCEPTION_HANDLER:
+			/* a raised exception lands on the target of its handler */
+			isEntry[instruction->arg1] = PlwTrue;
+			break;
+		case PLW_OPCODE_JZ:
+		case PLW_OPCODE_JNZ:
+		case PLW_OPCODE_JMP:
+			isLabel[instruction->arg1] = PlwTrue;
+			break;
+		case PLW_OPCODE_JGT_LOCAL_LOCAL:
+		case PLW_OPCODE_JLT_LOCAL_LOCAL:
+			isLabel[instruction->arg3] = PlwTrue;
+			break;
+		}
+	}
+	for (i = 0; i < count; i++) {
+		if (c->depths[i] == -1) {
+			isEntry[i] = PlwFalse;
+		}
+		isLabel[i] = isLabel[i] || isEntry[i];
+	}
+	isEntry[count] = PlwFalse;
+	isLabel[count] = PlwFalse;
+}
+
+/* a jump past the last instruction leaves the block */
+static void PlwToC_Goto(PlwToC *c, const char *indent, PlwInt target, PlwInt depth) {
+	if (target == c->cb->instructionCount) {
+		fprintf(c->out, "%sPLW_AOT_SYNC(%ld, %ld);\n%sreturn;\n", indent, depth, target, indent);
+	} else {
+		fprintf(c->out, "%sgoto i%ld;\n", indent, target);
+	}
+}
+
+static void PlwToC_Handler(PlwToC *c, const char *indent, PlwInt depth, PlwInt nextIp, PlwInt opcode, PlwInt argCount, const PlwInt *args, PlwBoolean isTransfer) {
+	PlwInt i;
+	fprintf(c->out, "%sPLW_AOT_SYNC(%ld, %ld);\n", indent, depth, nextIp);
+	fprintf(c->out, "%sPLW_AOT_OP%ld(PLW_OPCODE_%s", indent, argCount + 1, PlwOpcodes[opcode]);
+	for (i = 0; i < argCount; i++) {
+		fprintf(c->out, ", ");
+		PlwToC_Int(c->out, args[i]);
+	}
+	fprintf(c->out, ");\n");
+	if (isTransfer) {
+		fprintf(c->out, "%sreturn;\n", indent);
+	} else {
+		fprintf(c->out, "%sif (PlwIsError(error)) {\n%s\treturn;\n%s}\n", indent, indent, indent);
+	}
+}
+
+static void PlwToC_InstructionHandler(PlwToC *c, const char *indent, PlwInt index) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	PlwInt args[3];
+	args[0] = instruction->arg1;
+	args[1] = instruction->arg2;
+	args[2] = instruction->arg3;
+	PlwToC_Handler(c, indent, c->depths[index], index + 1, instruction->opcode, PlwToC_ArgCount(instruction->opcode), args, PlwStackMachine_OpcodeHandlers[instruction->opcode].isTransfer);
+}
+
+/* writes the index of the slot, and the condition for the handler check of its bounds to pass, empty if it always does */
+static PlwBoolean PlwToC_Slot(const PlwToC *c, PlwBoolean isLocal, PlwInt offset, PlwInt depth, char *slot, char *bounds) {
+	if (offset < -PLW_TOC_OFFSET_MAX || offset > PLW_TOC_OFFSET_MAX || (!isLocal && offset < 0)) {
+		return PlwFalse;
+	}
+	bounds[0] = '\0';
+	if (!isLocal) {
+		sprintf(slot, "%ld", offset);
+		sprintf(bounds, "%ld < base + %ld && ", offset, depth);
+	} else if (offset < 0) {
+		sprintf(slot, "bp - %ld", -offset);
+		sprintf(bounds, "bp - %ld >= 0 && ", -offset);
+	} else {
+		sprintf(slot, "bp + %ld", offset);
+		/* base is never below bp, the cells under the depth of the block are in bounds */
+		if (offset >= depth) {
+			sprintf(bounds, "bp + %ld < base + %ld && ", offset, depth);
+		}
+	}
+	return PlwTrue;
+}
+
+/* a move pushes a cell that is not a ref like a copy, only a ref goes to its handler, a borrow never does */
+static void PlwToC_PushSlot(PlwToC *c, PlwInt index, PlwInt opcode, PlwInt offset, PlwInt depth) {
+	PlwBoolean isLocal = opcode == PLW_OPCODE_PUSH_LOCAL || opcode == PLW_OPCODE_PUSH_LOCAL_MOVE || opcode == PLW_OPCODE_PUSH_LOCAL_BORROW;
+	PlwBoolean isBorrow = opcode == PLW_OPCODE_PUSH_LOCAL_BORROW || opcode == PLW_OPCODE_PUSH_GLOBAL_BORROW;
+	char slot[64];
+	char bounds[128];
+	PlwInt args[1];
+	args[0] = offset;
+	if (!PlwToC_Slot(c, isLocal, offset, depth, slot, bounds)) {
+		PlwToC_Handler(c, "\t", depth, index + 1, opcode, 1, args, PlwFalse);
+		return;
+	}
+	c->usesStack = PlwTrue;
+	c->usesBp = c->usesBp || isLocal;
+	if (isBorrow) {
+		fprintf(c->out, "\tif (%sPlwTrue) {\n", bounds);
+	} else {
+		fprintf(c->out, "\tif (%s!stackMap[%s]) {\n", bounds, slot);
+	}
+	fprintf(c->out, "\t\tstack[base + %ld] = stack[%s];\n", depth, slot);
+	fprintf(c->out, "\t\tstackMap[base + %ld] = PlwFalse;\n", depth);
+	fprintf(c->out, "\t} else {\n");
+	PlwToC_Handler(c, "\t\t", depth, index + 1, opcode, 1, args, PlwFalse);
+	fprintf(c->out, "\t}\n");
+}
+
+static void PlwToC_PopSlot(PlwToC *c, PlwInt index, PlwBoolean isLocal) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	PlwInt depth = c->depths[index];
+	char slot[64];
+	char bounds[128];
+	if (!PlwToC_Slot(c, isLocal, instruction->arg1, depth, slot, bounds)) {
+		PlwToC_InstructionHandler(c, "\t", index);
+		return;
+	}
+	c->usesStack = PlwTrue;
+	c->usesBp = c->usesBp || isLocal;
+	fprintf(c->out, "\tif (%s!stackMap[%s]) {\n", bounds, slot);
+	fprintf(c->out, "\t\tstack[%s] = stack[base + %ld];\n", slot, depth - 1);
+	fprintf(c->out, "\t\tstackMap[%s] = stackMap[base + %ld];\n", slot, depth - 1);
+	fprintf(c->out, "\t} else {\n");
+	PlwToC_InstructionHandler(c, "\t\t", index);
+	fprintf(c->out, "\t}\n");
+}
+
+static void PlwToC_IncLocal(PlwToC *c, PlwInt index) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	char slot[64];
+	char bounds[128];
+	if (!PlwToC_Slot(c, PlwTrue, instruction->arg1, c->depths[index], slot, bounds)) {
+		PlwToC_InstructionHandler(c, "\t", index);
+		return;
+	}
+	c->usesStack = PlwTrue;
+	c->usesBp = PlwTrue;
+	if (bounds[0] == '\0') {
+		fprintf(c->out, "\tstack[%s] += ", slot);
+		PlwToC_Int(c->out, instruction->arg2);
+		fprintf(c->out, ";\n");
+		return;
+	}
+	/* drops the trailing " && " of the bounds */
+	bounds[strlen(bounds) - 4] = '\0';
+	fprintf(c->out, "\tif (%s) {\n\t\tstack[%s] += ", bounds, slot);
+	PlwToC_Int(c->out, instruction->arg2);
+	fprintf(c->out, ";\n\t} else {\n");
+	PlwToC_InstructionHandler(c, "\t\t", index);
+	fprintf(c->out, "\t}\n");
+}
+
+static void PlwToC_JumpLocalLocal(PlwToC *c, PlwInt index, const char *operator) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	PlwInt depth = c->depths[index];
+	char slot1[64];
+	char bounds1[128];
+	char slot2[64];
+	char bounds2[128];
+	if (!PlwToC_Slot(c, PlwTrue, instruction->arg1, depth, slot1, bounds1)
+		|| !PlwToC_Slot(c, PlwTrue, instruction->arg2, depth, slot2, bounds2)) {
+		PlwToC_InstructionHandler(c, "\t", index);
+		return;
+	}
+	c->usesStack = PlwTrue;
+	c->usesBp = PlwTrue;
+	if (bounds1[0] == '\0' && bounds2[0] == '\0') {
+		fprintf(c->out, "\tif (stack[%s] %s stack[%s]) {\n", slot1, operator, slot2);
+		PlwToC_Goto(c, "\t\t", instruction->arg3, depth);
+		fprintf(c->out, "\t}\n");
+		return;
+	}
+	/* out of bounds the handler sets the error */
+	fprintf(c->out, "\tif (%s%s1) {\n", bounds1, bounds2);
+	fprintf(c->out, "\t\tif (stack[%s] %s stack[%s]) {\n", slot1, operator, slot2);
+	PlwToC_Goto(c, "\t\t\t", instruction->arg3, depth);
+	fprintf(c->out, "\t\t}\n\t} else {\n");
+	PlwToC_InstructionHandler(c, "\t\t", index);
+	fprintf(c->out, "\t}\n");
+}
+
+static void PlwToC_Binary(PlwToC *c, PlwInt depth, const char *operator) {
+	c->usesStack = PlwTrue;
+	fprintf(c->out, "\tstack[base + %ld] = stack[base + %ld] %s stack[base + %ld];\n", depth - 2, depth - 2, operator, depth - 1);
+}
+
+static void PlwToC_DivRem(PlwToC *c, PlwInt index, const char *operator) {
+	PlwInt depth = c->depths[index];
+	c->usesStack = PlwTrue;
+	fprintf(c->out, "\tif (stack[base + %ld] != 0) {\n", depth - 1);
+	fprintf(c->out, "\t\tstack[base + %ld] = stack[base + %ld] %s stack[base + %ld];\n", depth - 2, depth - 2, operator, depth - 1);
+	fprintf(c->out, "\t} else {\n");
+	PlwToC_InstructionHandler(c, "\t\t", index);
+	fprintf(c->out, "\t}\n");
+}
+
+static void PlwToC_FloatBinary(PlwToC *c, PlwInt depth, const char *operator, PlwBoolean isCompare) {
+	c->usesStack = PlwTrue;
+	c->usesFloat = PlwTrue;
+	fprintf(c->out, "\tw1.i = stack[base + %ld];\n", depth - 2);
+	fprintf(c->out, "\tw2.i = stack[base + %ld];\n", depth - 1);
+	if (isCompare) {
+		fprintf(c->out, "\tstack[base + %ld] = w1.f %s w2.f;\n", depth - 2, operator);
+	} else {
+		fprintf(c->out, "\tw1.f = w1.f %s w2.f;\n", operator);
+		fprintf(c->out, "\tstack[base + %ld] = w1.i;\n", depth - 2);
+	}
+}
+
+static void PlwToC_Push(PlwToC *c, PlwInt depth, PlwInt value) {
+	c->usesStack = PlwTrue;
+	fprintf(c->out, "\tstack[base + %ld] = ", depth);
+	PlwToC_Int(c->out, value);
+	fprintf(c->out, ";\n\tstackMap[base + %ld] = PlwFalse;\n", depth);
+}
+
+static void PlwToC_Instruction(PlwToC *c, PlwInt index) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	PlwInt depth = c->depths[index];
+	PlwWord w;
+	switch (instruction->opcode) {
+	case PLW_OPCODE_ADD:
+		PlwToC_Binary(c, depth, "+");
+		return;
+	case PLW_OPCODE_SUB:
+		PlwToC_Binary(c, depth, "-");
+		return;
+	case PLW_OPCODE_MUL:
+		PlwToC_Binary(c, depth, "*");
+		return;
+	case PLW_OPCODE_GT:
+		PlwToC_Binary(c, depth, ">");
+		return;
+	case PLW_OPCODE_LT:
+		PlwToC_Binary(c, depth, "<");
+		return;
+	case PLW_OPCODE_GTE:
+		PlwToC_Binary(c, depth, ">=");
+		return;
+	case PLW_OPCODE_LTE:
+		PlwToC_Binary(c, depth, "<=");
+		return;
+	case PLW_OPCODE_EQ:
+		PlwToC_Binary(c, depth, "==");
+		return;
+	case PLW_OPCODE_NE:
+		PlwToC_Binary(c, depth, "!=");
+		return;
+	case PLW_OPCODE_AND:
+		PlwToC_Binary(c, depth, "&&");
+		return;
+	case PLW_OPCODE_OR:
+		PlwToC_Binary(c, depth, "||");
+		return;
+	case PLW_OPCODE_DIV:
+		PlwToC_DivRem(c, index, "/");
+		return;
+	case PLW_OPCODE_REM:
+		PlwToC_DivRem(c, index, "%");
+		return;
+	case PLW_OPCODE_NEG:
+		c->usesStack = PlwTrue;
+		fprintf(c->out, "\tstack[base + %ld] = -stack[base + %ld];\n", depth - 1, depth - 1);
+		return;
+	case PLW_OPCODE_NOT:
+		c->usesStack = PlwTrue;
+		fprintf(c->out, "\tstack[base + %ld] = !stack[base + %ld];\n", depth - 1, depth - 1);
+		return;
+	case PLW_OPCODE_ADDF:
+		PlwToC_FloatBinary(c, depth, "+", PlwFalse);
+		return;
+	case PLW_OPCODE_SUBF:
+		PlwToC_FloatBinary(c, depth, "-", PlwFalse);
+		return;
+	case PLW_OPCODE_MULF:
+		PlwToC_FloatBinary(c, depth, "*", PlwFalse);
+		return;
+	case PLW_OPCODE_DIVF:
+		PlwToC_FloatBinary(c, depth, "/", PlwFalse);
+		return;
+	case PLW_OPCODE_GTF:
+		PlwToC_FloatBinary(c, depth, ">", PlwTrue);
+		return;
+	case PLW_OPCODE_LTF:
+		PlwToC_FloatBinary(c, depth, "<", PlwTrue);
+		return;
+	case PLW_OPCODE_GTEF:
+		PlwToC_FloatBinary(c, depth, ">=", PlwTrue);
+		return;
+	case PLW_OPCODE_LTEF:
+		PlwToC_FloatBinary(c, depth, "<=", PlwTrue);
+		return;
+	case PLW_OPCODE_EQF:
+		PlwToC_FloatBinary(c, depth, "==", PlwTrue);
+		return;
+	case PLW_OPCODE_NEF:
+		PlwToC_FloatBinary(c, depth, "!=", PlwTrue);
+		return;
+	case PLW_OPCODE_NEGF:
+		c->usesStack = PlwTrue;
+		c->usesFloat = PlwTrue;
+		fprintf(c->out, "\tw1.i = stack[base + %ld];\n", depth - 1);
+		fprintf(c->out, "\tw1.f = -w1.f;\n");
+		fprintf(c->out, "\tstack[base + %ld] = w1.i;\n", depth - 1);
+		return;
+	case PLW_OPCODE_JZ:
+	case PLW_OPCODE_JNZ:
+		c->usesStack = PlwTrue;
+		fprintf(c->out, "\tif (stack[base + %ld] %s 0) {\n", depth - 1, instruction->opcode == PLW_OPCODE_JZ ? "==" : "!=");
+		PlwToC_Goto(c, "\t\t", instruction->arg1, depth - 1);
+		fprintf(c->out, "\t}\n");
+		return;
+	case PLW_OPCODE_JMP:
+		PlwToC_Goto(c, "\t", instruction->arg1, depth);
+		return;
+	case PLW_OPCODE_PUSH:
+		PlwToC_Push(c, depth, instruction->arg1);
+		return;
+	case PLW_OPCODE_PUSHF:
+		w.f = c->cb->floatConsts[instruction->arg1];
+		PlwToC_Push(c, depth, w.i);
+		return;
+	case PLW_OPCODE_PUSH_LOCAL:
+	case PLW_OPCODE_PUSH_GLOBAL:
+	case PLW_OPCODE_PUSH_LOCAL_MOVE:
+	case PLW_OPCODE_PUSH_GLOBAL_MOVE:
+	case PLW_OPCODE_PUSH_LOCAL_BORROW:
+	case PLW_OPCODE_PUSH_GLOBAL_BORROW:
+		PlwToC_PushSlot(c, index, instruction->opcode, instruction->arg1, depth);
+		return;
+	case PLW_OPCODE_PUSH_LOCAL_PUSH_LOCAL:
+		PlwToC_PushSlot(c, index, PLW_OPCODE_PUSH_LOCAL, instruction->arg1, depth);
+		PlwToC_PushSlot(c, index, PLW_OPCODE_PUSH_LOCAL, instruction->arg2, depth + 1);
+		return;
+	case PLW_OPCODE_PUSH_GLOBAL_PUSH_GLOBAL:
+		PlwToC_PushSlot(c, index, PLW_OPCODE_PUSH_GLOBAL, instruction->arg1, depth);
+		PlwToC_PushSlot(c, index, PLW_OPCODE_PUSH_GLOBAL, instruction->arg2, depth + 1);
+		return;
+	case PLW_OPCODE_POP_LOCAL:
+		PlwToC_PopSlot(c, index, PlwTrue);
+		return;
+	case PLW_OPCODE_POP_GLOBAL:
+		PlwToC_PopSlot(c, index, PlwFalse);
+		return;
+	case PLW_OPCODE_INC_LOCAL:
+		PlwToC_IncLocal(c, index);
+		return;
+	case PLW_OPCODE_JGT_LOCAL_LOCAL:
+		PlwToC_JumpLocalLocal(c, index, ">");
+		return;
+	case PLW_OPCODE_JLT_LOCAL_LOCAL:
+		PlwToC_JumpLocalLocal(c, index, "<");
+		return;
+	case PLW_OPCODE_ADD_CONST:
+		c->usesStack = PlwTrue;
+		fprintf(c->out, "\tstack[base + %ld] += ", depth - 1);
+		PlwToC_Int(c->out, instruction->arg1);
+		fprintf(c->out, ";\n");
+		return;
+	case PLW_OPCODE_EQ_CONST:
+		c->usesStack = PlwTrue;
+		fprintf(c->out, "\tstack[base + %ld] = stack[base + %ld] == ", depth - 1, depth - 1);
+		PlwToC_Int(c->out, instruction->arg1);
+		fprintf(c->out, ";\n");
+		return;
+	}
+	PlwToC_InstructionHandler(c, "\t", index);
+}
+
+static PlwBoolean PlwToC_FallsThrough(const PlwToC *c, PlwInt index) {
+	const PlwInstruction *instruction = &c->cb->instructions[index];
+	if (instruction->opcode == PLW_OPCODE_JMP || c->depthsAfter[index] == -1) {
+		return PlwFalse;
+	}
+	return !PlwStackMachine_OpcodeHandlers[instruction->opcode].isTransfer
+		|| instruction->opcode == PLW_OPCODE_DIV
+		|| instruction->opcode == PLW_OPCODE_REM;
+}
+
+/* the body goes to a temporary file first, to declare only the variables it uses */
+static void PlwToC_CodeBlock(FILE *out, const PlwCodeBlock *cb, PlwInt codeBlockId, const PlwInt *depths, const PlwInt *depthsAfter, PlwBoolean *isEntry, PlwBoolean *isLabel, PlwError *error) {
+	PlwToC c;
+	FILE *body;
+	const PlwInstruction *instruction;
+	PlwInt count = cb->instructionCount;
+	PlwInt i;
+	int ch;
+
+	body = tmpfile();
+	if (body == NULL) {
+		PlwToCError_File(error, "tmpfile");
+		return;
+	}
+	c.out = body;
+	c.cb = cb;
+	c.depths = depths;
+	c.depthsAfter = depthsAfter;
+	c.usesStack = PlwFalse;
+	c.usesBp = PlwFalse;
+	c.usesFloat = PlwFalse;
+	PlwToC_FindLabels(&c, isEntry, isLabel);
+
+	fprintf(body, "\tswitch (sm->ip) {\n");
+	for (i = 0; i < count; i++) {
+		if (isEntry[i]) {
+			fprintf(body, "\tcase %ld:\n\t\tbase = sm->sp - %ld;\n\t\tgoto i%ld;\n", i, depths[i], i);
+		}
+	}
+	fprintf(body, "\tdefault:\n\t\tPlwAot_InvalidEntry(sm, error);\n\t\treturn;\n\t}\n");
+	for (i = 0; i < count; i++) {
+		if (depths[i] == -1) {
+			continue;
+		}
+		if (isLabel[i]) {
+			fprintf(body, "i%ld:\n", i);
+		}
+		instruction = &cb->instructions[i];
+		fprintf(body, "\t/* %s", PlwOpcodes[instruction->opcode]);
+		if (PlwToC_ArgCount(instruction->opcode) >= 1) {
+			fprintf(body, " %ld", instruction->arg1);
+		}
+		if (PlwToC_ArgCount(instruction->opcode) >= 2) {
+			fprintf(body, " %ld", instruction->arg2);
+		}
+		if (PlwToC_ArgCount(instruction->opcode) >= 3) {
+			fprintf(body, " %ld", instruction->arg3);
+		}
+		fprintf(body, " */\n");
+		PlwToC_Instruction(&c, i);
+		if (i + 1 == count && PlwToC_FallsThrough(&c, i)) {
+			PlwToC_Goto(&c, "\t", count, depthsAfter[i]);
+		}
+	}
+
+	fprintf(out, "static void PlwAot_CodeBlock%ld(PlwStackMachine *sm, PlwError *error) {\n", codeBlockId);
+	/* the generated code relies on the stack never being reallocated, so these copies stay valid across calls */
+	if (c.usesStack) {
+		fprintf(out, "\tPlwInt *stack = sm->stack;\n\tPlwBoolean *stackMap = sm->stackMap;\n");
+	}
+	if (c.usesBp) {
+		fprintf(out, "\tPlwInt bp = sm->bp;\n");
+	}
+	if (count > 0) {
+		fprintf(out, "\tPlwInt base;\n");
+	}
+	if (c.usesFloat) {
+		fprintf(out, "\tPlwWord w1, w2;\n");
+	}
+	fprintf(out, "\n");
+	rewind(body);
+	while ((ch = fgetc(body)) != EOF) {
+		fputc(ch, out);
+	}
+	fprintf(out, "}\n\n");
+	if (ferror(body)) {
+		PlwToCError_File(error, "tmpfile");
+	}
+	fclose(body);
+}
+
+static void PlwToC_CodeBlocks(FILE *out, PlwCodeBlock *codeBlocks, PlwInt codeBlockCount, PlwInt codeBlockId, PlwError *error) {
+	const PlwCodeBlock *cb;
+	PlwInt *depths;
+	PlwInt *depthsAfter;
+	PlwBoolean *isEntry;
+	PlwBoolean *isLabel;
+	PlwInt i;
+
+	fprintf(out, "/* Translated from plwc by plw2c */\n\n#include \"PlwAot.h\"\n\n");
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwToC_Data(out, &codeBlocks[i], i);
+	}
+	/* every block is decoded, for its resultCount, before one is verified */
+	for (i = 0; i < codeBlockCount; i++) {
+		cb = &codeBlocks[i];
+		depths = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwInt), error);
+		if (PlwIsError(error)) {
+			return;
+		}
+		depthsAfter = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwInt), error);
+		if (PlwIsError(error)) {
+			PlwFree(depths);
+			return;
+		}
+		isEntry = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwBoolean), error);
+		if (PlwIsError(error)) {
+			PlwFree(depthsAfter);
+			PlwFree(depths);
+			return;
+		}
+		isLabel = PlwAlloc((cb->instructionCount + 1) * sizeof(PlwBoolean), error);
+		if (PlwIsError(error)) {
+			PlwFree(isEntry);
+			PlwFree(depthsAfter);
+			PlwFree(depths);
+			return;
+		}
+		PlwCodeBlock_Verify(&codeBlocks[i], codeBlocks, PlwNativeFunctionArgCounts, PlwNativeFunctionResultCounts, depths, depthsAfter, error);
+		if (!PlwIsError(error)) {
+			PlwToC_CodeBlock(out, cb, i, depths, depthsAfter, isEntry, isLabel, error);
+		}
+		PlwFree(isLabel);
+		PlwFree(isEntry);
+		PlwFree(depthsAfter);
+		PlwFree(depths);
+		if (PlwIsError(error)) {
+			return;
+		}
+	}
+	if (codeBlockCount == 0) {
+		fprintf(out, "int main(void) {\n\treturn PlwAot_Main(0, 0, NULL, NULL);\n}\n");
+		return;
+	}
+	fprintf(out, "static const PlwAotCodeBlock PlwAot_CodeBlocks[] = {\n");
+	for (i = 0; i < codeBlockCount; i++) {
+		cb = &codeBlocks[i];
+		fprintf(out, "\t{");
+		if (PlwToC_IsLongString(cb->name)) {
+			fprintf(out, "PlwAot_Name%ld_0", i);
+		} else {
+			PlwToC_String(out, cb->name);
+		}
+		fprintf(out, ", %ld, ", cb->codeCount);
+		if (cb->codeCount > 0) {
+			fprintf(out, "PlwAot_Codes%ld, ", i);
+		} else {
+			fprintf(out, "NULL, ");
+		}
+		fprintf(out, "%ld, ", cb->strConstCount);
+		if (cb->strConstCount > 0) {
+			fprintf(out, "PlwAot_StrConsts%ld, ", i);
+		} else {
+			fprintf(out, "NULL, ");
+		}
+		fprintf(out, "%ld, ", cb->floatConstCount);
+		if (cb->floatConstCount > 0) {
+			fprintf(out, "PlwAot_FloatConsts%ld}", i);
+		} else {
+			fprintf(out, "NULL}");
+		}
+		fprintf(out, i + 1 < codeBlockCount ? ",\n" : "\n");
+	}
+	fprintf(out, "};\n\n");
+	fprintf(out, "static const PlwCompiledCodeBlock PlwAot_CompiledCodeBlocks[] = {\n");
+	for (i = 0; i < codeBlockCount; i++) {
+		fprintf(out, i + 1 < codeBlockCount ? "\tPlwAot_CodeBlock%ld,\n" : "\tPlwAot_CodeBlock%ld\n", i);
+	}
+	fprintf(out, "};\n\n");
+	fprintf(out, "int main(void) {\n\treturn PlwAot_Main(%ld, %ld, PlwAot_CodeBlocks, PlwAot_CompiledCodeBlocks);\n}\n", codeBlockCount, codeBlockId);
+}
+
+int main(int argc, char **argv) {
+	PlwError error;
+	PlwCodeBlock *codeBlocks;
+	PlwInt codeBlockCount;
+	PlwInt codeBlockId;
+	FILE *out;
+	PlwInt i;
+
+	if (argc != 3) {
+		printf("Usage: plw2c <file.plwc> <file.c>\n");
+		return -1;
+	}
+
+	PlwError_Init(&error);
+
+	PlwReadCodeBlocksFromFile(argv[1], &codeBlocks, &codeBlockCount, &codeBlockId, &error);
+	if (PlwIsError(&error)) {
+		PlwPrintError(&error);
+		return -1;
+	}
+
+	for (i = 0; i < codeBlockCount; i++) {
+		PlwCodeBlock_Decode(&codeBlocks[i], codeBlockCount, PlwNativeFunctionCount, &error);
+		if (PlwIsError(&error)) {
+			PlwPrintError(&error);
+			PlwFreeCodeBlocks(codeBlocks, codeBlockCount);
+			return -1;
+		}
+	}
+
+	out = fopen(argv[2], "w");
+	if (out == NULL) {
+		PlwToCError_File(&error, argv[2]);
+		PlwPrintError(&error);
+		PlwFreeCodeBlocks(codeBlocks, codeBlockCount);
+		return -1;
+	}
+	PlwToC_CodeBlocks(out, codeBlocks, codeBlockCount, codeBlockId, &error);
+	if (!PlwIsError(&error) && ferror(out)) {
+		PlwToCError_File(&error, argv[2]);
+	}
+	if (fclose(out) != 0 && !PlwIsError(&error)) {
+		PlwToCError_File(&error, argv[2]);
+	}
+	PlwFreeCodeBlocks(codeBlocks, codeBlockCount);
+	if (PlwIsError(&error)) {
+		PlwPrintError(&error);
+		remove(argv[2]);
+		return -1;
+	}
+	return 0;
+}